@@ -18,13 +18,20 @@ HublinkBEAM beam;
 Hublink hublink(PIN_SD_CS);
 
 // default values, !! overriden by meta.json !!
-int LOG_EVERY_MINUTES = 10;         // Log every X minutes
-int SYNC_EVERY_MINUTES = 30;        // Sync every X minutes
-int SYNC_FOR_SECONDS = 30;          // Sync timeout in seconds
-bool NEW_FILE_ON_BOOT = true;       // Create new file on boot
-int INACTIVITY_PERIOD_SECONDS = 40; // Inactivity period in seconds
-int RANDOMIZE_ALARM_MINUTES = 0;    // Alarm randomization in minutes (0 = disabled)
-String DEVICE_ID = "XXX";           // Default device ID (3 characters)
+// RTC_DATA_ATTR keeps overrides across deep sleep on wakes that skip meta.json
+RTC_DATA_ATTR int LOG_EVERY_MINUTES = 10;         // Log every X minutes
+RTC_DATA_ATTR int SYNC_EVERY_MINUTES = 30;        // Sync every X minutes
+RTC_DATA_ATTR int SYNC_FOR_SECONDS = 30;          // Sync timeout in seconds
+RTC_DATA_ATTR bool NEW_FILE_ON_BOOT = true;       // Create new file on boot
+RTC_DATA_ATTR int INACTIVITY_PERIOD_SECONDS = 40; // Inactivity period in seconds
+RTC_DATA_ATTR int RANDOMIZE_ALARM_MINUTES = 0;    // Alarm randomization in minutes (0 = disabled)
+RTC_DATA_ATTR int ULP_SAMPLE_HZ = 0;              // ULP timer sampling rate in Hz (0 = continuous busy loop)
+RTC_DATA_ATTR int LOG_BATCH_SIZE = 1;             // Log records per SD write (1 = write every wake)
+RTC_DATA_ATTR bool LOG_BINARY = false;            // Write .bin files instead of .csv
+RTC_DATA_ATTR bool LOG_COMPRESS = false;          // Compress each day's file after midnight
+RTC_DATA_ATTR bool LIGHT_AUTO_RANGE = false;      // Pick the light sensor range per reading
+RTC_DATA_ATTR int LOG_MAX_MINUTES = 0;            // Stretch logging up to X minutes while quiet (0 = fixed)
+String DEVICE_ID = "XXX";                         // Default device ID (3 characters)
 
 // Hublink callback function to handle timestamp
 void onTimestampReceived(uint32_t timestamp)
@@ -45,7 +52,12 @@ void setup()
   beam.setNeoPixel(NEOPIXEL_OFF);
 
   // Load configuration from meta.json (continues even if Hublink fails)
-  beginHublink(); // reads meta.json and overrides default values if found
+  // With log batching, the SD card is only mounted on wakes that flush
+  if (!beam.isWakeFromSleep() || beam.isLogFlushDue())
+  {
+    beam.initSD();  // no-op unless begin() deferred the SD card
+    beginHublink(); // reads meta.json and overrides default values if found
+  }
 
   // Force Hublink sync on boot/reboot only (not on wake from deep sleep)
   // Switch B DOWN = "offline mode" - skips this sync to save power/time
@@ -61,8 +73,18 @@ void setup()
 
   beam.setInactivityPeriod(INACTIVITY_PERIOD_SECONDS); // 40 seconds; based on https://shorturl.at/JiZxK
   beam.setNewFileOnBoot(NEW_FILE_ON_BOOT);             // false to continue using same file if it's the same day
+  if (ULP_SAMPLE_HZ > 0)
+  {
+    beam.setULPSamplingMode(ULP_MODE_TIMER, ULP_SAMPLE_HZ); // ULP halts between samples
+  }
+  beam.setSleepSchedule(LOG_MAX_MINUTES > LOG_EVERY_MINUTES ? beamAdaptiveSleepSchedule(LOG_EVERY_MINUTES, LOG_MAX_MINUTES)
+                                                            : beamFixedSleepSchedule());
+  beam.setLightAutoRange(LIGHT_AUTO_RANGE);        // when on, the fixed settings below are ignored
   beam.setLightGain(VEML7700_GAIN_2);
   beam.setLightIntegrationTime(VEML7700_IT_800MS);
+  beam.setLogBatchSize(LOG_BATCH_SIZE);
+  beam.setLogFormat(LOG_BINARY ? LOG_FORMAT_BINARY : LOG_FORMAT_CSV);
+  beam.setLogCompression(LOG_COMPRESS);
   beam.logData();
 
   // Check if interval has passed (and set up alarm on first run)
@@ -70,6 +92,7 @@ void setup()
   {
     Serial.println("Alarm triggered!");
     // force sync (using meta.json beam settings)
+    beam.flushLog(); // make sure batched records are on the card first
     hublink.sync(SYNC_FOR_SECONDS);
   }
 
@@ -81,7 +104,7 @@ void setup()
    * will restart after deep sleep, returning to setup(); nothing beyond beam.sleep()
    * will be executed.
    */
-  beam.sleep(LOG_EVERY_MINUTES); // Sleep for LOG_EVERY_MINUTES minutes
+  beam.sleep(LOG_EVERY_MINUTES); // Sleep for LOG_EVERY_MINUTES minutes (or longer while quiet, see LOG_MAX_MINUTES)
 }
 
 // never enters loop()
@@ -127,6 +150,36 @@ void beginHublink()
       RANDOMIZE_ALARM_MINUTES = hublink.getMeta<int>("beam", "randomize_alarm_minutes");
       Serial.println("RANDOMIZE_ALARM_MINUTES: " + String(RANDOMIZE_ALARM_MINUTES));
     }
+    if (hublink.hasMetaKey("beam", "ulp_sample_hz"))
+    {
+      ULP_SAMPLE_HZ = hublink.getMeta<int>("beam", "ulp_sample_hz");
+      Serial.println("ULP_SAMPLE_HZ: " + String(ULP_SAMPLE_HZ));
+    }
+    if (hublink.hasMetaKey("beam", "log_batch_size"))
+    {
+      LOG_BATCH_SIZE = hublink.getMeta<int>("beam", "log_batch_size");
+      Serial.println("LOG_BATCH_SIZE: " + String(LOG_BATCH_SIZE));
+    }
+    if (hublink.hasMetaKey("beam", "log_format"))
+    {
+      LOG_BINARY = hublink.getMeta<String>("beam", "log_format") == "bin";
+      Serial.println("LOG_BINARY: " + String(LOG_BINARY));
+    }
+    if (hublink.hasMetaKey("beam", "log_compress"))
+    {
+      LOG_COMPRESS = hublink.getMeta<bool>("beam", "log_compress");
+      Serial.println("LOG_COMPRESS: " + String(LOG_COMPRESS));
+    }
+    if (hublink.hasMetaKey("beam", "light_auto_range"))
+    {
+      LIGHT_AUTO_RANGE = hublink.getMeta<bool>("beam", "light_auto_range");
+      Serial.println("LIGHT_AUTO_RANGE: " + String(LIGHT_AUTO_RANGE));
+    }
+    if (hublink.hasMetaKey("beam", "log_max_minutes"))
+    {
+      LOG_MAX_MINUTES = hublink.getMeta<int>("beam", "log_max_minutes");
+      Serial.println("LOG_MAX_MINUTES: " + String(LOG_MAX_MINUTES));
+    }
     if (hublink.hasMetaKey("device", "id"))
     {
       DEVICE_ID = hublink.getMeta<String>("device", "id");
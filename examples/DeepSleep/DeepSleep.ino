@@ -11,12 +11,14 @@
 #define LED_PIN GPIO_NUM_13
 #define LED_GPIO_INDEX 13
 
-// ULP program constants
-enum
-{
-    MOTION_FLAG, // RTC memory index for motion flag
-    PROG_START   // Program start address
-};
+// Shared ULP program builder and memory map (PIR_COUNT, PROG_START, ...)
+#include "ULPProgram.h"
+
+#define SAMPLE_HZ 40 // ULP timer wakeups per second
+
+// PIR counting only: events, inactivity and bout tracking are left out
+constexpr ULPProgramConfig DEEP_SLEEP_CONFIG = {25, 1000, 0};
+static constexpr auto deep_sleep_program = ulpBuildTimerProgram<DEEP_SLEEP_CONFIG>();
 
 // const ulp_insn_t ulp_program[] = {
 //     M_LABEL(1),
@@ -40,27 +42,6 @@ enum
 //     M_BX(1), // Jump back to label 1 to repeat
 // };
 
-// ULP program to monitor PIR trigger (GPIO3) for LOW state with optimized delay
-const ulp_insn_t ulp_program[] = {
-    I_MOVI(R2, MOTION_FLAG), // set R2 to motion flag address
-    I_LD(R3, R2, 0),         // Load current motion flag value into R3
-
-    M_LABEL(1),   // New label for consistent halt point
-    I_DELAY(438), // 25µs delay
-
-    // Read GPIO3 state into R0 (we can reuse R0 now)
-    I_RD_REG(RTC_GPIO_IN_REG, 3 + RTC_GPIO_IN_NEXT_S, 3 + RTC_GPIO_IN_NEXT_S),
-
-    // If GPIO is not LOW (no motion), skip the motion handling
-    M_BG(1, 0), // If R0 > 0 (HIGH), branch to label 1
-
-    // Motion detected (GPIO is LOW)
-    I_ADDI(R3, R3, 1), // Increment motion counter
-    I_ST(R3, R2, 0),   // Store updated counter
-
-    I_HALT(), // Always halt after one complete execution
-};
-
 Adafruit_NeoPixel pixel(1, PIN_NEOPIXEL, NEO_GRB + NEO_KHZ800);
 
 void setup()
@@ -68,8 +49,8 @@ void setup()
     ulp_timer_stop();
     Serial.begin(115200);
     delay(1000);
-    int motionValue = RTC_SLOW_MEM[MOTION_FLAG];
-    Serial.println("Motion flag value: " + String(motionValue));
+    int motionValue = RTC_SLOW_MEM[PIR_COUNT] & 0xFFFF;
+    Serial.println("Motion windows: " + String(motionValue));
 
     // Initialize NeoPixel pins
     pinMode(NEOPIXEL_POWER, OUTPUT);
@@ -98,15 +79,16 @@ void setup()
     rtc_gpio_set_direction((gpio_num_t)LED_PIN, RTC_GPIO_MODE_OUTPUT_ONLY);
 
     // Load and start ULP program
-    size_t size = sizeof(ulp_program) / sizeof(ulp_insn_t);
-    esp_err_t err = ulp_process_macros_and_load(PROG_START, ulp_program, &size);
+    RTC_SLOW_MEM[SAMPLES_PER_WINDOW] = SAMPLE_HZ;
+    size_t size = deep_sleep_program.insns.size();
+    esp_err_t err = ulp_process_macros_and_load(PROG_START, deep_sleep_program.insns.data(), &size);
     if (err != ESP_OK)
     {
         return;
     }
 
-    // Configure ULP to wake up every 1s
-    // ulp_set_wakeup_period(0, 1000000);
+    // One GPIO3 sample per ULP timer wakeup
+    ulp_set_wakeup_period(0, 1000000 / SAMPLE_HZ);
 
     err = ulp_run(PROG_START);
     if (err != ESP_OK)
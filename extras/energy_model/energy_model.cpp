@@ -0,0 +1,304 @@
+/*
+ * Host-side energy model and battery-life estimator for BEAM deployments
+ *
+ * Runs the device's energy model (src/BEAMEnergy.h) on a configuration:
+ * sleep minutes, Hublink sync interval and length, ULP sampling mode and
+ * log batch size. Phase durations are typical values unless a wake profile
+ * file from the device is given (beam.setWakeProfiling(true)), in which
+ * case the mean of its timer-wake rows is used. Sleep currents default to
+ * the ULP-Power.xlsx measurements; awake currents are typical values, so
+ * override them with measured ones where available.
+ *
+ * Build (from this directory):
+ *   g++ -std=c++17 -O2 -I../../src -o energy_model energy_model.cpp
+ *
+ * Usage:
+ *   ./energy_model [options]
+ *     --sleep MIN          beam.sleep() minutes (default 10, or the profile's)
+ *     --sync-every MIN     Hublink sync interval (default 0 = no sync)
+ *     --sync-seconds S     length of one sync (default 30)
+ *     --ulp continuous|timer  ULP sampling mode (default continuous)
+ *     --batch N            log records per SD flush (default 1)
+ *     --battery MAH        battery capacity (default 2000)
+ *     --usable FRACTION    share of capacity used before cutoff (default 0.8)
+ *     --profile FILE       <logfile>_profile.csv from the device
+ *     --cpu-ma X           awake current, SD card off
+ *     --sd-ma X            awake current, SD card busy
+ *     --light-sleep-ma X   light sleep while sensors convert
+ *     --sync-ma X          current during a sync
+ *     --sleep-ua X         deep sleep current of the selected ULP mode
+ *     --table              also project days for a range of sleep intervals
+ *   With --profile, batching and any syncs are already in the measured rows:
+ *   --batch is ignored and a sync's time counts in other_us at the awake
+ *   current unless --sync-every is given.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "BEAMEnergy.h"
+
+// Mean of the timer-wake rows (wake > 0) of a profile file; boot rows carry
+// one-off costs such as PIR stabilization
+static bool readProfile(const char *path, BEAMWakeProfile &mean, size_t &rows)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        fprintf(stderr, "error: cannot open %s\n", path);
+        return false;
+    }
+
+    char line[1024];
+    if (!fgets(line, sizeof(line), f))
+    {
+        fprintf(stderr, "error: %s is empty\n", path);
+        fclose(f);
+        return false;
+    }
+
+    // Column index -> field: -1 ignored, -2 wake, -3 sleep_s, -4 awake_us, else phase
+    int fields[64];
+    int columns = 0;
+    bool hasAwake = false;
+    for (char *name = strtok(line, ",\r\n"); name && columns < 64; name = strtok(NULL, ",\r\n"))
+    {
+        int field = -1;
+        if (!strcmp(name, "wake"))
+            field = -2;
+        else if (!strcmp(name, "sleep_s"))
+            field = -3;
+        else if (!strcmp(name, "awake_us"))
+            field = -4, hasAwake = true;
+        for (int phase = 0; phase < BEAM_PHASE_COUNT; phase++)
+        {
+            size_t length = strlen(BEAM_PHASE_NAMES[phase]);
+            if (!strncmp(name, BEAM_PHASE_NAMES[phase], length) && !strcmp(name + length, "_us"))
+                field = phase;
+        }
+        fields[columns++] = field;
+    }
+    if (!hasAwake)
+    {
+        fprintf(stderr, "error: %s is not a wake profile file\n", path);
+        fclose(f);
+        return false;
+    }
+
+    double sums[BEAM_PHASE_COUNT + 2] = {0}; // phases, sleep, awake
+    rows = 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        double values[64] = {0};
+        int column = 0;
+        for (char *value = strtok(line, ",\r\n"); value && column < columns; value = strtok(NULL, ",\r\n"))
+        {
+            values[column++] = atof(value);
+        }
+        bool timerWake = false;
+        for (int c = 0; c < column; c++)
+        {
+            timerWake |= fields[c] == -2 && values[c] > 0;
+        }
+        if (!timerWake)
+        {
+            continue;
+        }
+        for (int c = 0; c < column; c++)
+        {
+            if (fields[c] >= 0)
+                sums[fields[c]] += values[c];
+            else if (fields[c] == -3)
+                sums[BEAM_PHASE_COUNT] += values[c];
+            else if (fields[c] == -4)
+                sums[BEAM_PHASE_COUNT + 1] += values[c];
+        }
+        rows++;
+    }
+    fclose(f);
+
+    if (rows == 0)
+    {
+        fprintf(stderr, "error: %s has no timer-wake rows\n", path);
+        return false;
+    }
+    mean = {};
+    for (int phase = 0; phase < BEAM_PHASE_COUNT; phase++)
+    {
+        mean.phaseMicros[phase] = (uint32_t)(sums[phase] / rows + 0.5);
+    }
+    mean.sleepSeconds = (uint32_t)(sums[BEAM_PHASE_COUNT] / rows + 0.5);
+    mean.awakeMicros = (uint32_t)(sums[BEAM_PHASE_COUNT + 1] / rows + 0.5);
+    return true;
+}
+
+static void printEstimate(const BEAMWakeProfile &profile, const BEAMEnergyConfig &config,
+                          const BEAMEnergyCurrents &currents)
+{
+    BEAMEnergyEstimate estimate = beamEstimateEnergy(profile, config, currents);
+    printf("\n%-16s %10s %10s %10s\n", "phase", "ms", "mA", "uAh");
+    uint32_t accounted = 0;
+    for (int phase = 0; phase < BEAM_PHASE_COUNT; phase++)
+    {
+        float share = beamIsSDPhase(phase) ? config.sdShare : 1.0f;
+        float micros = profile.phaseMicros[phase] * share;
+        accounted += profile.phaseMicros[phase];
+        if (micros > 0)
+        {
+            printf("%-16s %10.1f %10.1f %10.2f\n", BEAM_PHASE_NAMES[phase], micros / 1000.0f,
+                   currents.phaseMA[phase], beamChargeUAh(micros, currents.phaseMA[phase]));
+        }
+    }
+    if (profile.awakeMicros > accounted)
+    {
+        uint32_t other = profile.awakeMicros - accounted;
+        printf("%-16s %10.1f %10.1f %10.2f\n", "other", other / 1000.0f, currents.otherMA,
+               beamChargeUAh(other, currents.otherMA));
+    }
+
+    float sleepUA = config.ulpTimerMode ? currents.sleepTimerUA : currents.sleepContinuousUA;
+    printf("\nper cycle         %.1f s: awake %.2f uAh, sync %.2f uAh, sleep %.2f uAh (%.0f uA), total %.2f uAh\n",
+           estimate.cycleSeconds, estimate.awakeUAh, estimate.syncUAh, estimate.sleepUAh, sleepUA,
+           estimate.cycleUAh);
+    printf("average current   %.1f uA\n", estimate.averageUA);
+    printf("projected runtime %.1f days on %.0f mAh (%.0f%% usable)\n", estimate.days, config.batteryMAh,
+           config.usableFraction * 100.0f);
+}
+
+int main(int argc, char **argv)
+{
+    BEAMEnergyConfig config = beamDefaultEnergyConfig(10);
+    BEAMEnergyCurrents currents = beamDefaultCurrents();
+    config.syncSeconds = 30;
+    const char *profilePath = NULL;
+    int sleepMinutes = -1;
+    int batch = 1;
+    bool syncGiven = false;
+    float sleepUA = -1;
+    bool table = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--sleep") && hasValue)
+            sleepMinutes = atoi(argv[++i]);
+        else if (!strcmp(arg, "--sync-every") && hasValue)
+            config.syncEveryMinutes = atoi(argv[++i]), syncGiven = true;
+        else if (!strcmp(arg, "--sync-seconds") && hasValue)
+            config.syncSeconds = atoi(argv[++i]);
+        else if (!strcmp(arg, "--ulp") && hasValue)
+            config.ulpTimerMode = !strcmp(argv[++i], "timer");
+        else if (!strcmp(arg, "--batch") && hasValue)
+            batch = atoi(argv[++i]);
+        else if (!strcmp(arg, "--battery") && hasValue)
+            config.batteryMAh = atof(argv[++i]);
+        else if (!strcmp(arg, "--usable") && hasValue)
+            config.usableFraction = atof(argv[++i]);
+        else if (!strcmp(arg, "--profile") && hasValue)
+            profilePath = argv[++i];
+        else if (!strcmp(arg, "--cpu-ma") && hasValue)
+        {
+            float ma = atof(argv[++i]);
+            for (int phase = 0; phase < BEAM_PHASE_COUNT; phase++)
+            {
+                if (!beamIsSDPhase(phase) && phase != BEAM_PHASE_SENSOR_WAIT)
+                    currents.phaseMA[phase] = ma;
+            }
+            currents.otherMA = ma;
+        }
+        else if (!strcmp(arg, "--sd-ma") && hasValue)
+        {
+            float ma = atof(argv[++i]);
+            for (int phase = 0; phase < BEAM_PHASE_COUNT; phase++)
+            {
+                if (beamIsSDPhase(phase))
+                    currents.phaseMA[phase] = ma;
+            }
+        }
+        else if (!strcmp(arg, "--light-sleep-ma") && hasValue)
+            currents.phaseMA[BEAM_PHASE_SENSOR_WAIT] = atof(argv[++i]);
+        else if (!strcmp(arg, "--sync-ma") && hasValue)
+            currents.syncMA = atof(argv[++i]);
+        else if (!strcmp(arg, "--sleep-ua") && hasValue)
+            sleepUA = atof(argv[++i]);
+        else if (!strcmp(arg, "--table"))
+            table = true;
+        else
+        {
+            fprintf(stderr, "usage: %s [--sleep MIN] [--sync-every MIN] [--sync-seconds S] [--ulp continuous|timer]\n"
+                            "       [--batch N] [--battery MAH] [--usable FRACTION] [--profile FILE]\n"
+                            "       [--cpu-ma X] [--sd-ma X] [--light-sleep-ma X] [--sync-ma X] [--sleep-ua X] [--table]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (batch < 1 || config.batteryMAh <= 0 || config.usableFraction <= 0 || config.usableFraction > 1)
+    {
+        fprintf(stderr, "error: batch must be at least 1, battery positive and usable in (0, 1]\n");
+        return 2;
+    }
+    if (sleepUA >= 0)
+    {
+        (config.ulpTimerMode ? currents.sleepTimerUA : currents.sleepContinuousUA) = sleepUA;
+    }
+
+    BEAMWakeProfile profile = beamTypicalWakeProfile();
+    if (profilePath)
+    {
+        size_t rows = 0;
+        if (!readProfile(profilePath, profile, rows))
+        {
+            return 1;
+        }
+        printf("profile           %s: mean of %zu timer wakes, %.1f ms awake, sleep %lu s\n", profilePath, rows,
+               profile.awakeMicros / 1000.0f, (unsigned long)profile.sleepSeconds);
+        config.sdShare = 1.0f; // batching is in the measured rows
+        if (!syncGiven)
+        {
+            config.syncEveryMinutes = 0; // as are syncs, in other_us
+        }
+    }
+    else
+    {
+        printf("profile           typical flush wake, %.1f ms awake\n", profile.awakeMicros / 1000.0f);
+        config.sdShare = 1.0f / batch;
+    }
+    if (sleepMinutes >= 0 || !profilePath)
+    {
+        config.sleepSeconds = (sleepMinutes >= 0 ? sleepMinutes : 10) * 60;
+    }
+    else
+    {
+        config.sleepSeconds = profile.sleepSeconds;
+    }
+
+    char batchText[16];
+    snprintf(batchText, sizeof(batchText), profilePath ? "as measured" : "%d", batch);
+    printf("config            sleep %lu min, ULP %s, batch %s, sync %s\n",
+           (unsigned long)(config.sleepSeconds / 60), config.ulpTimerMode ? "timer" : "continuous",
+           batchText, config.syncEveryMinutes ? "on" : "off");
+    if (config.syncEveryMinutes)
+    {
+        printf("                  sync %lu s every %lu min at %.0f mA\n", (unsigned long)config.syncSeconds,
+               (unsigned long)config.syncEveryMinutes, currents.syncMA);
+    }
+    printEstimate(profile, config, currents);
+
+    if (table)
+    {
+        const int minutes[] = {1, 2, 5, 10, 15, 30, 60};
+        printf("\n%-12s %14s %14s\n", "sleep (min)", "continuous (d)", "timer (d)");
+        for (int m : minutes)
+        {
+            BEAMEnergyConfig row = config;
+            row.sleepSeconds = m * 60;
+            row.ulpTimerMode = false;
+            float continuous = beamEstimateEnergy(profile, row, currents).days;
+            row.ulpTimerMode = true;
+            float timer = beamEstimateEnergy(profile, row, currents).days;
+            printf("%-12d %14.1f %14.1f\n", m, continuous, timer);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,421 @@
+/*
+ * Host-side microbenchmark for the CSV row formatter
+ *
+ * Compares beamFormatCSVRow() (src/LogFormat.h, integer/fixed-point text
+ * without printf) with the snprintf() row it replaced, on representative
+ * BEAM rows. Before timing, it checks that both produce identical bytes for
+ * every row; per integer format, for every 16-bit value plus random and
+ * edge-case 32-bit values; per float column, for millions of readings
+ * against snprintf() of the raw float, including the floats nearest every
+ * rounding tie; and for the two percent columns, which hold doubles, for
+ * every ratio of small integers over 0-100% and the doubles nearest every
+ * tie. The same readings are checked through a binary record,
+ * whose decoded digits must match. Absolute times are for the host; the ratio is
+ * what carries over to the device, where newlib's float formatting is
+ * relatively slower still.
+ *
+ * Build (from this directory):
+ *   g++ -std=c++17 -O2 -I../../src -o format_bench format_bench.cpp
+ *
+ * Usage:
+ *   ./format_bench [--rows N] [--seconds S]
+ *     --rows N      distinct rows to format (default 1440, a day of minutes)
+ *     --seconds S   time spent on each formatter (default 0.5)
+ *   Exit status is 1 if any output differs.
+ */
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "LogFormat.h"
+
+static_assert(BEAM_LOG_COLUMNS == BEAM_LOG_ALL_COLUMNS, "the reference row has every column");
+
+// The row as formatted before the fast formatter: one snprintf() of the
+// record's raw readings, as logData() did
+static int referenceRow(const LogRecord &r, uint32_t sequence, const char *deviceID, const char *libraryVersion,
+                        char *buffer, size_t size)
+{
+    int year, month, day, hour, minute, second;
+    beamCivilTime(r.timestamp, year, month, day, hour, minute, second);
+    bool light = r.lightSetting != BEAM_LIGHT_SETTING_NONE;
+    uint16_t config = beamVEML7700SettingConfig(r.lightSetting);
+    int length = snprintf(buffer, size,
+                          "%04d-%02d-%02d %02d:%02d:%02d,%lu,%s,%s,%.3f,%.2f,%.2f,%.2f,%.4f,%u,%.3f,%u,%u,%.3f,%lu,%u,%u,%u,%u,%u,%u,%u,%.3f,%u,%u,%lu,%lu,",
+                          year, month, day, hour, minute, second,
+                          (unsigned long)r.millis,
+                          deviceID,
+                          libraryVersion,
+                          r.batteryVoltage,
+                          r.temperatureC,
+                          r.pressureHpa,
+                          r.humidityPercent,
+                          r.lux,
+                          (unsigned)r.activityCount,
+                          r.activityPercent,
+                          (unsigned)r.inactivityPeriods[0],
+                          (unsigned)r.inactivityCounts[0],
+                          r.inactivityPercent,
+                          (unsigned long)r.minFreeHeap,
+                          (unsigned)r.reboot,
+                          (unsigned)r.inactivityPeriods[1],
+                          (unsigned)r.inactivityCounts[1],
+                          (unsigned)r.inactivityPeriods[2],
+                          (unsigned)r.inactivityCounts[2],
+                          (unsigned)r.longestInactive,
+                          (unsigned)r.inactiveBouts,
+                          light ? beamVEML7700Gain(config) : 0.0f,
+                          light ? (unsigned)beamVEML7700IntegrationMs(config) : 0u,
+                          (unsigned)r.powerLevel,
+                          (unsigned long)r.sleepSeconds,
+                          (unsigned long)sequence);
+    if (length < 0 || (size_t)length + BEAM_LOG_CRC_DIGITS >= size)
+    {
+        return -1;
+    }
+    return length + snprintf(buffer + length, size - length, "%08lx",
+                             (unsigned long)beamCRC32(buffer, length));
+}
+
+// A day of one-minute wakes with plausible sensor values, plus the failed
+// sensor markers and a NaN reading now and then
+static std::vector<LogRecord> makeRows(size_t count)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    std::vector<LogRecord> rows;
+    for (size_t i = 0; i < count; i++)
+    {
+        bool failed = i % 97 == 0;
+        float daylight = (i % 1440 > 420 && i % 1440 < 1140) ? 1.0f : 0.0f;
+        LogRecord r = {};
+        r.timestamp = 1735689600 + i * 60;
+        r.millis = 1800 + rng() % 900;
+        r.minFreeHeap = 228000 + rng() % 4000;
+        r.batteryVoltage = i % 211 == 0 ? NAN : 4.15f - i * 0.00005f + noise(rng) * 0.004f;
+        r.temperatureC = failed ? -273.15f : 21.5f + noise(rng) * 3.0f;
+        r.pressureHpa = failed ? -1.0f : 1009.0f + noise(rng) * 6.0f;
+        r.humidityPercent = failed ? -1.0f : 48.0f + noise(rng) * 12.0f;
+        r.lux = daylight * (250.0f + noise(rng) * 200.0f) + 0.0625f * (rng() % 8);
+        r.activityCount = rng() % 4 ? rng() % 40 : 0;
+        r.activityPercent = (rng() % 61) / 60.0; // PIR-active seconds of a minute
+        r.inactivityPercent = (rng() % 61) / 60.0;
+        r.inactivityPeriods[0] = 30;
+        r.inactivityCounts[0] = rng() % 3;
+        r.inactivityPeriods[1] = 120;
+        r.inactivityCounts[1] = rng() % 2;
+        r.longestInactive = rng() % 61;
+        r.inactiveBouts = rng() % 5;
+        r.reboot = i == 0;
+        r.lightSetting = failed ? BEAM_LIGHT_SETTING_NONE
+                                : beamVEML7700Setting(beamVEML7700RangeConfig(daylight > 0 ? 2 : 8));
+        r.powerLevel = i > 1200 ? 1 : 0;
+        r.sleepSeconds = i == 0 ? 0 : 60;
+        rows.push_back(r);
+    }
+    return rows;
+}
+
+static size_t checkFixed(int64_t value, uint8_t decimals)
+{
+    char expected[32];
+    char actual[32];
+    snprintf(expected, sizeof(expected), "%.*f", decimals, value / beamPow10(decimals));
+    actual[beamWriteFixed(actual, value, decimals)] = '\0';
+    if (strcmp(expected, actual) != 0)
+    {
+        fprintf(stderr, "mismatch: %lld with %u decimals: snprintf \"%s\", fast \"%s\"\n",
+                (long long)value, decimals, expected, actual);
+        return 1;
+    }
+    return 0;
+}
+
+// One reading in a column: the CSV text against snprintf() of the raw value,
+// and the binary record's stored integer against the same digits. Readings
+// of the float columns must be floats.
+static size_t checkFloat(int id, double value)
+{
+    const BEAMLogColumn &column = BEAM_LOG_SCHEMA[id];
+    LogRecord r = {};
+    switch (id)
+    {
+    case BEAM_COL_BATTERY_VOLTAGE: r.batteryVoltage = value; break;
+    case BEAM_COL_TEMPERATURE: r.temperatureC = value; break;
+    case BEAM_COL_PRESSURE: r.pressureHpa = value; break;
+    case BEAM_COL_HUMIDITY: r.humidityPercent = value; break;
+    case BEAM_COL_LUX: r.lux = value; break;
+    case BEAM_COL_ACTIVITY_PERCENT: r.activityPercent = value; break;
+    default: r.inactivityPercent = value; break;
+    }
+    if (isfinite(value) && !beamFloatInRange(column, value))
+    {
+        return 0; // printed as stored, outside what snprintf could fit in the row
+    }
+
+    char expected[64];
+    char actual[64];
+    snprintf(expected, sizeof(expected), "%.*f", column.decimals, value);
+    int length = beamFormatColumn(column, id, r, 0, NULL, actual, sizeof(actual));
+    size_t mismatches = 0;
+    if (length < 0 || strcmp(expected, actual) != 0)
+    {
+        fprintf(stderr, "mismatch: %s %.9g: snprintf \"%s\", fast \"%s\"\n", column.name, value, expected, actual);
+        mismatches++;
+    }
+
+    // Decoded from a binary record: the same digits, less the sign of -0
+    if (isfinite(value))
+    {
+        uint8_t field[4];
+        char decoded[64];
+        beamStoreField(field, column.size, beamFixed(value, id));
+        beamFormatField(column, field, NULL, decoded, sizeof(decoded));
+        const char *text = expected;
+        if (text[0] == '-' && strspn(text + 1, "0.") == strlen(text + 1))
+        {
+            text++;
+        }
+        if (strcmp(text, decoded) != 0)
+        {
+            fprintf(stderr, "mismatch: %s %.9g: snprintf \"%s\", decoded \"%s\"\n", column.name, value, expected,
+                    decoded);
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static const int floatColumns[] = {BEAM_COL_BATTERY_VOLTAGE, BEAM_COL_TEMPERATURE, BEAM_COL_PRESSURE,
+                                   BEAM_COL_HUMIDITY, BEAM_COL_LUX, BEAM_COL_ACTIVITY_PERCENT,
+                                   BEAM_COL_INACTIVITY_PERCENT};
+
+// Every float column: edge cases, the floats nearest each rounding tie
+// around the sensors' ranges, and 1M random readings over each column's
+// range plus 1M random bit patterns
+static size_t checkFloats(size_t *checked)
+{
+    size_t mismatches = 0;
+    size_t count = 0;
+    std::mt19937 rng(11);
+    const float edges[] = {0.0f, -0.0f, 1.0f, -1.0f, -273.15f, 0.0005f, -0.0005f, 0.00049999f, -0.004f,
+                           12345.6789f, 54321.5f, 943.16f, 1013.25f, 120000.0f, NAN, -NAN, INFINITY, -INFINITY,
+                           1e-30f, -1e-30f, 3.4e38f, -3.4e38f};
+    for (int id : floatColumns)
+    {
+        const BEAMLogColumn &column = BEAM_LOG_SCHEMA[id];
+        double unit = 1.0 / beamPow10(column.decimals);
+        bool isSigned = column.type == BEAM_COL_TYPE_SIGNED;
+        double largest = ldexp(1.0, 8 * column.size - isSigned) - 1;
+        for (float v : edges)
+        {
+            mismatches += checkFloat(id, v);
+            count++;
+        }
+        for (int i = -200000; i <= 200000; i++)
+        {
+            float tie = (float)((i + 0.5) * unit);
+            mismatches += checkFloat(id, tie) + checkFloat(id, nextafterf(tie, -INFINITY)) +
+                          checkFloat(id, nextafterf(tie, INFINITY));
+            count += 3;
+        }
+        std::uniform_real_distribution<double> range(isSigned ? -largest * unit : 0.0, largest * unit);
+        for (int i = 0; i < 1000000; i++)
+        {
+            uint32_t bits = rng();
+            float pattern;
+            memcpy(&pattern, &bits, sizeof(pattern));
+            mismatches += checkFloat(id, (float)range(rng)) + checkFloat(id, pattern);
+            count += 2;
+        }
+    }
+    *checked = count;
+    return mismatches;
+}
+
+// The percent columns over 0-100%: every ratio a/b with b up to 2000, as
+// the device divides seconds by seconds, the 64 doubles either side of
+// every "%.3f" tie, and 1M random doubles
+static size_t checkPercents(size_t *checked)
+{
+    size_t mismatches = 0;
+    size_t count = 0;
+    std::mt19937_64 rng(13);
+    std::uniform_real_distribution<double> range(0.0, 1.0);
+    for (int id : {BEAM_COL_ACTIVITY_PERCENT, BEAM_COL_INACTIVITY_PERCENT})
+    {
+        for (int b = 1; b <= 2000; b++)
+        {
+            for (int a = 0; a <= b; a++)
+            {
+                mismatches += checkFloat(id, (double)a / b);
+                count++;
+            }
+        }
+        for (int i = 0; i < 1000; i++)
+        {
+            double below = (2 * i + 1) / 2000.0;
+            double above = below;
+            mismatches += checkFloat(id, below);
+            count++;
+            for (int step = 0; step < 64; step++)
+            {
+                below = nextafter(below, 0.0);
+                above = nextafter(above, 1.0);
+                mismatches += checkFloat(id, below) + checkFloat(id, above);
+                count += 2;
+            }
+        }
+        for (int i = 0; i < 1000000; i++)
+        {
+            mismatches += checkFloat(id, range(rng));
+            count++;
+        }
+    }
+    *checked = count;
+    return mismatches;
+}
+
+// Every integer number format the schema uses, exhaustively for 16-bit values
+static size_t checkNumbers()
+{
+    size_t mismatches = 0;
+    std::mt19937 rng(7);
+    const int64_t edges[] = {0, 1, -1, 9, 10, 99, 100, 999, 1000, 9999, 10000, 32767, -32768, 65535,
+                             2147483647LL, -2147483648LL, 4294967295LL};
+    for (uint8_t decimals = 0; decimals <= 4; decimals++)
+    {
+        for (int64_t v = -32768; v <= 65535; v++)
+        {
+            mismatches += checkFixed(v, decimals);
+        }
+        for (int64_t v : edges)
+        {
+            mismatches += checkFixed(v, decimals);
+        }
+        for (int i = 0; i < 200000; i++)
+        {
+            mismatches += checkFixed((int32_t)rng(), decimals);
+            mismatches += checkFixed(rng(), decimals);
+        }
+    }
+    for (int i = 0; i < 200000; i++)
+    {
+        uint32_t t = rng();
+        char expected[48];
+        char actual[48];
+        int year, month, day, hour, minute, second;
+        beamCivilTime(t, year, month, day, hour, minute, second);
+        snprintf(expected, sizeof(expected), "%04d-%02d-%02d %02d:%02d:%02d", year, month, day, hour, minute, second);
+        actual[beamWriteDateTime(actual, t)] = '\0';
+        mismatches += strcmp(expected, actual) != 0;
+        snprintf(expected, sizeof(expected), "%08lx", (unsigned long)t);
+        actual[beamWriteHex(actual, t)] = '\0';
+        mismatches += strcmp(expected, actual) != 0;
+    }
+    return mismatches;
+}
+
+typedef int (*RowFormatter)(const LogRecord &, uint32_t, const char *, const char *, char *, size_t);
+
+static int fastRow(const LogRecord &r, uint32_t sequence, const char *deviceID, const char *libraryVersion,
+                   char *buffer, size_t size)
+{
+    return beamFormatCSVRow(r, sequence, deviceID, libraryVersion, buffer, size);
+}
+
+// The crc column alone, part of both formatters' time
+static char sampleRow[BEAM_LOG_CSV_ROW_SIZE];
+static size_t sampleLength = 0;
+
+static int crcOnly(const LogRecord &, uint32_t, const char *, const char *, char *, size_t)
+{
+    return beamCRC32(sampleRow, sampleLength) & 1;
+}
+
+// Nanoseconds per row
+static double timeRows(RowFormatter format, const std::vector<LogRecord> &rows, double seconds, size_t *bytes)
+{
+    typedef std::chrono::steady_clock Clock;
+    char buffer[BEAM_LOG_CSV_ROW_SIZE + 32];
+    size_t formatted = 0;
+    size_t total = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0;
+    do
+    {
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            total += format(rows[i], i + 1, "XYZ", "2.1.0", buffer, sizeof(buffer));
+        }
+        formatted += rows.size();
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < seconds);
+    *bytes = total; // keeps the work observable
+    return elapsed * 1e9 / formatted;
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = 1440;
+    double seconds = 0.5;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--rows") && i + 1 < argc)
+            count = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--rows N] [--seconds S]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (count == 0)
+    {
+        count = 1;
+    }
+
+    std::vector<LogRecord> rows = makeRows(count);
+    size_t mismatches = checkNumbers();
+    size_t floatsChecked = 0;
+    size_t percentsChecked = 0;
+    mismatches += checkFloats(&floatsChecked);
+    mismatches += checkPercents(&percentsChecked);
+    size_t rowBytes = 0;
+    for (size_t i = 0; i < rows.size(); i++)
+    {
+        char expected[256];
+        char actual[BEAM_LOG_CSV_ROW_SIZE];
+        int expectedLength = referenceRow(rows[i], i + 1, "XYZ", "2.1.0", expected, sizeof(expected));
+        int actualLength = beamFormatCSVRow(rows[i], i + 1, "XYZ", "2.1.0", actual, sizeof(actual));
+        if (expectedLength != actualLength || strcmp(expected, actual) != 0)
+        {
+            fprintf(stderr, "row mismatch:\n  snprintf %s\n  fast     %s\n", expected, actual);
+            mismatches++;
+        }
+        rowBytes += actualLength;
+        memcpy(sampleRow, actual, sizeof(sampleRow));
+        sampleLength = actualLength - BEAM_LOG_CRC_DIGITS;
+    }
+    printf("checked           every 16-bit value and 400k random values per integer format, %zu float readings,\n"
+           "                  %zu percent readings, %zu rows: %zu mismatches\n",
+           floatsChecked, percentsChecked, rows.size(), mismatches);
+    if (mismatches > 0)
+    {
+        return 1;
+    }
+
+    size_t sink = 0;
+    double reference = timeRows(referenceRow, rows, seconds, &sink);
+    double fast = timeRows(fastRow, rows, seconds, &sink);
+    double crc = timeRows(crcOnly, rows, seconds, &sink);
+    printf("rows              %zu, %.1f bytes each\n", rows.size(), (double)rowBytes / rows.size());
+    printf("snprintf          %8.1f ns/row\n", reference);
+    printf("beamFormatCSVRow  %8.1f ns/row (%.1fx)\n", fast, reference / fast);
+    printf("  of which crc    %8.1f ns/row\n", crc);
+    return 0;
+}
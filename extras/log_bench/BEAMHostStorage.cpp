@@ -0,0 +1,143 @@
+#include "BEAMHostStorage.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// RAM backend
+
+class BEAMRamFile : public BEAMFileImpl
+{
+public:
+    BEAMRamFile(std::shared_ptr<std::vector<uint8_t>> data, bool append) : _data(data), _append(append) {}
+
+    size_t read(uint8_t *data, size_t length) override
+    {
+        size_t n = _position < _data->size() ? _data->size() - _position : 0;
+        n = n < length ? n : length;
+        memcpy(data, _data->data() + _position, n);
+        _position += n;
+        return n;
+    }
+
+    size_t write(const uint8_t *data, size_t length) override
+    {
+        if (_append)
+        {
+            _position = _data->size();
+        }
+        if (_position + length > _data->size())
+        {
+            _data->resize(_position + length);
+        }
+        memcpy(_data->data() + _position, data, length);
+        _position += length;
+        return length;
+    }
+
+    bool seek(uint32_t position) override
+    {
+        _position = position;
+        return position <= _data->size();
+    }
+
+    uint32_t position() override { return _position; }
+    uint32_t size() override { return _data->size(); }
+
+private:
+    std::shared_ptr<std::vector<uint8_t>> _data;
+    bool _append;
+    size_t _position = 0;
+};
+
+const std::vector<uint8_t> *BEAMRamStorage::contents(const char *path) const
+{
+    auto it = _files.find(path);
+    return it == _files.end() ? nullptr : it->second.get();
+}
+
+BEAMFileImpl *BEAMRamStorage::openFile(const char *path, BEAMOpenMode mode)
+{
+    auto it = _files.find(path);
+    if (it == _files.end())
+    {
+        if (mode == BEAM_OPEN_READ || mode == BEAM_OPEN_UPDATE)
+        {
+            return nullptr;
+        }
+        it = _files.emplace(path, std::make_shared<std::vector<uint8_t>>()).first;
+    }
+    if (mode == BEAM_OPEN_WRITE)
+    {
+        it->second->clear();
+    }
+    return new BEAMRamFile(it->second, mode == BEAM_OPEN_APPEND);
+}
+
+bool BEAMRamStorage::fileExists(const char *path)
+{
+    return _files.count(path) > 0;
+}
+
+bool BEAMRamStorage::removeFile(const char *path)
+{
+    return _files.erase(path) > 0;
+}
+
+bool BEAMRamStorage::truncateFile(const char *path, uint32_t size)
+{
+    auto it = _files.find(path);
+    if (it == _files.end())
+    {
+        return false;
+    }
+    it->second->resize(size);
+    return true;
+}
+
+// POSIX backend
+
+class BEAMPosixFile : public BEAMFileImpl
+{
+public:
+    explicit BEAMPosixFile(FILE *file) : _file(file) {}
+    ~BEAMPosixFile() override { fclose(_file); }
+
+    size_t read(uint8_t *data, size_t length) override { return fread(data, 1, length, _file); }
+    size_t write(const uint8_t *data, size_t length) override { return fwrite(data, 1, length, _file); }
+    bool seek(uint32_t position) override { return fseek(_file, position, SEEK_SET) == 0; }
+    uint32_t position() override { return (uint32_t)ftell(_file); }
+
+    uint32_t size() override
+    {
+        fflush(_file);
+        struct stat st;
+        return fstat(fileno(_file), &st) == 0 ? (uint32_t)st.st_size : 0;
+    }
+
+private:
+    FILE *_file;
+};
+
+BEAMFileImpl *BEAMPosixStorage::openFile(const char *path, BEAMOpenMode mode)
+{
+    static const char *const modes[] = {"rb", "wb", "ab", "r+b"};
+    FILE *file = fopen(fullPath(path).c_str(), modes[mode]);
+    return file ? new BEAMPosixFile(file) : nullptr;
+}
+
+bool BEAMPosixStorage::fileExists(const char *path)
+{
+    struct stat st;
+    return stat(fullPath(path).c_str(), &st) == 0;
+}
+
+bool BEAMPosixStorage::removeFile(const char *path)
+{
+    return ::remove(fullPath(path).c_str()) == 0;
+}
+
+bool BEAMPosixStorage::truncateFile(const char *path, uint32_t size)
+{
+    return ::truncate(fullPath(path).c_str(), size) == 0;
+}
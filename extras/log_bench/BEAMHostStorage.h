@@ -0,0 +1,49 @@
+#ifndef BEAM_HOST_STORAGE_H
+#define BEAM_HOST_STORAGE_H
+
+// Host-only BEAMStorage backends for log_bench and tests. Kept out of src/
+// so the firmware does not pull in STL containers.
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BEAMStorage.h"
+
+// Files held in memory, for tests and benchmarks
+class BEAMRamStorage : public BEAMStorage
+{
+public:
+    uint32_t volumeID() override { return _volumeID; }
+    void setVolumeID(uint32_t id) { _volumeID = id; } // Simulates a card swap
+    const std::vector<uint8_t> *contents(const char *path) const;
+    void clear() { _files.clear(); }
+
+protected:
+    BEAMFileImpl *openFile(const char *path, BEAMOpenMode mode) override;
+    bool fileExists(const char *path) override;
+    bool removeFile(const char *path) override;
+    bool truncateFile(const char *path, uint32_t size) override;
+
+private:
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> _files;
+    uint32_t _volumeID = 1;
+};
+
+// Files under a host directory through stdio/POSIX calls
+class BEAMPosixStorage : public BEAMStorage
+{
+public:
+    explicit BEAMPosixStorage(const char *root) : _root(root) {}
+
+protected:
+    BEAMFileImpl *openFile(const char *path, BEAMOpenMode mode) override;
+    bool fileExists(const char *path) override;
+    bool removeFile(const char *path) override;
+    bool truncateFile(const char *path, uint32_t size) override;
+
+private:
+    std::string fullPath(const char *path) const { return _root + path; }
+    std::string _root;
+};
+
+#endif
@@ -0,0 +1,190 @@
+/*
+ * Host-side benchmark for the BEAM logging path
+ *
+ * Drives src/BEAMLogWriter.cpp wake by wake against the RAM or a POSIX
+ * storage backend (BEAMHostStorage.h) and reports storage operations and bytes written per
+ * record and per SD flush, so changes to the logging path can be checked
+ * for extra SD operations without hardware.
+ *
+ * Build (from this directory):
+ *   g++ -std=c++17 -O2 -I../../src -o log_bench log_bench.cpp BEAMHostStorage.cpp \
+ *       ../../src/BEAMLogWriter.cpp ../../src/BEAMStorage.cpp
+ *
+ * Usage:
+ *   ./log_bench [options] 2>/dev/null
+ *     --posix DIR            write real files under DIR (default: RAM backend)
+ *     --format csv|bin       log format (default csv)
+ *     --batch N              records per SD flush, 1-32 (default 1)
+ *     --interval MIN         minutes between wakes (default 10)
+ *     --days D               simulated days (default 2)
+ *     --compress             compress the previous day's file on rollover
+ *     --reboot-every N       power-on reset every N wakes (default 0 = never)
+ *     --keep-file            keep appending to today's file after a reset
+ *     --max-ops-per-record X exit 1 if storage ops per record exceed X
+ *   The writer's own log lines go to stderr.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "BEAMHostStorage.h"
+#include "BEAMLogWriter.h"
+
+static void resetState(BEAMStateBlock &state)
+{
+    // As BEAMState::reset(); the CRC is not needed on the host
+    memset(&state, 0, sizeof(state));
+    state.fileSequence = BEAM_STATE_NO_FILE;
+}
+
+static LogRecord makeRecord(uint32_t timestamp, uint32_t wake)
+{
+    LogRecord record = {};
+    record.timestamp = timestamp;
+    record.millis = 2300 + wake % 150;
+    record.minFreeHeap = 230000 + wake % 97;
+    record.batteryVoltage = 4.1f - wake * 0.0002f;
+    record.temperatureC = 22.0f + (wake % 40) * 0.05f;
+    record.pressureHpa = 1013.0f + (wake % 23) * 0.1f;
+    record.humidityPercent = 45.0f + (wake % 31) * 0.1f;
+    record.lux = (timestamp % 86400 > 25200 && timestamp % 86400 < 68400) ? 300.0f + wake % 50 : 0.5f;
+    record.activityCount = wake % 17;
+    record.activityPercent = (wake % 100) / 100.0;
+    record.inactivityPeriods[0] = 40;
+    record.inactivityCounts[0] = wake % 3;
+    return record;
+}
+
+int main(int argc, char **argv)
+{
+    const char *posixRoot = NULL;
+    BEAMLogFormat format = LOG_FORMAT_CSV;
+    int batch = 1;
+    int interval = 10;
+    int days = 2;
+    bool compress = false;
+    int rebootEvery = 0;
+    bool keepFile = false;
+    double maxOpsPerRecord = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--posix") && hasValue)
+            posixRoot = argv[++i];
+        else if (!strcmp(arg, "--format") && hasValue)
+            format = !strcmp(argv[++i], "bin") ? LOG_FORMAT_BINARY : LOG_FORMAT_CSV;
+        else if (!strcmp(arg, "--batch") && hasValue)
+            batch = atoi(argv[++i]);
+        else if (!strcmp(arg, "--interval") && hasValue)
+            interval = atoi(argv[++i]);
+        else if (!strcmp(arg, "--days") && hasValue)
+            days = atoi(argv[++i]);
+        else if (!strcmp(arg, "--compress"))
+            compress = true;
+        else if (!strcmp(arg, "--reboot-every") && hasValue)
+            rebootEvery = atoi(argv[++i]);
+        else if (!strcmp(arg, "--keep-file"))
+            keepFile = true;
+        else if (!strcmp(arg, "--max-ops-per-record") && hasValue)
+            maxOpsPerRecord = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--posix DIR] [--format csv|bin] [--batch N] [--interval MIN] [--days D]\n"
+                            "       [--compress] [--reboot-every N] [--keep-file] [--max-ops-per-record X]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (batch < 1 || batch > LOG_BATCH_CAPACITY || interval < 1 || days < 1)
+    {
+        fprintf(stderr, "error: batch must be 1-%d, interval and days at least 1\n", LOG_BATCH_CAPACITY);
+        return 2;
+    }
+
+    BEAMRamStorage ram;
+    BEAMPosixStorage posix(posixRoot ? posixRoot : ".");
+    BEAMStorage *storage = posixRoot ? (BEAMStorage *)&posix : (BEAMStorage *)&ram;
+    static BEAMStateBlock state;
+    resetState(state);
+    BEAMLogWriter writer(storage, &state);
+
+    BEAMLogSettings settings = {{'B', 'N', 'C', '\0'}, "bench", format, compress, !keepFile, false, 0, 0};
+    const uint32_t start = 1735689600; // 2025-01-01 00:00:00
+    const uint32_t wakes = (uint32_t)days * 1440 / interval;
+
+    uint32_t records = 0;
+    uint32_t flushes = 0;
+    uint32_t minOps = UINT32_MAX;
+    uint32_t maxOps = 0;
+    uint32_t maxBytes = 0;
+    uint32_t failed = 0;
+
+    for (uint32_t wake = 0; wake < wakes; wake++)
+    {
+        bool boot = wake == 0 || (rebootEvery > 0 && wake % rebootEvery == 0);
+        if (boot && wake > 0)
+        {
+            if (state.fileSequence < 100)
+            {
+                // The last file survives in NVS (BEAMSettingsStore) and bounds the scan
+                settings.lastFile = state.fileDay << 8 | state.fileSequence;
+                settings.lastFileCard = state.fileCardID;
+            }
+            resetState(state); // power-on reset: RTC memory is gone
+        }
+        settings.wakeFromSleep = !boot;
+        writer.configure(settings);
+
+        state.records[state.pendingRecords++] = makeRecord(start + wake * interval * 60, wake);
+        if (!boot && state.pendingRecords < batch)
+        {
+            continue; // batched in RTC memory, SD left off
+        }
+
+        BEAMStorageStats before = storage->stats();
+        uint8_t written = writer.writeRecords(state.records, state.pendingRecords);
+        BEAMStorageStats after = storage->stats();
+        failed += state.pendingRecords - written;
+        records += written;
+        state.pendingRecords = 0;
+        flushes++;
+
+        uint32_t ops = after.operations() - before.operations();
+        uint32_t bytes = after.bytesWritten - before.bytesWritten;
+        minOps = ops < minOps ? ops : minOps;
+        maxOps = ops > maxOps ? ops : maxOps;
+        maxBytes = bytes > maxBytes ? bytes : maxBytes;
+    }
+
+    const BEAMStorageStats &io = storage->stats();
+    double opsPerRecord = records ? (double)io.operations() / records : 0.0;
+    printf("backend           %s\n", posixRoot ? "posix" : "ram");
+    printf("format            %s, batch %d, every %d min, %d days%s\n",
+           format == LOG_FORMAT_BINARY ? "bin" : "csv", batch, interval, days, compress ? ", compress" : "");
+    printf("wakes             %lu\n", (unsigned long)wakes);
+    printf("flushes           %lu\n", (unsigned long)flushes);
+    printf("records written   %lu (%lu failed)\n", (unsigned long)records, (unsigned long)failed);
+    printf("operations        %lu: %lu open, %lu read, %lu write, %lu seek, %lu exists, %lu remove, %lu truncate\n",
+           (unsigned long)io.operations(), (unsigned long)io.opens, (unsigned long)io.reads,
+           (unsigned long)io.writes, (unsigned long)io.seeks, (unsigned long)io.lookups,
+           (unsigned long)io.removes, (unsigned long)io.truncates);
+    printf("bytes             %lu written, %lu read\n", (unsigned long)io.bytesWritten, (unsigned long)io.bytesRead);
+    printf("per record        %.2f ops, %.1f bytes written\n", opsPerRecord,
+           records ? (double)io.bytesWritten / records : 0.0);
+    printf("per flush         %.2f ops (min %lu, max %lu), max %lu bytes written\n",
+           flushes ? (double)io.operations() / flushes : 0.0, (unsigned long)(flushes ? minOps : 0),
+           (unsigned long)maxOps, (unsigned long)maxBytes);
+
+    if (failed > 0)
+    {
+        return 1;
+    }
+    if (maxOpsPerRecord > 0 && opsPerRecord > maxOpsPerRecord)
+    {
+        fprintf(stderr, "error: %.2f storage ops per record exceeds %.2f\n", opsPerRecord, maxOpsPerRecord);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * Host-side compressor/decompressor for BEAM compressed log files (.lz)
+ *
+ * Uses the device's codec (src/LogCompress.h), so files written with
+ * beam.setLogCompression(true) decompress byte for byte, and --bench shows
+ * what compression would save on existing logs.
+ *
+ * Build (from this directory):
+ *   g++ -std=c++17 -O2 -I../../src -o beam_lz beam_lz.cpp
+ *
+ * Usage:
+ *   ./beam_lz -d FILE.csv.lz > FILE.csv    decompress to stdout
+ *   ./beam_lz -c FILE.csv > FILE.csv.lz    compress to stdout
+ *   ./beam_lz --bench FILE [FILE ...]      per-file ratio and CPU time
+ *   Exit status is 1 if a file is unreadable or fails its size/CRC check.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "LogCompress.h"
+
+static size_t readStdio(void *context, uint8_t *data, size_t length)
+{
+    return fread(data, 1, length, static_cast<FILE *>(context));
+}
+
+static bool writeStdio(void *context, const uint8_t *data, size_t length)
+{
+    return fwrite(data, 1, length, static_cast<FILE *>(context)) == length;
+}
+
+// In-memory streams for --bench, so CPU time excludes file I/O
+struct MemoryStream
+{
+    std::vector<uint8_t> data;
+    size_t position = 0;
+};
+
+static size_t readMemory(void *context, uint8_t *data, size_t length)
+{
+    MemoryStream *stream = static_cast<MemoryStream *>(context);
+    size_t n = stream->data.size() - stream->position;
+    n = n < length ? n : length;
+    memcpy(data, stream->data.data() + stream->position, n);
+    stream->position += n;
+    return n;
+}
+
+static bool writeMemory(void *context, const uint8_t *data, size_t length)
+{
+    MemoryStream *stream = static_cast<MemoryStream *>(context);
+    stream->data.insert(stream->data.end(), data, data + length);
+    return true;
+}
+
+static double cpuMilliseconds(clock_t start)
+{
+    return 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+}
+
+static bool benchFile(const char *path)
+{
+    MemoryStream original;
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "error: cannot open %s\n", path);
+        return false;
+    }
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    {
+        original.data.insert(original.data.end(), chunk, chunk + n);
+    }
+    fclose(f);
+
+    // Repeat small files so the timings are above clock() resolution
+    int runs = original.data.size() < (1 << 20) ? 20 : 1;
+    static BEAMLZEncoder encoder;
+    static BEAMLZDecoder decoder;
+    MemoryStream packed;
+    clock_t start = clock();
+    for (int i = 0; i < runs; i++)
+    {
+        original.position = 0;
+        packed.data.clear();
+        beamLZCompress(encoder, readMemory, &original, writeMemory, &packed);
+    }
+    double compressMs = cpuMilliseconds(start) / runs;
+
+    MemoryStream unpacked;
+    bool ok = true;
+    start = clock();
+    for (int i = 0; i < runs; i++)
+    {
+        packed.position = 0;
+        unpacked.data.clear();
+        ok = beamLZDecompress(decoder, readMemory, &packed, writeMemory, &unpacked) && ok;
+    }
+    double decompressMs = cpuMilliseconds(start) / runs;
+    ok = ok && unpacked.data == original.data;
+
+    double ratio = packed.data.empty() ? 0.0 : (double)original.data.size() / packed.data.size();
+    printf("%-40s %10zu %10zu %7.2f %12.2f %12.2f %s\n", path, original.data.size(), packed.data.size(),
+           ratio, compressMs, decompressMs, ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+static bool streamFile(const char *path, bool compress)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "error: cannot open %s\n", path);
+        return false;
+    }
+    static BEAMLZEncoder encoder;
+    static BEAMLZDecoder decoder;
+    bool ok = compress ? beamLZCompress(encoder, readStdio, f, writeStdio, stdout)
+                       : beamLZDecompress(decoder, readStdio, f, writeStdio, stdout);
+    fclose(f);
+    if (!ok)
+    {
+        fprintf(stderr, "error: %s %s\n", path, compress ? "could not be compressed" : "is truncated or fails its CRC");
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && (!strcmp(argv[1], "-c") || !strcmp(argv[1], "-d")))
+    {
+        return streamFile(argv[2], argv[1][1] == 'c') ? 0 : 1;
+    }
+    if (argc >= 3 && !strcmp(argv[1], "--bench"))
+    {
+        printf("%-40s %10s %10s %7s %12s %12s\n", "file", "bytes", "packed", "ratio", "compress_ms", "decompress_ms");
+        int failures = 0;
+        for (int i = 2; i < argc; i++)
+        {
+            failures += !benchFile(argv[i]);
+        }
+        return failures ? 1 : 0;
+    }
+
+    fprintf(stderr, "usage: %s -c FILE | -d FILE.lz | --bench FILE [FILE ...]\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,131 @@
+/*
+ * Host-side decoder for BEAM binary log files (.bin)
+ *
+ * Converts files written with beam.setLogFormat(LOG_FORMAT_BINARY) back into
+ * CSV, using the same row formatter as the device's CSV path
+ * (src/LogFormat.h), so the output matches a CSV log row for row. The
+ * columns come from each file's header, so files from builds that dropped
+ * columns (BEAM_LOG_DROP_COLUMNS) decode with this same binary.
+ *
+ * Build (from this directory):
+ *   g++ -std=c++17 -O2 -I../../src -o beam_decode beam_decode.cpp
+ *
+ * Usage:
+ *   ./beam_decode [--no-header] FILE.bin [FILE.bin ...] > out.csv
+ *     --no-header   omit the CSV header line (e.g. when appending)
+ *   Rows from several files are concatenated in argument order; they must
+ *   all have the same columns. Exit status is 1 if any file is unreadable,
+ *   has a bad header, a truncated record or a record that fails its CRC
+ *   (such records are reported and skipped).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "LogFormat.h"
+
+static uint32_t outputColumns = 0; // Columns of the CSV being written
+
+static bool decodeFile(const char *path, bool printHeader, FILE *out)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "error: cannot open %s\n", path);
+        return false;
+    }
+
+    BEAMLogFileHeader header;
+    if (fread(&header, 1, sizeof(header), f) != sizeof(header) || !beamCheckFileHeader(header))
+    {
+        fprintf(stderr, "error: %s is not a BEAM binary log (format version %d expected)\n",
+                path, BEAM_LOG_FORMAT_VERSION);
+        fclose(f);
+        return false;
+    }
+    header.deviceID[sizeof(header.deviceID) - 1] = '\0';
+    header.libraryVersion[sizeof(header.libraryVersion) - 1] = '\0';
+
+    if (outputColumns == 0)
+    {
+        outputColumns = header.columns;
+        if (printHeader)
+        {
+            char line[beamCSVHeaderLength(BEAM_LOG_ALL_COLUMNS) + 1];
+            beamWriteCSVHeader(header.columns, line);
+            fprintf(out, "%s\n", line);
+        }
+    }
+    else if (header.columns != outputColumns)
+    {
+        fprintf(stderr, "error: %s has different columns than the files before it\n", path);
+        fclose(f);
+        return false;
+    }
+
+    BEAMColumnSet columns = {header.columns};
+    const size_t recordSize = header.recordSize;
+    uint8_t record[BEAM_LOG_MAX_RECORD_SIZE];
+    char row[BEAM_LOG_MAX_CSV_ROW_SIZE];
+    size_t rows = 0;
+    size_t corrupt = 0;
+    size_t n;
+    while ((n = fread(record, 1, recordSize, f)) == recordSize)
+    {
+        if (!beamCheckBinaryRecord(record, recordSize))
+        {
+            fprintf(stderr, "error: %s record %zu fails its CRC\n", path, rows + corrupt);
+            corrupt++;
+            continue;
+        }
+        beamFormatCSVRow(columns, record, header.deviceID, header.libraryVersion, row, sizeof(row));
+        fprintf(out, "%s\n", row);
+        rows++;
+    }
+    fclose(f);
+
+    if (n != 0)
+    {
+        fprintf(stderr, "error: %s ends with a truncated record (%zu of %zu bytes)\n",
+                path, n, recordSize);
+        return false;
+    }
+    fprintf(stderr, "%s: %zu records\n", path, rows);
+    return corrupt == 0;
+}
+
+int main(int argc, char **argv)
+{
+    bool header = true;
+    int files = 0;
+    int failures = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--no-header"))
+        {
+            header = false;
+        }
+        else if (argv[i][0] == '-')
+        {
+            fprintf(stderr, "error: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] == '-')
+        {
+            continue;
+        }
+        files++;
+        failures += !decodeFile(argv[i], header, stdout);
+    }
+
+    if (files == 0)
+    {
+        fprintf(stderr, "usage: %s [--no-header] FILE.bin [FILE.bin ...]\n", argv[0]);
+        return 2;
+    }
+    return failures ? 1 : 0;
+}
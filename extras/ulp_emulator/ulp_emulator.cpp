@@ -0,0 +1,648 @@
+/*
+ * Host-side ULP-FSM emulator for the BEAM ULP programs
+ *
+ * Runs the instruction tables from src/ULPProgram.h against a scripted GPIO3
+ * (PIR trigger) trace and reports ULP cycles per 1-second window, ULP duty
+ * cycle, an estimated sleep current, the final RTC_SLOW_MEM counters and the
+ * motion onset/offset events left in the ring buffer.
+ *
+ * Build (from this directory):
+ *   g++ -std=c++20 -O2 -I../../src -o ulp_emulator ulp_emulator.cpp
+ * Add -DULP_PROGRAM_CONFIG=... to check a custom config as preset "build".
+ *
+ * Usage:
+ *   ./ulp_emulator [options]
+ *     --program NAME          ULP program to run (busy, timer)
+ *     --preset NAME           program config (build, default, fast, slow, count-only)
+ *     --sample-hz HZ          timer program wakeup rate (default 20)
+ *     --seconds S             simulated time in seconds (default 600)
+ *     --inactivity-period S   INACTIVITY_PERIOD word (default 40)
+ *     --threshold S           additional inactivity threshold; repeatable
+ *     --motion A:B            GPIO3 held LOW (motion) from A to B seconds; repeatable
+ *     --trace FILE            file with one "A B" motion interval per line (# comments)
+ *     --clock-hz HZ           ULP clock (default ULP_CLOCK_HZ, ESP32-S3 RC_FAST)
+ *     --ulp-ua UA             extra current while the ULP is running (default 110)
+ *     --sleep-ua UA           deep sleep floor current (default 25)
+ *     -v                      print cycles for every 1-second window
+ *   Regression checks (exit status 1 on failure):
+ *     --max-duty PCT          ULP duty cycle ceiling
+ *     --max-cycles-per-s N    mean active cycles per second ceiling
+ *     --max-window-error PCT  window length tolerance around windowMs (default 1)
+ *     --expect-pir N          final PIR_COUNT
+ *     --expect-inactivity N   final INACTIVITY_COUNT
+ *     --expect-tracker N      final INACTIVITY_TRACKER
+ *     --expect-events N       motion events in the ring buffer
+ *     --expect-longest-bout N final LONGEST_BOUT
+ *     --expect-bouts N        final BOUT_COUNT
+ *   Programs that do not fit CONFIG_ULP_COPROC_RESERVE_MEM always fail, as do
+ *   programs that advance EVENT_HEAD before storing the event word (checked
+ *   at every EVENT_HEAD store, as if the main CPU read right then) and
+ *   programs whose windows, timed between WINDOW_TICK stores, miss windowMs
+ *   by more than the tolerance (programs without the events feature have no
+ *   tick and are not timed).
+ *
+ * Cycle costs are the ULP_CYCLES_* values of ULPProgram.h, from the ULP-FSM
+ * instruction reference (execute + fetch), and
+ * current defaults come from ULP-Power.xlsx (bare S3: 40 uA idle vs 150 uA
+ * with the ULP running; 25 uA measured for a BEAM in deep sleep). They are
+ * estimates for comparing program revisions, not absolute measurements.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "ulp_shim.h"
+#include "ULPProgram.h"
+
+#define ULP_MEM_WORDS (CONFIG_ULP_COPROC_RESERVE_MEM / 4)
+
+struct MotionInterval
+{
+    double start;
+    double end;
+};
+
+struct ProgramEntry
+{
+    const char *preset;
+    const char *name;
+    const ulp_insn_t *insns;
+    size_t count;
+    uint16_t windowMs;
+};
+
+// Instantiates both programs for a config; each build is size-checked at compile time
+template <ULPProgramConfig Config>
+struct PresetPrograms
+{
+    static constexpr auto busy = ulpBuildBusyProgram<Config>();
+    static constexpr auto timer = ulpBuildTimerProgram<Config>();
+};
+
+#define PRESET_ENTRIES(name, config)                                                                 \
+    {name, "busy", PresetPrograms<config>::busy.insns.data(), PresetPrograms<config>::busy.insns.size(), \
+     config.windowMs},                                                                               \
+    {name, "timer", PresetPrograms<config>::timer.insns.data(), PresetPrograms<config>::timer.insns.size(), config.windowMs}
+
+static const ProgramEntry programs[] = {
+    PRESET_ENTRIES("build", ULP_PROGRAM_CONFIG),
+    PRESET_ENTRIES("default", ULP_PRESET_DEFAULT),
+    PRESET_ENTRIES("fast", ULP_PRESET_FAST),
+    PRESET_ENTRIES("slow", ULP_PRESET_SLOW),
+    PRESET_ENTRIES("count-only", (ULPProgramConfig{25, 1000, 0})),
+};
+
+class UlpEmulator
+{
+public:
+    UlpEmulator(const ulp_insn_t *program, size_t count, double clockHz)
+        : _clockHz(clockHz), _wakePeriodCycles(0), _cycles(0), _pc(0), _halted(false), _unwrittenEvents(0),
+          _tickStores(0), _firstTickCycle(0), _lastTickCycle(0)
+    {
+        memset(_mem, 0, sizeof(_mem));
+        memset(_regs, 0, sizeof(_regs));
+        memset(_slotWritten, 0, sizeof(_slotWritten));
+        load(program, count);
+    }
+
+    // Number of real instructions after label removal
+    size_t size() const { return _program.size(); }
+
+    uint32_t &word(size_t index) { return _mem[index]; }
+
+    void setMotion(const std::vector<MotionInterval> &motion) { _motion = motion; }
+
+    // Events whose head advance was stored before the event word itself
+    uint32_t unwrittenEvents() const { return _unwrittenEvents; }
+
+    // Mean time between WINDOW_TICK stores, 0 with fewer than two
+    double windowSeconds() const
+    {
+        return _tickStores > 1 ? (double)(_lastTickCycle - _firstTickCycle) / (_tickStores - 1) / _clockHz : 0;
+    }
+
+    // Equivalent of ulp_set_wakeup_period(): restart at PROG_START this long after I_HALT
+    void setWakeupPeriod(double seconds) { _wakePeriodCycles = (uint64_t)(seconds * _clockHz); }
+
+    // Run until the simulated clock reaches `seconds`, accumulating active
+    // cycles into 1-second buckets.
+    bool run(double seconds, std::vector<uint64_t> &activePerSecond)
+    {
+        activePerSecond.assign((size_t)seconds + 1, 0);
+        const uint64_t endCycle = (uint64_t)(seconds * _clockHz);
+
+        while (_cycles < endCycle)
+        {
+            if (_halted)
+            {
+                if (_wakePeriodCycles == 0)
+                {
+                    break; // halted with no wakeup timer, nothing left to run
+                }
+                _cycles += _wakePeriodCycles;
+                _pc = 0;
+                _halted = false;
+                continue;
+            }
+            if (_pc >= _program.size())
+            {
+                fprintf(stderr, "error: PC ran past end of program\n");
+                return false;
+            }
+            const ulp_insn_t &insn = _program[_pc];
+            uint32_t cost = execute(insn);
+            size_t second = (size_t)(_cycles / _clockHz);
+            if (second < activePerSecond.size())
+            {
+                activePerSecond[second] += cost;
+            }
+            _cycles += cost;
+        }
+        return true;
+    }
+
+private:
+    uint32_t _mem[ULP_MEM_WORDS];
+    uint16_t _regs[4];
+    std::vector<ulp_insn_t> _program;
+    std::vector<MotionInterval> _motion;
+    double _clockHz;
+    uint64_t _wakePeriodCycles;
+    uint64_t _cycles;
+    size_t _pc;
+    bool _halted;
+    bool _slotWritten[ULP_EVENT_BUFFER_SIZE]; // Event word stored since the slot was last published
+    uint32_t _unwrittenEvents;
+    uint32_t _tickStores;
+    uint64_t _firstTickCycle;
+    uint64_t _lastTickCycle;
+
+    // Stops the ULP between its two event stores: a main CPU reading when
+    // EVENT_HEAD advances must find the newly published slot already written
+    void checkStore(size_t address, uint16_t value)
+    {
+        if (address >= EVENT_BUFFER && address < EVENT_BUFFER + ULP_EVENT_BUFFER_SIZE)
+        {
+            _slotWritten[address - EVENT_BUFFER] = true;
+        }
+        else if (address == WINDOW_TICK)
+        {
+            _firstTickCycle = _tickStores++ == 0 ? _cycles : _firstTickCycle;
+            _lastTickCycle = _cycles;
+        }
+        else if (address == EVENT_HEAD)
+        {
+            size_t slot = (uint16_t)(value - 1) & (ULP_EVENT_BUFFER_SIZE - 1);
+            if (!_slotWritten[slot])
+            {
+                if (_unwrittenEvents == 0)
+                {
+                    fprintf(stderr, "error: EVENT_HEAD advanced to %u before slot %zu was written\n", value, slot);
+                }
+                _unwrittenEvents++;
+            }
+            _slotWritten[slot] = false;
+        }
+    }
+
+    void load(const ulp_insn_t *program, size_t count)
+    {
+        // Resolve labels to the index of the next real instruction
+        std::vector<int> labels(65536, -1);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (program[i].op == SHIM_LABEL)
+            {
+                labels[program[i].label] = (int)_program.size();
+            }
+            else
+            {
+                _program.push_back(program[i]);
+            }
+        }
+        for (size_t i = 0; i < _program.size(); i++)
+        {
+            if (_program[i].op >= SHIM_BX)
+            {
+                int target = labels[_program[i].label];
+                if (target < 0)
+                {
+                    fprintf(stderr, "error: undefined label %u\n", _program[i].label);
+                    exit(2);
+                }
+                _program[i].label = (uint16_t)target;
+            }
+        }
+    }
+
+    bool gpio3High() const
+    {
+        double t = _cycles / _clockHz;
+        for (const MotionInterval &m : _motion)
+        {
+            if (t >= m.start && t < m.end)
+            {
+                return false; // PIR trigger pulls GPIO3 LOW on motion
+            }
+        }
+        return true;
+    }
+
+    uint32_t readReg(uint32_t reg) const
+    {
+        if (reg == RTC_GPIO_IN_REG)
+        {
+            return gpio3High() ? (1u << (3 + RTC_GPIO_IN_NEXT_S)) : 0;
+        }
+        return 0;
+    }
+
+    uint32_t branch(const ulp_insn_t &insn, bool taken)
+    {
+        _pc = taken ? insn.label : _pc + 1;
+        return ULP_CYCLES_BRANCH;
+    }
+
+    uint32_t execute(const ulp_insn_t &insn)
+    {
+        uint16_t *r = _regs;
+        switch (insn.op)
+        {
+        case SHIM_MOVI:
+            r[insn.rd] = (uint16_t)insn.imm;
+            break;
+        case SHIM_MOVR:
+            r[insn.rd] = r[insn.rs];
+            break;
+        case SHIM_ADDI:
+            r[insn.rd] = (uint16_t)(r[insn.rs] + insn.imm);
+            break;
+        case SHIM_SUBI:
+            r[insn.rd] = (uint16_t)(r[insn.rs] - insn.imm);
+            break;
+        case SHIM_ADDR:
+            r[insn.rd] = (uint16_t)(r[insn.rs] + r[insn.imm]);
+            break;
+        case SHIM_SUBR:
+            r[insn.rd] = (uint16_t)(r[insn.rs] - r[insn.imm]);
+            break;
+        case SHIM_ANDI:
+            r[insn.rd] = (uint16_t)(r[insn.rs] & insn.imm);
+            break;
+        case SHIM_ORI:
+            r[insn.rd] = (uint16_t)(r[insn.rs] | insn.imm);
+            break;
+        case SHIM_ANDR:
+            r[insn.rd] = (uint16_t)(r[insn.rs] & r[insn.imm]);
+            break;
+        case SHIM_ORR:
+            r[insn.rd] = (uint16_t)(r[insn.rs] | r[insn.imm]);
+            break;
+        case SHIM_LSHI:
+            r[insn.rd] = (uint16_t)(r[insn.rs] << insn.imm);
+            break;
+        case SHIM_RSHI:
+            r[insn.rd] = (uint16_t)(r[insn.rs] >> insn.imm);
+            break;
+        case SHIM_LD:
+            r[insn.rd] = (uint16_t)(_mem[(r[insn.rs] + insn.imm) % ULP_MEM_WORDS] & 0xFFFF);
+            _pc++;
+            return ULP_CYCLES_MEM;
+        case SHIM_ST:
+        {
+            size_t address = (r[insn.rs] + insn.imm) % ULP_MEM_WORDS;
+            _mem[address] = r[insn.rd];
+            checkStore(address, r[insn.rd]);
+            _pc++;
+            return ULP_CYCLES_MEM;
+        }
+        case SHIM_RD_REG:
+        {
+            uint32_t width = insn.high - insn.low + 1;
+            r[0] = (uint16_t)((readReg(insn.imm) >> insn.low) & ((1u << width) - 1));
+            _pc++;
+            return ULP_CYCLES_MEM;
+        }
+        case SHIM_WR_REG:
+            _pc++;
+            return ULP_CYCLES_WR_REG;
+        case SHIM_DELAY:
+            _pc++;
+            return ULP_CYCLES_DELAY + insn.imm;
+        case SHIM_HALT:
+            _halted = true;
+            return ULP_CYCLES_HALT;
+        case SHIM_BX:
+            return branch(insn, true);
+        case SHIM_BL:
+            return branch(insn, r[0] < insn.imm);
+        case SHIM_BLE:
+            return branch(insn, r[0] <= insn.imm);
+        case SHIM_BE:
+            return branch(insn, r[0] == insn.imm);
+        case SHIM_BG:
+            return branch(insn, r[0] > insn.imm);
+        case SHIM_BGE:
+            return branch(insn, r[0] >= insn.imm);
+        default:
+            fprintf(stderr, "error: unsupported instruction op=%u\n", insn.op);
+            exit(2);
+        }
+        // ALU instructions
+        _pc++;
+        return ULP_CYCLES_ALU;
+    }
+};
+
+static bool parseInterval(const char *text, MotionInterval &out)
+{
+    return sscanf(text, "%lf:%lf", &out.start, &out.end) == 2 && out.end > out.start;
+}
+
+static bool loadTrace(const char *path, std::vector<MotionInterval> &motion)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        fprintf(stderr, "error: cannot open trace %s\n", path);
+        return false;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), f))
+    {
+        MotionInterval m;
+        if (line[0] == '#' || sscanf(line, "%lf %lf", &m.start, &m.end) != 2)
+        {
+            continue;
+        }
+        motion.push_back(m);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *programName = "busy";
+    const char *presetName = "build";
+    double seconds = 600;
+    double clockHz = ULP_CLOCK_HZ;
+    double ulpUA = 110;
+    double sleepUA = 25;
+    uint16_t inactivityPeriod = 40;
+    uint16_t sampleHz = 20;
+    bool verbose = false;
+    double maxDuty = -1;
+    double maxCyclesPerSecond = -1;
+    double maxWindowError = 1;
+    long expectPIR = -1, expectInactivity = -1, expectTracker = -1, expectEvents = -1;
+    long expectLongestBout = -1, expectBouts = -1;
+    std::vector<uint16_t> thresholds;
+    std::vector<MotionInterval> motion;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        bool takesValue = strcmp(arg, "-v") != 0;
+        if (takesValue && !val)
+        {
+            fprintf(stderr, "error: %s needs a value\n", arg);
+            return 2;
+        }
+
+        if (!strcmp(arg, "--program"))
+            programName = val;
+        else if (!strcmp(arg, "--preset"))
+            presetName = val;
+        else if (!strcmp(arg, "--seconds"))
+            seconds = atof(val);
+        else if (!strcmp(arg, "--sample-hz"))
+            sampleHz = (uint16_t)atoi(val);
+        else if (!strcmp(arg, "--inactivity-period"))
+            inactivityPeriod = (uint16_t)atoi(val);
+        else if (!strcmp(arg, "--clock-hz"))
+            clockHz = atof(val);
+        else if (!strcmp(arg, "--ulp-ua"))
+            ulpUA = atof(val);
+        else if (!strcmp(arg, "--sleep-ua"))
+            sleepUA = atof(val);
+        else if (!strcmp(arg, "--max-duty"))
+            maxDuty = atof(val);
+        else if (!strcmp(arg, "--max-cycles-per-s"))
+            maxCyclesPerSecond = atof(val);
+        else if (!strcmp(arg, "--max-window-error"))
+            maxWindowError = atof(val);
+        else if (!strcmp(arg, "--expect-pir"))
+            expectPIR = atol(val);
+        else if (!strcmp(arg, "--expect-inactivity"))
+            expectInactivity = atol(val);
+        else if (!strcmp(arg, "--expect-tracker"))
+            expectTracker = atol(val);
+        else if (!strcmp(arg, "--expect-events"))
+            expectEvents = atol(val);
+        else if (!strcmp(arg, "--expect-longest-bout"))
+            expectLongestBout = atol(val);
+        else if (!strcmp(arg, "--expect-bouts"))
+            expectBouts = atol(val);
+        else if (!strcmp(arg, "--threshold"))
+            thresholds.push_back((uint16_t)atoi(val));
+        else if (!strcmp(arg, "--motion"))
+        {
+            MotionInterval m;
+            if (!parseInterval(val, m))
+            {
+                fprintf(stderr, "error: bad --motion interval '%s'\n", val);
+                return 2;
+            }
+            motion.push_back(m);
+        }
+        else if (!strcmp(arg, "--trace"))
+        {
+            if (!loadTrace(val, motion))
+                return 2;
+        }
+        else if (!strcmp(arg, "-v"))
+        {
+            verbose = true;
+            continue;
+        }
+        else
+        {
+            fprintf(stderr, "error: unknown option %s\n", arg);
+            return 2;
+        }
+        i++;
+    }
+
+    const ProgramEntry *entry = NULL;
+    for (const ProgramEntry &p : programs)
+    {
+        if (!strcmp(p.name, programName) && !strcmp(p.preset, presetName))
+            entry = &p;
+    }
+    if (!entry)
+    {
+        fprintf(stderr, "error: unknown program '%s' / preset '%s'\n", programName, presetName);
+        return 2;
+    }
+
+    UlpEmulator ulp(entry->insns, entry->count, clockHz);
+
+    // Mirror ULPManager::begin()/HublinkBEAM::sleep() memory setup
+    ulp.word(PIR_COUNT) = 0;
+    ulp.word(INACTIVITY_COUNT) = 0;
+    ulp.word(INACTIVITY_TRACKER) = 0;
+    ulp.word(INACTIVITY_PERIOD) = inactivityPeriod;
+    if (thresholds.size() > ULP_INACTIVITY_THRESHOLDS - 1)
+    {
+        fprintf(stderr, "error: at most %d --threshold values\n", ULP_INACTIVITY_THRESHOLDS - 1);
+        return 2;
+    }
+    for (size_t i = 0; i < thresholds.size(); i++)
+    {
+        ulp.word(ULP_INACTIVITY_WORD(INACTIVITY_PERIOD, i + 1)) = thresholds[i];
+    }
+    ulp.setMotion(motion);
+
+    // Mirror ULPManager::start() in ULP_MODE_TIMER
+    if (!strcmp(entry->name, "timer"))
+    {
+        if (sampleHz == 0)
+        {
+            fprintf(stderr, "error: --sample-hz must be > 0\n");
+            return 2;
+        }
+        ulp.word(WINDOW_MOTION) = 0;
+        ulp.word(WINDOW_SAMPLES) = 0;
+        uint32_t samplesPerWindow = (uint32_t)sampleHz * entry->windowMs / 1000;
+        ulp.word(SAMPLES_PER_WINDOW) = samplesPerWindow > 0 ? samplesPerWindow : 1;
+        ulp.setWakeupPeriod(1.0 / sampleHz);
+    }
+
+    size_t usedBytes = (PROG_START + ulp.size()) * 4;
+    printf("program:        %s/%s (%zu instructions, %zu/%d bytes of RTC_SLOW_MEM)\n",
+           entry->preset, entry->name, ulp.size(), usedBytes, CONFIG_ULP_COPROC_RESERVE_MEM);
+
+    std::vector<uint64_t> activePerSecond;
+    if (!ulp.run(seconds, activePerSecond))
+        return 2;
+
+    // Only whole seconds contribute to the per-window statistics
+    size_t windows = (size_t)seconds;
+    uint64_t total = 0, minCycles = UINT64_MAX, maxCycles = 0;
+    for (size_t s = 0; s < windows; s++)
+    {
+        uint64_t c = activePerSecond[s];
+        total += c;
+        minCycles = c < minCycles ? c : minCycles;
+        maxCycles = c > maxCycles ? c : maxCycles;
+        if (verbose)
+            printf("  window %5zu: %llu cycles\n", s, (unsigned long long)c);
+    }
+    if (windows == 0)
+        minCycles = 0;
+
+    double meanCycles = windows ? (double)total / windows : 0;
+    double duty = 100.0 * meanCycles / clockHz;
+    if (duty > 100.0)
+        duty = 100.0; // last instruction of a window may spill into the next
+    double avgUA = sleepUA + ulpUA * duty / 100.0;
+
+    printf("simulated:      %.1f s at %.2f MHz\n", seconds, clockHz / 1e6);
+    printf("cycles/window:  mean %.0f, min %llu, max %llu\n", meanCycles,
+           (unsigned long long)minCycles, (unsigned long long)maxCycles);
+    printf("ULP duty cycle: %.3f%%\n", duty);
+    double windowMs = ulp.windowSeconds() * 1000.0;
+    double windowError = windowMs > 0 ? 100.0 * (windowMs - entry->windowMs) / entry->windowMs : 0;
+    if (windowMs > 0)
+        printf("window length:  %.2f ms (%+.2f%% of %u ms)\n", windowMs, windowError, entry->windowMs);
+    printf("est. current:   %.1f uA (%.1f sleep + %.1f ULP), %.3f uAh over run\n",
+           avgUA, sleepUA, avgUA - sleepUA, avgUA * seconds / 3600.0);
+
+    uint16_t pir = ulp.word(PIR_COUNT) & 0xFFFF;
+    uint16_t inactivity = ulp.word(INACTIVITY_COUNT) & 0xFFFF;
+    uint16_t tracker = ulp.word(INACTIVITY_TRACKER) & 0xFFFF;
+    printf("PIR_COUNT=%u INACTIVITY_COUNT=%u INACTIVITY_TRACKER=%u\n", pir, inactivity, tracker);
+    for (int i = 1; i < ULP_INACTIVITY_THRESHOLDS; i++)
+    {
+        printf("threshold %d:    period %u, count %u\n", i,
+               ulp.word(ULP_INACTIVITY_WORD(INACTIVITY_PERIOD, i)) & 0xFFFF,
+               ulp.word(ULP_INACTIVITY_WORD(INACTIVITY_COUNT, i)) & 0xFFFF);
+    }
+    uint16_t longestBout = ulp.word(LONGEST_BOUT) & 0xFFFF;
+    uint16_t bouts = ulp.word(BOUT_COUNT) & 0xFFFF;
+    printf("bouts:          %u inactive bouts, longest %u windows\n", bouts, longestBout);
+
+    // Drain the event ring buffer the same way ULPManager::readEvents() does
+    uint16_t head = ulp.word(EVENT_HEAD) & 0xFFFF;
+    uint16_t tail = ulp.word(EVENT_TAIL) & 0xFFFF;
+    uint16_t pending = (uint16_t)(head - tail);
+    printf("events:         %u recorded, %u dropped, %u windows\n", pending,
+           ulp.word(EVENT_OVERFLOW) & 0xFFFF, ulp.word(WINDOW_TICK) & 0xFFFF);
+    for (uint16_t i = 0; i < pending && verbose; i++)
+    {
+        uint16_t e = ulp.word(EVENT_BUFFER + ((tail + i) & (ULP_EVENT_BUFFER_SIZE - 1))) & 0xFFFF;
+        printf("  window %5u: %s\n", e & ULP_EVENT_TICK_MASK, (e & ULP_EVENT_OFFSET_BIT) ? "offset" : "onset");
+    }
+
+    int failures = 0;
+    if (usedBytes > CONFIG_ULP_COPROC_RESERVE_MEM)
+    {
+        printf("FAIL: program needs %zu bytes, only %d reserved\n", usedBytes, CONFIG_ULP_COPROC_RESERVE_MEM);
+        failures++;
+    }
+    if (ulp.unwrittenEvents() > 0)
+    {
+        printf("FAIL: %u events published before their word was stored\n", ulp.unwrittenEvents());
+        failures++;
+    }
+    if (windowError > maxWindowError || windowError < -maxWindowError)
+    {
+        printf("FAIL: window length off by %+.2f%%, tolerance %.2f%%\n", windowError, maxWindowError);
+        failures++;
+    }
+    if (maxDuty >= 0 && duty > maxDuty)
+    {
+        printf("FAIL: duty %.3f%% exceeds %.3f%%\n", duty, maxDuty);
+        failures++;
+    }
+    if (maxCyclesPerSecond >= 0 && meanCycles > maxCyclesPerSecond)
+    {
+        printf("FAIL: %.0f cycles/s exceeds %.0f\n", meanCycles, maxCyclesPerSecond);
+        failures++;
+    }
+    if (expectPIR >= 0 && pir != expectPIR)
+    {
+        printf("FAIL: PIR_COUNT %u, expected %ld\n", pir, expectPIR);
+        failures++;
+    }
+    if (expectInactivity >= 0 && inactivity != expectInactivity)
+    {
+        printf("FAIL: INACTIVITY_COUNT %u, expected %ld\n", inactivity, expectInactivity);
+        failures++;
+    }
+    if (expectTracker >= 0 && tracker != expectTracker)
+    {
+        printf("FAIL: INACTIVITY_TRACKER %u, expected %ld\n", tracker, expectTracker);
+        failures++;
+    }
+    if (expectEvents >= 0 && pending != expectEvents)
+    {
+        printf("FAIL: %u events, expected %ld\n", pending, expectEvents);
+        failures++;
+    }
+    if (expectLongestBout >= 0 && longestBout != expectLongestBout)
+    {
+        printf("FAIL: LONGEST_BOUT %u, expected %ld\n", longestBout, expectLongestBout);
+        failures++;
+    }
+    if (expectBouts >= 0 && bouts != expectBouts)
+    {
+        printf("FAIL: BOUT_COUNT %u, expected %ld\n", bouts, expectBouts);
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
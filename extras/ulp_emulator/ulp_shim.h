@@ -0,0 +1,93 @@
+#ifndef ULP_SHIM_H
+#define ULP_SHIM_H
+
+// Host-side stand-in for the subset of esp32s3/ulp.h used by src/ULPProgram.h.
+// Each macro produces one table entry that the emulator interprets directly;
+// M_LABEL pseudo-entries are resolved at load time the same way
+// ulp_process_macros_and_load() does on the device.
+
+#include <stdint.h>
+
+#ifndef CONFIG_ULP_COPROC_RESERVE_MEM
+#define CONFIG_ULP_COPROC_RESERVE_MEM 512 // arduino-esp32 default for ESP32-S3
+#endif
+
+enum ulp_shim_op_t
+{
+    SHIM_LABEL, // pseudo-instruction, removed at load time
+    SHIM_MOVI,
+    SHIM_MOVR,
+    SHIM_ADDI,
+    SHIM_SUBI,
+    SHIM_ADDR,
+    SHIM_SUBR,
+    SHIM_ANDI,
+    SHIM_ORI,
+    SHIM_ANDR,
+    SHIM_ORR,
+    SHIM_LSHI,
+    SHIM_RSHI,
+    SHIM_LD,
+    SHIM_ST,
+    SHIM_RD_REG,
+    SHIM_WR_REG,
+    SHIM_DELAY,
+    SHIM_HALT,
+    SHIM_BX,  // unconditional branch to label
+    SHIM_BL,  // branch to label if R0 < imm
+    SHIM_BLE, // branch to label if R0 <= imm
+    SHIM_BE,  // branch to label if R0 == imm
+    SHIM_BG,  // branch to label if R0 > imm
+    SHIM_BGE, // branch to label if R0 >= imm
+};
+
+typedef struct
+{
+    uint8_t op;
+    uint8_t rd;     // destination / value register
+    uint8_t rs;     // source / address register
+    uint32_t imm;   // immediate, offset, compare value or register address
+    uint16_t label; // label number for M_LABEL and branches
+    uint8_t low;    // RD_REG/WR_REG bit range
+    uint8_t high;
+} ulp_insn_t;
+
+#define R0 0
+#define R1 1
+#define R2 2
+#define R3 3
+
+// Peripheral registers the programs touch. Values only need to be unique.
+#define RTC_GPIO_IN_REG 0x1
+#define RTC_GPIO_OUT_REG 0x2
+#define RTC_GPIO_IN_NEXT_S 10
+#define RTC_GPIO_OUT_DATA_S 10
+
+#define I_MOVI(rd, imm) {SHIM_MOVI, (uint8_t)(rd), 0, (uint32_t)(imm), 0, 0, 0}
+#define I_MOVR(rd, rs) {SHIM_MOVR, (uint8_t)(rd), (uint8_t)(rs), 0, 0, 0, 0}
+#define I_ADDI(rd, rs, imm) {SHIM_ADDI, (uint8_t)(rd), (uint8_t)(rs), (uint32_t)(imm), 0, 0, 0}
+#define I_SUBI(rd, rs, imm) {SHIM_SUBI, (uint8_t)(rd), (uint8_t)(rs), (uint32_t)(imm), 0, 0, 0}
+#define I_ADDR(rd, rs1, rs2) {SHIM_ADDR, (uint8_t)(rd), (uint8_t)(rs1), (uint32_t)(rs2), 0, 0, 0}
+#define I_SUBR(rd, rs1, rs2) {SHIM_SUBR, (uint8_t)(rd), (uint8_t)(rs1), (uint32_t)(rs2), 0, 0, 0}
+#define I_ANDI(rd, rs, imm) {SHIM_ANDI, (uint8_t)(rd), (uint8_t)(rs), (uint32_t)(imm), 0, 0, 0}
+#define I_ORI(rd, rs, imm) {SHIM_ORI, (uint8_t)(rd), (uint8_t)(rs), (uint32_t)(imm), 0, 0, 0}
+#define I_ANDR(rd, rs1, rs2) {SHIM_ANDR, (uint8_t)(rd), (uint8_t)(rs1), (uint32_t)(rs2), 0, 0, 0}
+#define I_ORR(rd, rs1, rs2) {SHIM_ORR, (uint8_t)(rd), (uint8_t)(rs1), (uint32_t)(rs2), 0, 0, 0}
+#define I_LSHI(rd, rs, imm) {SHIM_LSHI, (uint8_t)(rd), (uint8_t)(rs), (uint32_t)(imm), 0, 0, 0}
+#define I_RSHI(rd, rs, imm) {SHIM_RSHI, (uint8_t)(rd), (uint8_t)(rs), (uint32_t)(imm), 0, 0, 0}
+#define I_LD(rd, rs, offset) {SHIM_LD, (uint8_t)(rd), (uint8_t)(rs), (uint32_t)(offset), 0, 0, 0}
+#define I_ST(rd, rs, offset) {SHIM_ST, (uint8_t)(rd), (uint8_t)(rs), (uint32_t)(offset), 0, 0, 0}
+#define I_RD_REG(reg, low, high) {SHIM_RD_REG, 0, 0, (uint32_t)(reg), 0, (uint8_t)(low), (uint8_t)(high)}
+#define I_WR_REG(reg, low, high, val) {SHIM_WR_REG, (uint8_t)(val), 0, (uint32_t)(reg), 0, (uint8_t)(low), (uint8_t)(high)}
+#define I_DELAY(cycles) {SHIM_DELAY, 0, 0, (uint32_t)(cycles), 0, 0, 0}
+#define I_HALT() {SHIM_HALT, 0, 0, 0, 0, 0, 0}
+
+#define M_LABEL(n) {SHIM_LABEL, 0, 0, 0, (uint16_t)(n), 0, 0}
+#define M_BX(n) {SHIM_BX, 0, 0, 0, (uint16_t)(n), 0, 0}
+#define M_BL(n, v) {SHIM_BL, 0, 0, (uint32_t)(v), (uint16_t)(n), 0, 0}
+#define M_BLE(n, v) {SHIM_BLE, 0, 0, (uint32_t)(v), (uint16_t)(n), 0, 0}
+#define M_BE(n, v) {SHIM_BE, 0, 0, (uint32_t)(v), (uint16_t)(n), 0, 0}
+#define M_BG(n, v) {SHIM_BG, 0, 0, (uint32_t)(v), (uint16_t)(n), 0, 0}
+#define M_BGE(n, v) {SHIM_BGE, 0, 0, (uint32_t)(v), (uint16_t)(n), 0, 0}
+
+#endif
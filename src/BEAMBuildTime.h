@@ -0,0 +1,50 @@
+#ifndef BEAM_BUILD_TIME_H
+#define BEAM_BUILD_TIME_H
+
+// Build time as Unix seconds, evaluated by the compiler from __DATE__
+// ("Mmm dd yyyy", day space-padded) and __TIME__ ("hh:mm:ss"), so boot
+// code compares one integer instead of parsing strings. Local time of the
+// build machine, as the RTC keeps it. Host-buildable.
+#include <stdint.h>
+
+constexpr int beamBuildDigit(char c)
+{
+    return c >= '0' && c <= '9' ? c - '0' : 0;
+}
+
+constexpr int beamBuildMonth(const char *date)
+{
+    // Jan Feb Mar Apr May Jun Jul Aug Sep Oct Nov Dec
+    return date[0] == 'J' ? (date[1] == 'a' ? 1 : date[2] == 'n' ? 6 : 7)
+           : date[0] == 'F' ? 2
+           : date[0] == 'M' ? (date[2] == 'r' ? 3 : 5)
+           : date[0] == 'A' ? (date[1] == 'p' ? 4 : 8)
+           : date[0] == 'S' ? 9
+           : date[0] == 'O' ? 10
+           : date[0] == 'N' ? 11
+                            : 12;
+}
+
+// Days since 1970-01-01 (inverse of beamCivilTime() in LogFormat.h)
+constexpr uint32_t beamDaysFromCivil(int year, int month, int day)
+{
+    int y = year - (month <= 2); // Years start in March, so leap days come last
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+constexpr uint32_t beamBuildEpoch(const char *date, const char *time)
+{
+    return beamDaysFromCivil(beamBuildDigit(date[7]) * 1000 + beamBuildDigit(date[8]) * 100 +
+                                 beamBuildDigit(date[9]) * 10 + beamBuildDigit(date[10]),
+                             beamBuildMonth(date), beamBuildDigit(date[4]) * 10 + beamBuildDigit(date[5])) *
+               86400u +
+           (beamBuildDigit(time[0]) * 10 + beamBuildDigit(time[1])) * 3600u +
+           (beamBuildDigit(time[3]) * 10 + beamBuildDigit(time[4])) * 60u +
+           beamBuildDigit(time[6]) * 10 + beamBuildDigit(time[7]);
+}
+
+#endif
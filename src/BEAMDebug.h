@@ -0,0 +1,78 @@
+#ifndef BEAM_DEBUG_H
+#define BEAM_DEBUG_H
+
+// Serial diagnostics with compile-time levels and per-module enables. A call
+// above BEAM_DEBUG_LEVEL or in a disabled module is dead code, arguments
+// included, so release builds neither format nor build String temporaries.
+// Set from build flags, e.g. -DBEAM_DEBUG_LEVEL=BEAM_DEBUG_WARN -DBEAM_DEBUG_ULP=0
+// Host-includable: without Arduino the output goes to stderr.
+
+#define BEAM_DEBUG_NONE 0
+#define BEAM_DEBUG_ERROR 1   // Something failed
+#define BEAM_DEBUG_WARN 2    // Degraded, carrying on
+#define BEAM_DEBUG_INFO 3    // Startup report, each wake's record, flushes, sleep
+#define BEAM_DEBUG_VERBOSE 4 // Step by step progress, ULP counter reads
+#define BEAM_DEBUG_TRACE 5   // I2C transfers byte by byte
+
+#ifndef BEAM_DEBUG_LEVEL
+#define BEAM_DEBUG_LEVEL BEAM_DEBUG_TRACE // Everything, as before levels existed
+#endif
+
+// Modules (1 = enabled)
+#ifndef BEAM_DEBUG_CORE
+#define BEAM_DEBUG_CORE 1 // HublinkBEAM
+#endif
+#ifndef BEAM_DEBUG_STORAGE
+#define BEAM_DEBUG_STORAGE 1 // Log files (BEAMLogWriter)
+#endif
+#ifndef BEAM_DEBUG_STATE
+#define BEAM_DEBUG_STATE 1 // RTC state block
+#endif
+#ifndef BEAM_DEBUG_ULP
+#define BEAM_DEBUG_ULP 1 // ULPManager
+#endif
+#ifndef BEAM_DEBUG_PIR
+#define BEAM_DEBUG_PIR 1 // ZDP323
+#endif
+#ifndef BEAM_DEBUG_RTC
+#define BEAM_DEBUG_RTC 1 // RTCManager
+#endif
+
+#define BEAM_DEBUG_ENABLED(level, module) (BEAM_DEBUG_LEVEL >= (level) && BEAM_DEBUG_##module)
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#define BEAM_DEBUG_OUTPUT(...) Serial.printf(__VA_ARGS__)
+#define BEAM_DEBUG_DRAIN() Serial.flush()
+#else
+#include <stdio.h>
+#define BEAM_DEBUG_OUTPUT(...) fprintf(stderr, __VA_ARGS__)
+#define BEAM_DEBUG_DRAIN() fflush(stderr)
+#endif
+
+#define BEAM_PRINTF(level, module, ...)        \
+    do                                         \
+    {                                          \
+        if (BEAM_DEBUG_ENABLED(level, module)) \
+        {                                      \
+            BEAM_DEBUG_OUTPUT(__VA_ARGS__);    \
+        }                                      \
+    } while (0)
+
+#define BEAM_ERRORF(module, ...) BEAM_PRINTF(BEAM_DEBUG_ERROR, module, __VA_ARGS__)
+#define BEAM_WARNF(module, ...) BEAM_PRINTF(BEAM_DEBUG_WARN, module, __VA_ARGS__)
+#define BEAM_INFOF(module, ...) BEAM_PRINTF(BEAM_DEBUG_INFO, module, __VA_ARGS__)
+#define BEAM_VERBOSEF(module, ...) BEAM_PRINTF(BEAM_DEBUG_VERBOSE, module, __VA_ARGS__)
+#define BEAM_TRACEF(module, ...) BEAM_PRINTF(BEAM_DEBUG_TRACE, module, __VA_ARGS__)
+
+// Waits for library output to drain; nothing to wait for when it is compiled out
+#define BEAM_DEBUG_FLUSH()                      \
+    do                                          \
+    {                                           \
+        if (BEAM_DEBUG_LEVEL > BEAM_DEBUG_NONE) \
+        {                                       \
+            BEAM_DEBUG_DRAIN();                 \
+        }                                       \
+    } while (0)
+
+#endif
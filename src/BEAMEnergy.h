@@ -0,0 +1,165 @@
+#ifndef BEAM_ENERGY_H
+#define BEAM_ENERGY_H
+
+// Energy model for one wake/sleep cycle: phase durations (a BEAMWakeProfile,
+// measured or typical) times per-phase currents, plus deep sleep at the
+// current of the ULP mode and a share of each Hublink sync, projected onto a
+// battery capacity. Sleep currents are the ULP-Power.xlsx bench measurements;
+// awake currents are typical values for the Feather ESP32-S3 at 80 MHz and
+// should be replaced with measured ones. Host-buildable, see extras/energy_model.
+#include <stdint.h>
+#include "BEAMProfile.h"
+
+#define BEAM_ENERGY_CPU_MA 25.0f               // Awake at 80 MHz, SD card off
+#define BEAM_ENERGY_SD_MA 45.0f                // Awake with the SD card powered and busy
+#define BEAM_ENERGY_SYNC_MA 90.0f              // Radio on during hublink.sync()
+#define BEAM_ENERGY_LIGHT_SLEEP_MA 1.0f        // Light sleep while sensors convert
+#define BEAM_ENERGY_SLEEP_CONTINUOUS_UA 278.0f // ULP-Power.xlsx: ULP MOTION_FLAG loop, RT9080 pull-down removed
+#define BEAM_ENERGY_SLEEP_TIMER_UA 150.0f      // ULP-Power.xlsx: ULP halted between timer wakeups
+#define BEAM_ENERGY_BATTERY_MAH 2000           // Default capacity for projections
+#define BEAM_ENERGY_USABLE_FRACTION 0.8f       // Share of capacity above LOW_BATTERY_THRESHOLD
+
+struct BEAMEnergyCurrents
+{
+    float phaseMA[BEAM_PHASE_COUNT]; // Awake, per BEAMWakePhase
+    float otherMA;                   // Awake outside the library phases
+    float syncMA;                    // During a Hublink sync
+    float sleepContinuousUA;         // Deep sleep, ULP_MODE_CONTINUOUS
+    float sleepTimerUA;              // Deep sleep, ULP_MODE_TIMER
+};
+
+struct BEAMEnergyConfig
+{
+    uint32_t sleepSeconds;     // beam.sleep() minutes * 60
+    uint32_t syncEveryMinutes; // Hublink sync interval (0 = no sync)
+    uint32_t syncSeconds;      // Length of one sync
+    bool ulpTimerMode;         // ULP_MODE_TIMER instead of the busy loop
+    float sdShare;             // Share of wakes that flush: 1 / log batch size for a flush wake's
+                               // profile, 1 for profiles averaged over a whole batch
+    float batteryMAh;
+    float usableFraction;
+};
+
+struct BEAMEnergyEstimate
+{
+    float awakeUAh; // Charge per cycle while awake
+    float syncUAh;  // Share of a sync per cycle
+    float sleepUAh; // Charge per cycle in deep sleep
+    float cycleUAh; // All of the above
+    float cycleSeconds;
+    float averageUA; // Over the whole cycle
+    float days;      // Projected runtime on the usable capacity
+};
+
+// Phases that run with the SD card powered
+inline bool beamIsSDPhase(int phase)
+{
+    return phase == BEAM_PHASE_SD_INIT || phase == BEAM_PHASE_SD_CHECK ||
+           phase == BEAM_PHASE_FILE_SELECT || phase == BEAM_PHASE_FILE_WRITE || phase == BEAM_PHASE_EVENTS;
+}
+
+inline BEAMEnergyCurrents beamDefaultCurrents()
+{
+    BEAMEnergyCurrents currents;
+    for (int phase = 0; phase < BEAM_PHASE_COUNT; phase++)
+    {
+        currents.phaseMA[phase] = beamIsSDPhase(phase) ? BEAM_ENERGY_SD_MA : BEAM_ENERGY_CPU_MA;
+    }
+    currents.phaseMA[BEAM_PHASE_SENSOR_WAIT] = BEAM_ENERGY_LIGHT_SLEEP_MA;
+    currents.otherMA = BEAM_ENERGY_CPU_MA;
+    currents.syncMA = BEAM_ENERGY_SYNC_MA;
+    currents.sleepContinuousUA = BEAM_ENERGY_SLEEP_CONTINUOUS_UA;
+    currents.sleepTimerUA = BEAM_ENERGY_SLEEP_TIMER_UA;
+    return currents;
+}
+
+inline BEAMEnergyConfig beamDefaultEnergyConfig(uint32_t sleepMinutes)
+{
+    return {sleepMinutes * 60, 0, 0, false, 1.0f, (float)BEAM_ENERGY_BATTERY_MAH, BEAM_ENERGY_USABLE_FRACTION};
+}
+
+// Rough durations of a timer wake that flushes to the SD card at the default
+// debug level, for estimates without a measured profile
+inline BEAMWakeProfile beamTypicalWakeProfile()
+{
+    BEAMWakeProfile profile = {};
+    uint32_t *us = profile.phaseMicros;
+    us[BEAM_PHASE_STARTUP] = 250000;
+    us[BEAM_PHASE_SERIAL] = 1000;
+    us[BEAM_PHASE_SD_INIT] = 90000; // 50 ms power-up delay, SD.begin()
+    us[BEAM_PHASE_BATTERY_INIT] = 15000;
+    us[BEAM_PHASE_ENV_INIT] = 8000;
+    us[BEAM_PHASE_LIGHT_INIT] = 3000;
+    us[BEAM_PHASE_RTC_INIT] = 15000;
+    us[BEAM_PHASE_PIR_INIT] = 5000;
+    us[BEAM_PHASE_SENSOR_READ] = 5000;
+    us[BEAM_PHASE_SENSOR_WAIT] = 10000; // BME280 forced measurement, VEML7700 unchanged
+    us[BEAM_PHASE_SD_CHECK] = 5000;
+    us[BEAM_PHASE_FILE_SELECT] = 3000;
+    us[BEAM_PHASE_FILE_WRITE] = 15000;
+    us[BEAM_PHASE_SLEEP_PREP] = 5000;
+    us[BEAM_PHASE_SERIAL_FLUSH] = 2000;
+    for (int phase = 0; phase < BEAM_PHASE_COUNT; phase++)
+    {
+        profile.awakeMicros += us[phase];
+    }
+    return profile;
+}
+
+// Charge in µAh of `micros` at `milliamps`
+inline float beamChargeUAh(float micros, float milliamps)
+{
+    return micros * milliamps / 3.6e6f;
+}
+
+// Awake charge of one wake; sdShare scales the SD phases (see BEAMEnergyConfig)
+inline float beamWakeChargeUAh(const BEAMWakeProfile &profile, const BEAMEnergyCurrents &currents, float sdShare = 1.0f)
+{
+    float charge = 0;
+    uint32_t accounted = 0;
+    for (int phase = 0; phase < BEAM_PHASE_COUNT; phase++)
+    {
+        float share = beamIsSDPhase(phase) ? sdShare : 1.0f;
+        charge += beamChargeUAh(profile.phaseMicros[phase] * share, currents.phaseMA[phase]);
+        accounted += profile.phaseMicros[phase];
+    }
+    if (profile.awakeMicros > accounted)
+    {
+        charge += beamChargeUAh(profile.awakeMicros - accounted, currents.otherMA);
+    }
+    return charge;
+}
+
+inline BEAMEnergyEstimate beamEstimateEnergy(const BEAMWakeProfile &profile, const BEAMEnergyConfig &config,
+                                             const BEAMEnergyCurrents &currents)
+{
+    BEAMEnergyEstimate estimate = {};
+    float sleepUA = config.ulpTimerMode ? currents.sleepTimerUA : currents.sleepContinuousUA;
+    float awakeSeconds = 0;
+    for (int phase = 0; phase < BEAM_PHASE_COUNT; phase++)
+    {
+        awakeSeconds -= profile.phaseMicros[phase] * (beamIsSDPhase(phase) ? 1.0f - config.sdShare : 0.0f) / 1e6f;
+    }
+    awakeSeconds += profile.awakeMicros / 1e6f;
+
+    // One sync every syncEveryMinutes, spread over the cycles in between
+    float syncSeconds = 0;
+    if (config.syncEveryMinutes > 0)
+    {
+        float cyclesPerSync = config.syncEveryMinutes * 60.0f / (config.sleepSeconds > 0 ? config.sleepSeconds : 1);
+        syncSeconds = config.syncSeconds / (cyclesPerSync > 1.0f ? cyclesPerSync : 1.0f);
+    }
+
+    estimate.awakeUAh = beamWakeChargeUAh(profile, currents, config.sdShare);
+    estimate.syncUAh = beamChargeUAh(syncSeconds * 1e6f, currents.syncMA);
+    estimate.sleepUAh = sleepUA * config.sleepSeconds / 3600.0f;
+    estimate.cycleUAh = estimate.awakeUAh + estimate.syncUAh + estimate.sleepUAh;
+    estimate.cycleSeconds = awakeSeconds + syncSeconds + config.sleepSeconds;
+    estimate.averageUA = estimate.cycleSeconds > 0 ? estimate.cycleUAh * 3600.0f / estimate.cycleSeconds : 0;
+    estimate.days = estimate.averageUA > 0
+                        ? config.batteryMAh * config.usableFraction * 1000.0f / estimate.averageUA / 24.0f
+                        : 0;
+    return estimate;
+}
+
+#endif
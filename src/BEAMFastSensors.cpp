@@ -0,0 +1,303 @@
+#include "BEAMFastSensors.h"
+
+#define MAX17048_ADDRESS 0x36
+#define MAX17048_REG_VCELL 0x02
+#define MAX17048_REG_SOC 0x04
+#define MAX17048_REG_CONFIG 0x0C
+#define MAX17048_REG_CRATE 0x16
+#define MAX17048_CONFIG_SLEEP 0x0080
+
+#define BME280_ADDRESS 0x77
+#define BME280_REG_CALIB_TP 0x88
+#define BME280_REG_CALIB_H 0xE1
+#define BME280_REG_CTRL_HUM 0xF2 // Followed by status, ctrl_meas, config
+#define BME280_REG_STATUS 0xF3
+#define BME280_REG_CTRL_MEAS 0xF4
+#define BME280_REG_DATA 0xF7 // press[3], temp[3], hum[2]
+#define BME280_STATUS_MEASURING 0x08
+#define BME280_MODE_MASK 0x03
+#define BME280_MODE_FORCED 0x01
+
+#define VEML7700_ADDRESS 0x10
+#define VEML7700_REG_ALS_CONF_0 0x00
+#define VEML7700_REG_ALS 0x04
+#define VEML7700_REG_WHITE 0x05
+
+bool BEAMFastSensors::readMAX17048(uint8_t reg, uint16_t &value)
+{
+    uint8_t data[2];
+    if (!_wire.readRegisters(MAX17048_ADDRESS, reg, data, 2))
+    {
+        return false;
+    }
+    value = data[0] << 8 | data[1]; // MSB first
+    return true;
+}
+
+bool BEAMFastSensors::readVEML7700(uint8_t reg, uint16_t &value)
+{
+    uint8_t data[2];
+    if (!_wire.readRegisters(VEML7700_ADDRESS, reg, data, 2))
+    {
+        return false;
+    }
+    value = data[0] | data[1] << 8; // LSB first
+    return true;
+}
+
+bool BEAMFastSensors::captureBattery()
+{
+    _cache.valid &= ~BEAM_SENSOR_BATTERY;
+    uint16_t config;
+    if (!readMAX17048(MAX17048_REG_CONFIG, config))
+    {
+        return false;
+    }
+    _maxConfig = config;
+    _cache.maxRcomp = config >> 8;
+    _cache.valid |= BEAM_SENSOR_BATTERY;
+    return true;
+}
+
+bool BEAMFastSensors::resumeBattery()
+{
+    uint16_t config;
+    if (!(_cache.valid & BEAM_SENSOR_BATTERY) || !readMAX17048(MAX17048_REG_CONFIG, config) ||
+        (config >> 8) != _cache.maxRcomp)
+    {
+        return false;
+    }
+    _maxConfig = config & ~MAX17048_CONFIG_SLEEP;
+    if (config & MAX17048_CONFIG_SLEEP)
+    {
+        uint8_t data[2] = {(uint8_t)(_maxConfig >> 8), (uint8_t)_maxConfig};
+        if (!_wire.writeRegisters(MAX17048_ADDRESS, MAX17048_REG_CONFIG, data, 2))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+float BEAMFastSensors::batteryVoltage()
+{
+    uint16_t vcell;
+    return readMAX17048(MAX17048_REG_VCELL, vcell) ? vcell * 78.125f / 1000000.0f : NAN; // 78.125 uV per bit
+}
+
+float BEAMFastSensors::batteryPercent()
+{
+    uint16_t soc;
+    return readMAX17048(MAX17048_REG_SOC, soc) ? soc / 256.0f : NAN;
+}
+
+float BEAMFastSensors::batteryChargeRate()
+{
+    uint16_t crate;
+    return readMAX17048(MAX17048_REG_CRATE, crate) ? (int16_t)crate * 0.208f : NAN; // 0.208 %/hour per bit
+}
+
+bool BEAMFastSensors::sleepBattery()
+{
+    // Sleep is enabled in MODE by the full init and survives until a reset
+    uint16_t config = _maxConfig | MAX17048_CONFIG_SLEEP;
+    uint8_t data[2] = {(uint8_t)(config >> 8), (uint8_t)config};
+    return _wire.writeRegisters(MAX17048_ADDRESS, MAX17048_REG_CONFIG, data, 2);
+}
+
+bool BEAMFastSensors::captureEnvironment()
+{
+    _cache.valid &= ~BEAM_SENSOR_ENV;
+    uint8_t tp[BEAM_BME280_CALIB_TP_SIZE];
+    uint8_t h[BEAM_BME280_CALIB_H_SIZE];
+    uint8_t control[4]; // ctrl_hum, status, ctrl_meas, config
+    if (!_wire.readRegisters(BME280_ADDRESS, BME280_REG_CALIB_TP, tp, sizeof(tp)) ||
+        !_wire.readRegisters(BME280_ADDRESS, BME280_REG_CALIB_H, h, sizeof(h)) ||
+        !_wire.readRegisters(BME280_ADDRESS, BME280_REG_CTRL_HUM, control, sizeof(control)))
+    {
+        return false;
+    }
+    _cache.bme = beamParseBME280Calibration(tp, h);
+    _cache.bmeCtrlHum = control[0];
+    _cache.bmeCtrlMeas = control[2] & ~BME280_MODE_MASK;
+    _cache.bmeConfig = control[3];
+    _cache.valid |= BEAM_SENSOR_ENV;
+    return true;
+}
+
+bool BEAMFastSensors::resumeEnvironment()
+{
+    // A forced measurement leaves the chip in sleep mode with ctrl_meas
+    // intact; a reset or brownout would have cleared the oversampling bits
+    uint8_t control[4];
+    return (_cache.valid & BEAM_SENSOR_ENV) &&
+           _wire.readRegisters(BME280_ADDRESS, BME280_REG_CTRL_HUM, control, sizeof(control)) &&
+           control[0] == _cache.bmeCtrlHum &&
+           (control[2] & ~BME280_MODE_MASK) == _cache.bmeCtrlMeas &&
+           control[3] == _cache.bmeConfig;
+}
+
+bool BEAMFastSensors::measureEnvironment()
+{
+    if (!startEnvironment())
+    {
+        return false;
+    }
+    delay(BEAM_BME280_MEASURE_MS);
+    return collectEnvironment();
+}
+
+bool BEAMFastSensors::startEnvironment()
+{
+    _envMeasured = false;
+    _temperature = _pressure = _humidity = NAN;
+    _envStartMillis = millis();
+    return _wire.writeRegister(BME280_ADDRESS, BME280_REG_CTRL_MEAS, _cache.bmeCtrlMeas | BME280_MODE_FORCED);
+}
+
+bool BEAMFastSensors::collectEnvironment()
+{
+    uint8_t status = BME280_STATUS_MEASURING;
+    for (uint8_t polls = 0; polls < 10 && (status & BME280_STATUS_MEASURING); polls++)
+    {
+        if (polls > 0)
+        {
+            delay(1);
+        }
+        if (!_wire.readRegisters(BME280_ADDRESS, BME280_REG_STATUS, &status, 1))
+        {
+            return false;
+        }
+    }
+
+    uint8_t data[8];
+    if (!_wire.readRegisters(BME280_ADDRESS, BME280_REG_DATA, data, sizeof(data)))
+    {
+        return false;
+    }
+    int32_t adcP = (int32_t)data[0] << 12 | data[1] << 4 | data[2] >> 4;
+    int32_t adcT = (int32_t)data[3] << 12 | data[4] << 4 | data[5] >> 4;
+    int32_t adcH = data[6] << 8 | data[7];
+
+    // Skipped measurements read as 0x80000 / 0x8000, which Adafruit_BME280 reports as NAN
+    if (adcT != 0x80000)
+    {
+        int32_t tFine = beamBME280TFine(_cache.bme, adcT);
+        _temperature = beamBME280Temperature(tFine);
+        _pressure = adcP != 0x80000 ? beamBME280Pressure(_cache.bme, tFine, adcP) : NAN;
+        _humidity = adcH != 0x8000 ? beamBME280Humidity(_cache.bme, tFine, adcH) : NAN;
+    }
+    _envMeasured = true;
+    return true;
+}
+
+float BEAMFastSensors::temperature()
+{
+    if (!_envMeasured)
+    {
+        measureEnvironment();
+    }
+    return _temperature;
+}
+
+float BEAMFastSensors::pressure()
+{
+    if (!_envMeasured)
+    {
+        measureEnvironment();
+    }
+    return _pressure;
+}
+
+float BEAMFastSensors::humidity()
+{
+    if (!_envMeasured)
+    {
+        measureEnvironment();
+    }
+    return _humidity;
+}
+
+bool BEAMFastSensors::captureLight()
+{
+    _cache.valid &= ~BEAM_SENSOR_LIGHT;
+    uint16_t config;
+    if (!readVEML7700(VEML7700_REG_ALS_CONF_0, config))
+    {
+        return false;
+    }
+    _cache.vemlConfig = config;
+    _cache.valid |= BEAM_SENSOR_LIGHT;
+    _lightConfigMillis = millis() | 1; // The driver has just written the configuration
+    return true;
+}
+
+bool BEAMFastSensors::resumeLight()
+{
+    // The ALS integrates continuously while the ESP32 sleeps, so with an
+    // unchanged configuration the data registers already hold a fresh value
+    uint16_t config;
+    return (_cache.valid & BEAM_SENSOR_LIGHT) && readVEML7700(VEML7700_REG_ALS_CONF_0, config) &&
+           config == _cache.vemlConfig;
+}
+
+bool BEAMFastSensors::setLightConfig(uint16_t mask, uint16_t value)
+{
+    uint16_t config = (_cache.vemlConfig & ~mask) | (value & mask);
+    if (config == _cache.vemlConfig)
+    {
+        return true; // The sketch reapplies its settings every wake; nothing to write
+    }
+    uint8_t data[2] = {(uint8_t)config, (uint8_t)(config >> 8)};
+    if (!_wire.writeRegisters(VEML7700_ADDRESS, VEML7700_REG_ALS_CONF_0, data, 2))
+    {
+        return false;
+    }
+    _cache.vemlConfig = config;
+    _lightConfigMillis = millis() | 1; // 0 means no change this wake
+    return true;
+}
+
+uint32_t BEAMFastSensors::lightDueMillis()
+{
+    // As Adafruit_VEML7700::readWait(): the integration under way at the
+    // change is discarded, so allow two
+    uint32_t now = millis();
+    if (_lightConfigMillis == 0 || now - _lightConfigMillis >= 2u * beamVEML7700IntegrationMs(_cache.vemlConfig))
+    {
+        _lightConfigMillis = 0;
+        return now;
+    }
+    return _lightConfigMillis + 2 * beamVEML7700IntegrationMs(_cache.vemlConfig);
+}
+
+void BEAMFastSensors::waitForLight()
+{
+    int32_t remaining = (int32_t)(lightDueMillis() - millis());
+    if (remaining > 0)
+    {
+        delay(remaining);
+    }
+    _lightConfigMillis = 0;
+}
+
+uint16_t BEAMFastSensors::readALS()
+{
+    waitForLight();
+    uint16_t value = 0;
+    readVEML7700(VEML7700_REG_ALS, value);
+    return value;
+}
+
+uint16_t BEAMFastSensors::readWhite()
+{
+    waitForLight();
+    uint16_t value = 0;
+    readVEML7700(VEML7700_REG_WHITE, value);
+    return value;
+}
+
+float BEAMFastSensors::lux()
+{
+    return readALS() * beamVEML7700Resolution(_cache.vemlConfig); // As readLux(VEML_LUX_NORMAL)
+}
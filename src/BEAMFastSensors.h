@@ -0,0 +1,72 @@
+#ifndef BEAM_FAST_SENSORS_H
+#define BEAM_FAST_SENSORS_H
+
+#include <Arduino.h>
+#include "BEAMWire.h"
+#include "BEAMSensorCache.h"
+
+// Register-level access to the MAX17048, BME280 and VEML7700 for timer
+// wakes. The chips stay powered and configured while the ESP32 sleeps, so
+// instead of each driver's begin() (chip reset, calibration readout,
+// configuration writes, integration wait) a wake reads back a register or
+// two that the full init left in a known state and, if they still match
+// the cache, goes straight to the measurement. capture*() fills the cache
+// after a full init through the Adafruit drivers.
+class BEAMFastSensors
+{
+public:
+    explicit BEAMFastSensors(BEAMWire &wire) : _wire(wire) {}
+
+    BEAMSensorCache &cache() { return _cache; }
+
+    // After the driver's begin(): record what it configured
+    bool captureBattery();
+    bool captureEnvironment();
+    bool captureLight();
+
+    // Timer wake: true if the registers still match the cache
+    bool resumeBattery(); // Also takes the MAX17048 out of sleep mode
+    bool resumeEnvironment();
+    bool resumeLight();
+
+    // MAX17048
+    float batteryVoltage();
+    float batteryPercent();
+    float batteryChargeRate(); // %/hour, negative while discharging
+    bool sleepBattery();
+
+    // BME280, from the last forced measurement. start/collect split a
+    // measurement so other sensors can be read while it converts.
+    bool measureEnvironment(); // start, wait, collect
+    bool startEnvironment();
+    uint32_t environmentDueMillis() { return _envStartMillis + BEAM_BME280_MEASURE_MS; }
+    bool collectEnvironment();
+    float temperature();
+    float pressure(); // Pa, as Adafruit_BME280::readPressure()
+    float humidity();
+
+    // VEML7700; a configuration change (including a full init) discards
+    // the integration under way, so a reading waits until lightDueMillis()
+    uint32_t lightDueMillis();
+    uint16_t readALS();
+    uint16_t readWhite();
+    float lux();
+    bool setLightConfig(uint16_t mask, uint16_t value); // Gain or integration time bits
+
+private:
+    bool readMAX17048(uint8_t reg, uint16_t &value);
+    bool readVEML7700(uint8_t reg, uint16_t &value);
+    void waitForLight(); // Until a full integration after a configuration change
+
+    BEAMWire &_wire;
+    BEAMSensorCache _cache = {};
+    uint16_t _maxConfig = 0;    // MAX17048 CONFIG as read on resume
+    bool _envMeasured = false;  // A forced measurement completed this wake
+    uint32_t _envStartMillis = 0; // millis() when the last forced measurement started
+    float _temperature = NAN;
+    float _pressure = NAN;
+    float _humidity = NAN;
+    uint32_t _lightConfigMillis = 0; // millis() of the last ALS_CONF_0 write (0 = none this wake)
+};
+
+#endif
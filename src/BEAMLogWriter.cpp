@@ -0,0 +1,462 @@
+#include "BEAMLogWriter.h"
+#include "BEAMDebug.h"
+#include "LogCompress.h"
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#define LOG_MILLIS() millis()
+#else
+#include <time.h>
+#define LOG_MILLIS() ((uint32_t)(clock() * 1000.0 / CLOCKS_PER_SEC))
+#endif
+
+uint8_t BEAMLogWriter::writeRecords(const LogRecord *records, uint8_t count)
+{
+    uint8_t written = 0;
+    _selectMicros = 0;
+    while (written < count)
+    {
+        uint32_t day = records[written].timestamp / 86400;
+        char filename[BEAM_LOG_FILENAME_SIZE];
+        uint32_t selectStart = beamProfileMicros();
+
+        // Check if file exists, create it with header if it doesn't
+        if (!currentFilename(records[written].timestamp, filename) ||
+            (!_storage->exists(filename) && !createLogFile(filename)))
+        {
+            _selectMicros += beamProfileMicros() - selectStart;
+            break;
+        }
+
+        // Open file in append mode
+        BEAMFile dataFile = _storage->open(filename, BEAM_OPEN_APPEND);
+        _selectMicros += beamProfileMicros() - selectStart;
+        if (!dataFile)
+        {
+            BEAM_ERRORF(STORAGE, "Failed to open file for logging: %s\n", filename);
+            break;
+        }
+
+        bool success = true;
+        char dataString[BEAM_LOG_CSV_ROW_SIZE];
+        do
+        {
+            uint32_t sequence = _state->recordSequence + 1;
+            if (_settings.format == LOG_FORMAT_BINARY)
+            {
+                BEAMLogBinaryRecord packed = beamEncodeRecord(records[written], sequence);
+                success = dataFile.write((const uint8_t *)&packed, sizeof(packed)) == sizeof(packed);
+            }
+            else
+            {
+                // Measured values, not the binary format's scaled integers
+                success = beamFormatCSVRow(records[written], sequence, _settings.deviceID,
+                                           _settings.libraryVersion, dataString, sizeof(dataString)) > 0 &&
+                          dataFile.println(dataString) > 0;
+            }
+            if (!success)
+            {
+                break;
+            }
+            _state->recordSequence = sequence;
+            written++;
+        } while (written < count && records[written].timestamp / 86400 == day);
+
+        dataFile.close();
+        memcpy(_currentFile, filename, sizeof(_currentFile));
+
+        if (!success)
+        {
+            BEAM_ERRORF(STORAGE, "Failed to write to file: %s\n", filename);
+            break;
+        }
+    }
+    return written;
+}
+
+bool BEAMLogWriter::currentFilename(uint32_t unixTime, char *filename)
+{
+    uint32_t day = unixTime / 86400;
+    bool reuse = _settings.wakeFromSleep || !_settings.newFileOnBoot; // keep appending to today's file
+
+    // The cached day/sequence is only trusted for the same card and format
+    bool cacheValid = _state->fileSequence < 100 &&
+                      _state->fileCardID == _storage->volumeID() &&
+                      _state->fileFormat == _settings.format;
+
+    if (cacheValid && _state->fileDay == day)
+    {
+        if (reuse)
+        {
+            logFilename(day, _state->fileSequence, filename); // common case: no SD access
+            return true;
+        }
+
+        // New file on boot: next number, checked once in case the cache is stale
+        uint8_t next = _state->fileSequence + 1;
+        if (next < 100 && !logFileExists(day, next))
+        {
+            return selectLogFile(day, next, filename);
+        }
+    }
+    else if (cacheValid && _settings.wakeFromSleep && !logFileExists(day, 0))
+    {
+        // Day rolled over while asleep: first file of the new day
+        return selectLogFile(day, 0, filename);
+    }
+
+    // Cache missing or stale (boot, card swap, format change): find the
+    // highest sequence number used today
+    int year, month, dayOfMonth, hour, minute, second;
+    beamCivilTime(unixTime, year, month, dayOfMonth, hour, minute, second);
+    BEAM_VERBOSEF(STORAGE, "  Scanning SD card for %04d-%02d-%02d log files\n", year, month, dayOfMonth);
+    int highest = -1;
+    uint8_t lastSequence = _settings.lastFile & 0xFF;
+    if (_settings.lastFile >> 8 == day && _settings.lastFileCard == _storage->volumeID() && lastSequence < 100 &&
+        logFileExists(day, lastSequence))
+    {
+        highest = lastSequence; // In use, so the scan can start above it
+    }
+    while (highest < 99 && logFileExists(day, highest + 1))
+    {
+        highest++;
+    }
+
+    // First look at this boot: a power loss may have torn the last record.
+    // A file written with other columns is never appended to.
+    if (highest >= 0 && !_settings.wakeFromSleep)
+    {
+        logFilename(day, highest, filename);
+        if (!recoverLogTail(filename) && reuse)
+        {
+            BEAM_WARNF(STORAGE, "  %s has different columns, starting a new file\n", filename);
+            reuse = false;
+        }
+    }
+
+    uint8_t sequence;
+    if (highest >= 0 && reuse)
+    {
+        sequence = highest;
+    }
+    else if (highest < 99)
+    {
+        sequence = highest + 1;
+    }
+    else
+    {
+        BEAM_ERRORF(STORAGE, "Error: No available file numbers!\n");
+        return false;
+    }
+
+    BEAM_VERBOSEF(STORAGE, "  Using file number %02d (%s)\n", sequence, highest == sequence ? "existing" : "new");
+    return selectLogFile(day, sequence, filename);
+}
+
+bool BEAMLogWriter::selectLogFile(uint32_t day, uint8_t sequence, char *filename)
+{
+    // Compress the day being left behind once it is over. Across sleep it
+    // is the cached file's day (while the card and format are unchanged);
+    // after a cold boot, the day of the last file recorded in NVS.
+    bool cached = _state->fileSequence < 100 && _state->fileCardID == _storage->volumeID() &&
+                  _state->fileFormat == _settings.format;
+    if (_settings.compression && cached && _state->fileDay != day)
+    {
+        compressLogDay(_state->fileDay);
+    }
+    else if (_settings.compression && !cached && _settings.lastFile != 0 && _settings.lastFile >> 8 != day &&
+             _settings.lastFileCard == _storage->volumeID())
+    {
+        compressLogDay(_settings.lastFile >> 8);
+    }
+
+    _state->fileDay = day;
+    _state->fileSequence = sequence;
+    _state->fileCardID = _storage->volumeID();
+    _state->fileFormat = _settings.format;
+    logFilename(day, sequence, filename);
+    return true;
+}
+
+void BEAMLogWriter::logFilename(uint32_t day, uint8_t sequence, char *filename)
+{
+    int year, month, dayOfMonth, hour, minute, second;
+    beamCivilTime(day * 86400, year, month, dayOfMonth, hour, minute, second);
+    // Fields clamped to their widths, so the name always fits
+    snprintf(filename, BEAM_LOG_FILENAME_SIZE, "/BEAM%.3s_%04u%02u%02u%02u%s", _settings.deviceID,
+             (unsigned)year % 10000, (unsigned)month % 100, (unsigned)dayOfMonth % 100, sequence % 100u,
+             logFileExtension());
+}
+
+bool BEAMLogWriter::logFileExists(uint32_t day, uint8_t sequence)
+{
+    char filename[BEAM_LOG_FILENAME_SIZE + sizeof(BEAM_LZ_EXTENSION)];
+    logFilename(day, sequence, filename);
+    if (_storage->exists(filename))
+    {
+        return true;
+    }
+    strcat(filename, BEAM_LZ_EXTENSION);
+    return _settings.compression && _storage->exists(filename);
+}
+
+const char *BEAMLogWriter::logFileExtension()
+{
+    return _settings.format == LOG_FORMAT_BINARY ? ".bin" : ".csv";
+}
+
+bool BEAMLogWriter::createFile(const char *filename, const char *header)
+{
+    BEAMFile file = _storage->open(filename, BEAM_OPEN_WRITE);
+    if (!file)
+    {
+        BEAM_ERRORF(STORAGE, "Failed to create file: %s\n", filename);
+        return false;
+    }
+
+    // Write header row
+    if (file.println(header))
+    {
+        BEAM_INFOF(STORAGE, "Created new log file: %s\n", filename);
+        return true;
+    }
+
+    BEAM_ERRORF(STORAGE, "Failed to write header to file: %s\n", filename);
+    return false;
+}
+
+bool BEAMLogWriter::createLogFile(const char *filename)
+{
+    BEAMFile file = _storage->open(filename, BEAM_OPEN_WRITE);
+    if (!file)
+    {
+        BEAM_ERRORF(STORAGE, "Failed to create file: %s\n", filename);
+        return false;
+    }
+
+    // Binary files start with a header naming the record layout
+    bool written;
+    if (_settings.format == LOG_FORMAT_BINARY)
+    {
+        BEAMLogFileHeader header;
+        beamInitFileHeader(header, _settings.deviceID, _settings.libraryVersion);
+        written = file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header);
+    }
+    else
+    {
+        written = file.println(CSV_HEADER) > 0;
+    }
+
+    if (!written)
+    {
+        BEAM_ERRORF(STORAGE, "Failed to write header to file: %s\n", filename);
+        return false;
+    }
+
+    BEAM_INFOF(STORAGE, "Created new log file: %s\n", filename);
+    return true;
+}
+
+void BEAMLogWriter::trimLogFile(const char *filename, uint32_t end)
+{
+    if (_storage->truncate(filename, end))
+    {
+        BEAM_VERBOSEF(STORAGE, "  Trimmed %s to %lu bytes\n", filename, (unsigned long)end);
+    }
+    else
+    {
+        BEAM_ERRORF(STORAGE, "  Failed to trim %s\n", filename);
+    }
+}
+
+bool BEAMLogWriter::recoverLogTail(const char *filename)
+{
+    BEAMFile file = _storage->open(filename, BEAM_OPEN_UPDATE);
+    if (!file)
+    {
+        return true; // compressed, or nothing to repair
+    }
+
+    uint32_t end = file.size();
+    uint32_t goodEnd = end;
+    uint32_t sequence = 0;
+
+    // Only files in the current layout can be checked; a torn write can only
+    // affect the records of the last flush, so at most one batch is examined
+    if (_settings.format == LOG_FORMAT_BINARY)
+    {
+        BEAMLogFileHeader header;
+        file.seek(0);
+        if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || !beamCheckFileHeader(header) ||
+            header.columns != BEAM_LOG_COLUMNS || end < sizeof(header))
+        {
+            return false;
+        }
+
+        // Drop a partial record, then any records that fail their CRC
+        uint32_t records = (end - sizeof(header)) / sizeof(BEAMLogBinaryRecord);
+        goodEnd = sizeof(header) + records * sizeof(BEAMLogBinaryRecord);
+        for (uint8_t checked = 0; checked < LOG_BATCH_CAPACITY && records > 0; checked++)
+        {
+            BEAMLogBinaryRecord record;
+            file.seek(goodEnd - sizeof(record));
+            if (file.read((uint8_t *)&record, sizeof(record)) == sizeof(record) && beamCheckBinaryRecord(record))
+            {
+                sequence = beamRecordSequence(record.data, sizeof(record.data));
+                break;
+            }
+            goodEnd -= sizeof(record);
+            records--;
+        }
+    }
+    else
+    {
+        char buffer[512];
+        const size_t headerLength = strlen(CSV_HEADER);
+        file.seek(0);
+        if (headerLength + 2 > sizeof(buffer) || file.read((uint8_t *)buffer, headerLength + 2) != headerLength + 2 ||
+            memcmp(buffer, CSV_HEADER, headerLength) != 0 || buffer[headerLength] != '\r')
+        {
+            return false;
+        }
+
+        // Walk back line by line until a row passes its CRC. Each line is
+        // found by reading backwards from its end a buffer at a time, so a
+        // run of bad bytes longer than any row is skipped as one line.
+        static_assert(sizeof(buffer) > BEAM_LOG_CSV_ROW_SIZE + 2, "a row and its line ending must fit the buffer");
+        uint32_t lineEnd = end;
+        bool readable = true;
+        for (uint8_t checked = 0; checked < LOG_BATCH_CAPACITY && lineEnd > 0 && readable; checked++)
+        {
+            uint32_t chunkStart = lineEnd;
+            size_t textEnd = 0;
+            size_t lineStart;
+            bool terminated = false;
+            bool whole = true; // the line is in the buffer
+            do
+            {
+                size_t chunk = chunkStart < sizeof(buffer) ? chunkStart : sizeof(buffer);
+                chunkStart -= chunk;
+                file.seek(chunkStart);
+                if (file.read((uint8_t *)buffer, chunk) != chunk)
+                {
+                    readable = false;
+                    break;
+                }
+                lineStart = chunk;
+                if (chunkStart + chunk == lineEnd)
+                {
+                    terminated = buffer[chunk - 1] == '\n';
+                    textEnd = terminated ? chunk - 1 : chunk;
+                    if (terminated && textEnd > 0 && buffer[textEnd - 1] == '\r')
+                    {
+                        textEnd--;
+                    }
+                    lineStart = textEnd;
+                }
+                else
+                {
+                    whole = false;
+                }
+                while (lineStart > 0 && buffer[lineStart - 1] != '\n')
+                {
+                    lineStart--;
+                }
+            } while (lineStart == 0 && chunkStart > 0);
+
+            if (!readable || chunkStart + lineStart == 0 ||
+                (whole && terminated && beamCheckCSVRow(buffer + lineStart, textEnd - lineStart, &sequence)))
+            {
+                break; // unreadable, back at the header, or a valid row
+            }
+            goodEnd = chunkStart + lineStart;
+            lineEnd = goodEnd;
+        }
+    }
+
+    if (goodEnd < end)
+    {
+        BEAM_WARNF(STORAGE, "  Torn record in %s: dropping %lu bytes at offset %lu\n",
+                            filename, (unsigned long)(end - goodEnd), (unsigned long)goodEnd);
+        file.close();
+        trimLogFile(filename, goodEnd);
+    }
+
+    // Continue the record sequence where the file left off
+    if (sequence > _state->recordSequence)
+    {
+        _state->recordSequence = sequence;
+    }
+    return true;
+}
+
+static size_t readLogFile(void *context, uint8_t *data, size_t length)
+{
+    return static_cast<BEAMFile *>(context)->read(data, length);
+}
+
+static bool writeLogFile(void *context, const uint8_t *data, size_t length)
+{
+    return static_cast<BEAMFile *>(context)->write(data, length) == length;
+}
+
+void BEAMLogWriter::compressLogDay(uint32_t day)
+{
+    // Same scan as currentFilename(): a day has several files when new files
+    // were started on boot, and compressed ones count towards the numbering
+    char filename[BEAM_LOG_FILENAME_SIZE];
+    for (uint8_t sequence = 0; sequence < 100 && logFileExists(day, sequence); sequence++)
+    {
+        logFilename(day, sequence, filename);
+        compressLogFile(filename); // Skipped if it already has a .lz sidecar
+    }
+}
+
+bool BEAMLogWriter::compressLogFile(const char *filename)
+{
+    char packedName[BEAM_LOG_FILENAME_SIZE + sizeof(BEAM_LZ_EXTENSION)];
+    snprintf(packedName, sizeof(packedName), "%s%s", filename, BEAM_LZ_EXTENSION);
+    if (!_storage->exists(filename) || _storage->exists(packedName))
+    {
+        return false; // nothing to do, or never overwrite an earlier copy
+    }
+
+    BEAMLZEncoder *encoder = new (std::nothrow) BEAMLZEncoder;
+    BEAMLZDecoder *decoder = new (std::nothrow) BEAMLZDecoder;
+    uint32_t start = LOG_MILLIS();
+    uint32_t originalSize = 0;
+    uint32_t packedSize = 0;
+    bool success;
+    {
+        BEAMFile input = _storage->open(filename, BEAM_OPEN_READ);
+        BEAMFile output = _storage->open(packedName, BEAM_OPEN_WRITE);
+        success = encoder && decoder && input && output &&
+                  beamLZCompress(*encoder, readLogFile, &input, writeLogFile, &output, &originalSize, &packedSize);
+    }
+
+    // Read the compressed copy back before giving up the original
+    if (success)
+    {
+        BEAMFile packed = _storage->open(packedName, BEAM_OPEN_READ);
+        uint32_t checkedSize = 0;
+        success = packed && beamLZDecompress(*decoder, readLogFile, &packed, NULL, NULL, &checkedSize) &&
+                  checkedSize == originalSize;
+    }
+    delete encoder;
+    delete decoder;
+
+    if (!success)
+    {
+        BEAM_ERRORF(STORAGE, "Failed to compress %s, keeping it uncompressed\n", filename);
+        _storage->remove(packedName);
+        return false;
+    }
+
+    _storage->remove(filename);
+    BEAM_INFOF(STORAGE, "  Compressed %s: %lu -> %lu bytes in %lu ms\n", filename,
+                        (unsigned long)originalSize, (unsigned long)packedSize, (unsigned long)(LOG_MILLIS() - start));
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef BEAM_LOG_WRITER_H
+#define BEAM_LOG_WRITER_H
+
+// Daily log files on a BEAMStorage backend: filename resolution, headers,
+// tail recovery, compression and record appends. State that must survive
+// deep sleep (current file, record sequence) lives in the BEAMStateBlock it
+// is given. Host-buildable, see extras/log_bench.
+#include <stddef.h>
+#include <stdint.h>
+#include "BEAMState.h"
+#include "BEAMStorage.h"
+#include "LogFormat.h"
+
+#define BEAM_LOG_FILENAME_SIZE 32 // /BEAMXXX_YYYYMMDDNN.csv.lz + null terminator
+
+struct BEAMLogSettings
+{
+    char deviceID[4];
+    const char *libraryVersion;
+    BEAMLogFormat format;
+    bool compression; // Compress the previous day's files on rollover
+    bool newFileOnBoot;
+    bool wakeFromSleep; // Timer wake: the cached file is still current
+    uint32_t lastFile;     // Day << 8 | sequence of the last file written before this boot (0 = unknown)
+    uint32_t lastFileCard; // Volume serial of the card holding it
+};
+
+class BEAMLogWriter
+{
+public:
+    BEAMLogWriter(BEAMStorage *storage, BEAMStateBlock *state) : _storage(storage), _state(state) {}
+
+    void setStorage(BEAMStorage *storage) { _storage = storage; }
+    BEAMStorage *getStorage() { return _storage; }
+    void configure(const BEAMLogSettings &settings) { _settings = settings; }
+
+    // Writes records in order, each run of same-day records to that day's
+    // file. Returns how many were written; stops at the first failure.
+    uint8_t writeRecords(const LogRecord *records, uint8_t count);
+    const char *currentFile() const { return _currentFile; } // Last file written
+    uint32_t selectMicros() const { return _selectMicros; }   // Resolving, creating and opening files in the last writeRecords()
+
+    bool currentFilename(uint32_t unixTime, char *filename); // BEAM_LOG_FILENAME_SIZE bytes
+    bool createFile(const char *filename, const char *header); // Text file with a header row
+
+private:
+    void logFilename(uint32_t day, uint8_t sequence, char *filename);
+    bool selectLogFile(uint32_t day, uint8_t sequence, char *filename); // Updates the file cache
+    bool logFileExists(uint32_t day, uint8_t sequence);                 // Plain or compressed
+    const char *logFileExtension();
+    bool createLogFile(const char *filename);
+    void trimLogFile(const char *filename, uint32_t end);
+    bool recoverLogTail(const char *filename); // Repairs a torn last record; false if other columns
+    void compressLogDay(uint32_t day); // Every file of that day without a .lz
+    bool compressLogFile(const char *filename);
+
+    BEAMStorage *_storage;
+    BEAMStateBlock *_state;
+    BEAMLogSettings _settings = {{'X', 'X', 'X', '\0'}, "", LOG_FORMAT_CSV, false, true, false, 0, 0};
+    char _currentFile[BEAM_LOG_FILENAME_SIZE] = "";
+    uint32_t _selectMicros = 0;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef BEAM_POWER_H
+#define BEAM_POWER_H
+
+// Battery degradation ladder: as the MAX17048 reports a lower voltage or
+// state of charge, each step down the ladder stretches the sleep interval
+// and drops more of the wake's work, so the ULP activity counters keep
+// going for as long as possible. A level is left upwards only once the
+// battery is past the step's thresholds by the hysteresis, or while it
+// charges. Host-buildable.
+#include <math.h>
+#include <stdint.h>
+
+enum BEAMPowerLevel : uint8_t
+{
+    BEAM_POWER_NORMAL,        // Everything as configured
+    BEAM_POWER_STRETCH,       // Longer sleep interval
+    BEAM_POWER_NO_SENSORS,    // No light or environmental reads
+    BEAM_POWER_NO_SYNC,       // alarm() no longer triggers a Hublink sync
+    BEAM_POWER_COUNTERS_ONLY, // Rows carry only the ULP counters and battery
+    BEAM_POWER_LEVEL_COUNT
+};
+
+#define BEAM_POWER_STEPS (BEAM_POWER_LEVEL_COUNT - 1)
+
+// What a step drops (BEAMPowerStep::skip)
+#define BEAM_POWER_SKIP_LIGHT 0x01  // VEML7700 read
+#define BEAM_POWER_SKIP_ENV 0x02    // BME280 forced measurement
+#define BEAM_POWER_SKIP_SYNC 0x04   // alarm() returns false
+#define BEAM_POWER_SKIP_EXTRAS 0x08 // Motion event and wake profile files
+
+struct BEAMPowerStep
+{
+    float belowVolts;    // Entered below this cell voltage (0 = never)...
+    float belowPercent;  // ...or below this state of charge (0 = never)
+    uint8_t sleepFactor; // sleep() interval multiplier
+    uint8_t skip;        // BEAM_POWER_SKIP_* bits
+};
+
+struct BEAMPowerLadder
+{
+    BEAMPowerStep steps[BEAM_POWER_STEPS]; // For levels 1..BEAM_POWER_STEPS, shallowest first
+    float hysteresisVolts;                 // Margin above a step's thresholds to leave it
+    float hysteresisPercent;
+    float chargingRate; // %/hour at or above which the battery counts as charging
+};
+
+inline BEAMPowerLadder beamDefaultPowerLadder()
+{
+    return {{
+                {3.75f, 25.0f, 2, 0},
+                {3.70f, 15.0f, 2, BEAM_POWER_SKIP_LIGHT | BEAM_POWER_SKIP_ENV},
+                {3.60f, 8.0f, 4, BEAM_POWER_SKIP_LIGHT | BEAM_POWER_SKIP_ENV | BEAM_POWER_SKIP_SYNC},
+                {3.50f, 3.0f, 4, BEAM_POWER_SKIP_LIGHT | BEAM_POWER_SKIP_ENV | BEAM_POWER_SKIP_SYNC | BEAM_POWER_SKIP_EXTRAS},
+            },
+            0.05f,
+            3.0f,
+            1.0f};
+}
+
+inline BEAMPowerLadder beamNoPowerLadder() // Stays at BEAM_POWER_NORMAL
+{
+    BEAMPowerLadder ladder = {};
+    for (int i = 0; i < BEAM_POWER_STEPS; i++)
+    {
+        ladder.steps[i].sleepFactor = 1;
+    }
+    return ladder;
+}
+
+inline const BEAMPowerStep *beamPowerStep(const BEAMPowerLadder &ladder, uint8_t level) // NULL at BEAM_POWER_NORMAL
+{
+    return level > 0 && level <= BEAM_POWER_STEPS ? &ladder.steps[level - 1] : nullptr;
+}
+
+inline uint8_t beamPowerSkips(const BEAMPowerLadder &ladder, uint8_t level)
+{
+    const BEAMPowerStep *step = beamPowerStep(ladder, level);
+    return step ? step->skip : 0;
+}
+
+inline uint8_t beamPowerSleepFactor(const BEAMPowerLadder &ladder, uint8_t level)
+{
+    const BEAMPowerStep *step = beamPowerStep(ladder, level);
+    return step && step->sleepFactor > 0 ? step->sleepFactor : 1;
+}
+
+// Level for a battery reading, given the level of the previous wake. Going
+// down is immediate; going up needs the hysteresis margin or charging.
+// An invalid reading keeps the current level.
+inline uint8_t beamPowerLevel(const BEAMPowerLadder &ladder, uint8_t current, float volts, float percent,
+                              float chargeRate)
+{
+    if (isnan(volts) || volts <= 0 || isnan(percent))
+    {
+        return current;
+    }
+    uint8_t level = BEAM_POWER_NORMAL;
+    for (uint8_t i = 0; i < BEAM_POWER_STEPS; i++)
+    {
+        if (volts < ladder.steps[i].belowVolts || percent < ladder.steps[i].belowPercent)
+        {
+            level = i + 1;
+        }
+    }
+    if (level >= current || (!isnan(chargeRate) && chargeRate >= ladder.chargingRate))
+    {
+        return level;
+    }
+    while (current > level)
+    {
+        const BEAMPowerStep &step = ladder.steps[current - 1];
+        if (volts < step.belowVolts + ladder.hysteresisVolts || percent < step.belowPercent + ladder.hysteresisPercent)
+        {
+            break;
+        }
+        current--;
+    }
+    return current;
+}
+
+#endif
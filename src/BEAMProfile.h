@@ -0,0 +1,109 @@
+#ifndef BEAM_PROFILE_H
+#define BEAM_PROFILE_H
+
+// Wake-cycle profile: microseconds spent in each phase of begin(),
+// initSensors(), logData() and sleep(), from esp_timer. A completed profile
+// is queued in the RTC state block at deep sleep entry and written to
+// <logfile>_profile.csv by the next flush (HublinkBEAM::setWakeProfiling()).
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
+enum BEAMWakePhase : uint8_t
+{
+    BEAM_PHASE_STARTUP,      // Wake or reset until begin(): ROM boot, app init, sketch setup
+    BEAM_PHASE_SERIAL,       // Serial.begin() and the debug-mode wait for a terminal
+    BEAM_PHASE_SD_INIT,      // SD power-up, SD.begin() and retries
+    BEAM_PHASE_BATTERY_INIT, // MAX17048 begin() and voltage retries
+    BEAM_PHASE_ENV_INIT,     // BME280 begin() and sampling setup
+    BEAM_PHASE_LIGHT_INIT,   // VEML7700 begin()
+    BEAM_PHASE_RTC_INIT,     // RTC begin() and build-time checks
+    BEAM_PHASE_PIR_INIT,     // ZDP323 begin(), plus stabilization on boot
+    BEAM_PHASE_RANDOM_DELAY, // Alarm randomization delay
+    BEAM_PHASE_SENSOR_READ,  // ULP counters, starting conversions, battery, collecting results
+    BEAM_PHASE_SENSOR_WAIT,  // Light sleep until the slowest conversion is due
+    BEAM_PHASE_SD_CHECK,     // Card present and cardSize() checks before a flush
+    BEAM_PHASE_FILE_SELECT,  // Filename resolution and scan, file creation, open
+    BEAM_PHASE_FILE_WRITE,   // Record formatting, writes and close
+    BEAM_PHASE_EVENTS,       // Motion event log
+    BEAM_PHASE_SLEEP_PREP,   // Pins, SD.end(), sensor sleep modes, ULP start
+    BEAM_PHASE_SERIAL_FLUSH, // Waiting for Serial output to drain
+    BEAM_PHASE_COUNT
+};
+
+#define BEAM_PROFILE_CAPACITY 8 // Completed profiles kept between flushes; the oldest is dropped
+
+struct BEAMWakeProfile
+{
+    uint32_t timestamp;   // Unix time at sleep entry (0 = RTC unavailable)
+    uint32_t wake;         // Timer wakes since the last reset (0 = boot)
+    uint32_t sleepSeconds; // Deep sleep requested after this wake
+    uint32_t awakeMicros;  // esp_timer at deep sleep entry: the whole wake
+    uint32_t i2cTransactions; // I2C bus transactions during the wake (BEAMWire)
+    uint32_t phaseMicros[BEAM_PHASE_COUNT];
+};
+
+// Column names, <name>_us in the profile file
+inline constexpr const char *BEAM_PHASE_NAMES[BEAM_PHASE_COUNT] = {
+    "startup", "serial", "sd_init", "battery_init", "bme280_init", "veml7700_init", "rtc_init", "pir_init",
+    "random_delay", "sensor_read", "sensor_wait", "sd_check", "file_select", "file_write", "motion_events", "sleep_prep",
+    "serial_flush"};
+
+// One column per phase, in BEAMWakePhase order; other_us is the awake time
+// no phase accounts for (sketch code, Hublink sync, debug delays). The
+// energy model (BEAMEnergy.h) adds the cycle's charge and the battery life
+// it would give if every cycle were like it. i2c_transactions shows the
+// effect of the fast wake path (HublinkBEAM::setFastWake()).
+#define BEAM_PROFILE_CSV_HEADER "datetime,wake,sleep_s,awake_us,startup_us,serial_us,sd_init_us,battery_init_us," \
+                                "bme280_init_us,veml7700_init_us,rtc_init_us,pir_init_us,random_delay_us,"         \
+                                "sensor_read_us,sensor_wait_us,sd_check_us,file_select_us,file_write_us,motion_events_us,"          \
+                                "sleep_prep_us,serial_flush_us,other_us,charge_uah,projected_days,i2c_transactions"
+
+inline uint32_t beamProfileMicros()
+{
+#ifdef ARDUINO
+    return (uint32_t)esp_timer_get_time(); // Restarts at 0 on every deep sleep wake
+#else
+    return (uint32_t)(clock() * 1000000.0 / CLOCKS_PER_SEC);
+#endif
+}
+
+// Adds the time from construction to stop() or the end of the scope,
+// whichever comes first, to one phase
+class BEAMPhaseTimer
+{
+public:
+    BEAMPhaseTimer(BEAMWakeProfile &profile, BEAMWakePhase phase)
+        : _profile(profile), _phase(phase), _start(beamProfileMicros()) {}
+    ~BEAMPhaseTimer() { stop(); }
+
+    void start() // Resume after stop()
+    {
+        if (!_running)
+        {
+            _start = beamProfileMicros();
+            _running = true;
+        }
+    }
+
+    void stop()
+    {
+        if (_running)
+        {
+            _profile.phaseMicros[_phase] += beamProfileMicros() - _start;
+            _running = false;
+        }
+    }
+
+private:
+    BEAMWakeProfile &_profile;
+    BEAMWakePhase _phase;
+    uint32_t _start;
+    bool _running = true;
+};
+
+#endif
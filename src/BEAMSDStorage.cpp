@@ -0,0 +1,100 @@
+#include "BEAMSDStorage.h"
+#include <string.h>
+#include <unistd.h>
+
+class BEAMSDFile : public BEAMFileImpl
+{
+public:
+    explicit BEAMSDFile(File file) : _file(file) {}
+    ~BEAMSDFile() override { _file.close(); }
+
+    size_t read(uint8_t *data, size_t length) override { return _file.read(data, length); }
+    size_t write(const uint8_t *data, size_t length) override { return _file.write(data, length); }
+    bool seek(uint32_t position) override { return _file.seek(position); }
+    uint32_t position() override { return _file.position(); }
+    uint32_t size() override { return _file.size(); }
+
+private:
+    File _file;
+};
+
+// FAT12/16/32 or exFAT boot sector: volume serial, or 0 if the sector is
+// not one (the same checks FatFs makes before mounting it)
+static uint32_t bootSectorSerial(const uint8_t *sector)
+{
+    if ((sector[0] != 0xEB && sector[0] != 0xE9 && sector[0] != 0xE8) || sector[510] != 0x55 || sector[511] != 0xAA)
+    {
+        return 0;
+    }
+
+    size_t offset;
+    if (memcmp(sector + 3, "EXFAT   ", 8) == 0)
+    {
+        offset = 100; // VolumeSerialNumber
+    }
+    else if (memcmp(sector + 82, "FAT32", 5) == 0)
+    {
+        offset = 67; // BS_VolID32
+    }
+    else if (memcmp(sector + 54, "FAT", 3) == 0)
+    {
+        offset = 39; // BS_VolID
+    }
+    else
+    {
+        return 0;
+    }
+    uint32_t serial;
+    memcpy(&serial, sector + offset, sizeof(serial)); // little endian, as the ESP32
+    return serial;
+}
+
+void BEAMSDStorage::updateVolumeID()
+{
+    // FAT volume serial number changes with the card or a reformat. It is
+    // read from the boot sector, which is sector 0 or, on a partitioned
+    // card, the start of the first MBR partition (the one FatFs mounts).
+    uint8_t sector[512];
+    uint32_t serial = 0;
+    if (_sd.readRAW(sector, 0))
+    {
+        serial = bootSectorSerial(sector);
+        uint32_t partitionStart;
+        memcpy(&partitionStart, sector + 454, sizeof(partitionStart)); // first partition entry's LBA
+        if (serial == 0 && sector[510] == 0x55 && sector[511] == 0xAA && partitionStart != 0 &&
+            _sd.readRAW(sector, partitionStart))
+        {
+            serial = bootSectorSerial(sector);
+        }
+    }
+    if (serial != 0)
+    {
+        _volumeID = serial;
+        return;
+    }
+    _volumeID = (uint32_t)(_sd.cardSize() >> 20) ^ ((uint32_t)_sd.cardType() << 28); // fallback: size and type
+}
+
+BEAMFileImpl *BEAMSDStorage::openFile(const char *path, BEAMOpenMode mode)
+{
+    static const char *const modes[] = {FILE_READ, FILE_WRITE, FILE_APPEND, "r+"};
+    File file = _sd.open(path, modes[mode]);
+    return file ? new BEAMSDFile(file) : nullptr;
+}
+
+bool BEAMSDStorage::fileExists(const char *path)
+{
+    return _sd.exists(path);
+}
+
+bool BEAMSDStorage::removeFile(const char *path)
+{
+    return _sd.remove(path);
+}
+
+bool BEAMSDStorage::truncateFile(const char *path, uint32_t size)
+{
+    // The SD library has no truncate; go through the VFS path it mounts
+    String fullPath = String(_mountPoint) + path;
+    return ::truncate(fullPath.c_str(), size) == 0;
+}
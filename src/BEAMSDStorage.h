@@ -0,0 +1,30 @@
+#ifndef BEAM_SD_STORAGE_H
+#define BEAM_SD_STORAGE_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include "BEAMStorage.h"
+
+// BEAMStorage on the Arduino SD library. Mounting, power and card checks
+// stay in HublinkBEAM::initSD(); this only routes file calls.
+class BEAMSDStorage : public BEAMStorage
+{
+public:
+    BEAMSDStorage(fs::SDFS &sd, const char *mountPoint) : _sd(sd), _mountPoint(mountPoint) {}
+
+    uint32_t volumeID() override { return _volumeID; }
+    void updateVolumeID(); // Call after each mount
+
+protected:
+    BEAMFileImpl *openFile(const char *path, BEAMOpenMode mode) override;
+    bool fileExists(const char *path) override;
+    bool removeFile(const char *path) override;
+    bool truncateFile(const char *path, uint32_t size) override;
+
+private:
+    fs::SDFS &_sd;
+    const char *_mountPoint; // VFS path, for calls the SD library lacks
+    uint32_t _volumeID = 0;
+};
+
+#endif
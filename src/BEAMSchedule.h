@@ -0,0 +1,74 @@
+#ifndef BEAM_SCHEDULE_H
+#define BEAM_SCHEDULE_H
+
+// Activity-adaptive sleep interval: each wake adds its PIR-active fraction
+// to a short history in the RTC state block, and the next sleep interval is
+// chosen from it. Activity at or above activePermille returns straight to
+// the shortest interval; a run of wakes at or below quietPermille doubles
+// it up to the longest; anything in between keeps the current interval, so
+// a level near one threshold does not flip the interval every wake.
+// Host-buildable.
+#include <stdint.h>
+
+#define BEAM_SCHEDULE_HISTORY 6 // Wakes kept in BEAMStateBlock::activityHistory
+
+struct BEAMSleepSchedule
+{
+    uint16_t minMinutes;     // Interval while active (0 = sleep()'s argument)
+    uint16_t maxMinutes;     // Longest interval while quiet (0 = fixed interval)
+    uint16_t quietPermille;  // A wake is quiet at or below this PIR-active fraction...
+    uint16_t activePermille; // ...and active at or above this one
+    uint8_t quietWakes;      // Consecutive quiet wakes before the interval doubles
+};
+
+inline BEAMSleepSchedule beamFixedSleepSchedule() // sleep() uses its argument
+{
+    return {0, 0, 0, 0, 0};
+}
+
+inline BEAMSleepSchedule beamAdaptiveSleepSchedule(uint16_t minMinutes, uint16_t maxMinutes)
+{
+    return {minMinutes, maxMinutes, 2, 20, 3};
+}
+
+// Adds a wake's activity (per mille of the interval) to the history, newest
+// first, and returns the number of valid entries
+inline uint8_t beamScheduleRecord(uint16_t *history, uint8_t count, uint16_t permille)
+{
+    for (uint8_t i = BEAM_SCHEDULE_HISTORY - 1; i > 0; i--)
+    {
+        history[i] = history[i - 1];
+    }
+    history[0] = permille > 1000 ? 1000 : permille;
+    return count < BEAM_SCHEDULE_HISTORY ? count + 1 : count;
+}
+
+// Next interval in minutes, given the current one and the history
+inline uint16_t beamScheduleNext(const BEAMSleepSchedule &schedule, uint16_t minMinutes, uint16_t current,
+                                 const uint16_t *history, uint8_t count)
+{
+    uint16_t maxMinutes = schedule.maxMinutes > minMinutes ? schedule.maxMinutes : minMinutes;
+    if (current < minMinutes || current > maxMinutes)
+    {
+        current = minMinutes;
+    }
+    if (count == 0 || history[0] >= schedule.activePermille)
+    {
+        return minMinutes;
+    }
+    uint8_t needed = schedule.quietWakes > 0 ? schedule.quietWakes : 1;
+    if (needed > BEAM_SCHEDULE_HISTORY || count < needed)
+    {
+        return current;
+    }
+    for (uint8_t i = 0; i < needed; i++)
+    {
+        if (history[i] > schedule.quietPermille)
+        {
+            return current;
+        }
+    }
+    return (uint32_t)current * 2 < maxMinutes ? current * 2 : maxMinutes;
+}
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef BEAM_SENSOR_CACHE_H
+#define BEAM_SENSOR_CACHE_H
+
+// Sensor configuration recorded by the last full init and kept in the RTC
+// state block, so a timer wake can read the MAX17048, BME280 and VEML7700
+// registers directly instead of running their drivers' begin() (see
+// BEAMFastSensors.h). Conversions match the Adafruit drivers so a value
+// does not depend on which path read it. Host-buildable.
+#include <math.h>
+#include <stdint.h>
+
+// Sensors with a cached configuration (BEAMSensorCache::valid)
+#define BEAM_SENSOR_BATTERY 0x01 // MAX17048
+#define BEAM_SENSOR_ENV 0x02     // BME280
+#define BEAM_SENSOR_LIGHT 0x04   // VEML7700
+#define BEAM_SENSOR_RTC 0x08     // DS3231
+
+#define BEAM_BME280_CALIB_TP_SIZE 26 // 0x88..0xA1: dig_T*, dig_P*, dig_H1
+#define BEAM_BME280_CALIB_H_SIZE 7   // 0xE1..0xE7: dig_H2..dig_H6
+#define BEAM_BME280_MEASURE_MS 10    // Forced measurement at 1x oversampling, 9.3 ms max (datasheet 9.1)
+
+// BME280 trimming parameters (datasheet 4.2.2)
+struct BEAMBME280Calibration
+{
+    uint16_t t1;
+    int16_t t2, t3;
+    uint16_t p1;
+    int16_t p2, p3, p4, p5, p6, p7, p8, p9;
+    uint8_t h1, h3;
+    int16_t h2, h4, h5;
+    int8_t h6;
+    uint8_t reserved[3];
+};
+
+struct BEAMSensorCache
+{
+    uint8_t valid;       // BEAM_SENSOR_* bits
+    uint8_t maxRcomp;    // MAX17048 CONFIG.RCOMP
+    uint8_t bmeCtrlHum;  // BME280 ctrl_hum (0xF2)
+    uint8_t bmeCtrlMeas; // BME280 ctrl_meas (0xF4), mode bits cleared
+    uint8_t bmeConfig;   // BME280 config (0xF5)
+    uint8_t reserved;
+    uint16_t vemlConfig; // VEML7700 ALS_CONF_0: gain, integration time, shutdown
+    BEAMBME280Calibration bme;
+};
+
+static_assert(sizeof(BEAMSensorCache) % sizeof(uint32_t) == 0, "BEAMSensorCache is part of BEAMStateBlock");
+
+inline BEAMBME280Calibration beamParseBME280Calibration(const uint8_t *tp, const uint8_t *h)
+{
+    BEAMBME280Calibration c = {};
+    c.t1 = tp[0] | tp[1] << 8;
+    c.t2 = (int16_t)(tp[2] | tp[3] << 8);
+    c.t3 = (int16_t)(tp[4] | tp[5] << 8);
+    c.p1 = tp[6] | tp[7] << 8;
+    c.p2 = (int16_t)(tp[8] | tp[9] << 8);
+    c.p3 = (int16_t)(tp[10] | tp[11] << 8);
+    c.p4 = (int16_t)(tp[12] | tp[13] << 8);
+    c.p5 = (int16_t)(tp[14] | tp[15] << 8);
+    c.p6 = (int16_t)(tp[16] | tp[17] << 8);
+    c.p7 = (int16_t)(tp[18] | tp[19] << 8);
+    c.p8 = (int16_t)(tp[20] | tp[21] << 8);
+    c.p9 = (int16_t)(tp[22] | tp[23] << 8);
+    c.h1 = tp[25];
+    c.h2 = (int16_t)(h[0] | h[1] << 8);
+    c.h3 = h[2];
+    c.h4 = (int16_t)((int8_t)h[3] * 16 | (h[4] & 0x0F));
+    c.h5 = (int16_t)((int8_t)h[5] * 16 | h[4] >> 4);
+    c.h6 = (int8_t)h[6];
+    return c;
+}
+
+// Compensation formulas of datasheet 4.2.3 in 32/64-bit integers; tFine
+// carries the temperature into pressure and humidity
+inline int32_t beamBME280TFine(const BEAMBME280Calibration &c, int32_t adcT)
+{
+    int32_t var1 = ((((adcT >> 3) - ((int32_t)c.t1 << 1))) * (int32_t)c.t2) >> 11;
+    int32_t var2 = (((((adcT >> 4) - (int32_t)c.t1) * ((adcT >> 4) - (int32_t)c.t1)) >> 12) * (int32_t)c.t3) >> 14;
+    return var1 + var2;
+}
+
+inline float beamBME280Temperature(int32_t tFine) // °C
+{
+    return ((tFine * 5 + 128) >> 8) / 100.0f;
+}
+
+inline float beamBME280Pressure(const BEAMBME280Calibration &c, int32_t tFine, int32_t adcP) // Pa
+{
+    int64_t var1 = (int64_t)tFine - 128000;
+    int64_t var2 = var1 * var1 * (int64_t)c.p6;
+    var2 = var2 + ((var1 * (int64_t)c.p5) * 131072);
+    var2 = var2 + ((int64_t)c.p4 * 34359738368LL);
+    var1 = ((var1 * var1 * (int64_t)c.p3) >> 8) + ((var1 * (int64_t)c.p2) * 4096);
+    var1 = ((((int64_t)1) << 47) + var1) * (int64_t)c.p1 >> 33;
+    if (var1 == 0)
+    {
+        return 0; // Avoid a division by zero
+    }
+    int64_t p = 1048576 - adcP;
+    p = (((p * 2147483648LL) - var2) * 3125) / var1;
+    var1 = ((int64_t)c.p9 * (p >> 13) * (p >> 13)) >> 25;
+    var2 = ((int64_t)c.p8 * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + ((int64_t)c.p7 << 4);
+    return p / 256.0f;
+}
+
+inline float beamBME280Humidity(const BEAMBME280Calibration &c, int32_t tFine, int32_t adcH) // %RH
+{
+    int32_t v = tFine - 76800;
+    v = (((adcH << 14) - ((int32_t)c.h4 * 1048576) - ((int32_t)c.h5 * v) + 16384) >> 15) *
+        (((((((v * (int32_t)c.h6) >> 10) * (((v * (int32_t)c.h3) >> 11) + 32768)) >> 10) + 2097152) *
+              (int32_t)c.h2 +
+          8192) >>
+         14);
+    v = v - (((((v >> 15) * (v >> 15)) >> 7) * (int32_t)c.h1) >> 4);
+    v = v < 0 ? 0 : (v > 419430400 ? 419430400 : v);
+    return (v >> 12) / 1024.0f;
+}
+
+// VEML7700 ALS_CONF_0 fields (gain and integration time codes as VEML7700_GAIN_*/VEML7700_IT_*)
+#define BEAM_VEML7700_GAIN_SHIFT 11
+#define BEAM_VEML7700_GAIN_MASK (0x03 << BEAM_VEML7700_GAIN_SHIFT)
+#define BEAM_VEML7700_IT_SHIFT 6
+#define BEAM_VEML7700_IT_MASK (0x0F << BEAM_VEML7700_IT_SHIFT)
+
+inline uint16_t beamVEML7700IntegrationMs(uint16_t config)
+{
+    switch ((config & BEAM_VEML7700_IT_MASK) >> BEAM_VEML7700_IT_SHIFT)
+    {
+    case 0x0C:
+        return 25;
+    case 0x08:
+        return 50;
+    case 0x01:
+        return 200;
+    case 0x02:
+        return 400;
+    case 0x03:
+        return 800;
+    default:
+        return 100;
+    }
+}
+
+inline float beamVEML7700Gain(uint16_t config)
+{
+    const float gains[] = {1.0f, 2.0f, 0.125f, 0.25f};
+    return gains[(config & BEAM_VEML7700_GAIN_MASK) >> BEAM_VEML7700_GAIN_SHIFT];
+}
+
+// Lux per count: 0.0036 at gain 2 and 800 ms, as Adafruit_VEML7700::getResolution()
+inline float beamVEML7700Resolution(uint16_t config)
+{
+    return 0.0036f * (800.0f / beamVEML7700IntegrationMs(config)) * (2.0f / beamVEML7700Gain(config));
+}
+
+// Gain and integration time codes packed in a byte for LogRecord::lightSetting
+#define BEAM_LIGHT_SETTING_NONE 0xFF // Light sensor not read
+
+inline uint8_t beamVEML7700Setting(uint16_t config)
+{
+    return ((config & BEAM_VEML7700_GAIN_MASK) >> BEAM_VEML7700_GAIN_SHIFT) << 4 |
+           (config & BEAM_VEML7700_IT_MASK) >> BEAM_VEML7700_IT_SHIFT;
+}
+
+inline uint16_t beamVEML7700SettingConfig(uint8_t setting)
+{
+    return (setting >> 4) << BEAM_VEML7700_GAIN_SHIFT | (setting & 0x0F) << BEAM_VEML7700_IT_SHIFT;
+}
+
+// Auto-range ladder (HublinkBEAM::setLightAutoRange()), least sensitive
+// first: gain steps up at 100 ms, then the integration time grows. Each
+// step roughly doubles the counts for the same light, from 1.84 lx per
+// count (120 klx full scale) down to 0.0036 lx per count.
+struct BEAMLightRange
+{
+    uint8_t gain;        // VEML7700_GAIN_* code
+    uint8_t integration; // VEML7700_IT_* code
+};
+
+constexpr BEAMLightRange BEAM_VEML7700_RANGES[] = {
+    {0x02, 0x0C}, {0x02, 0x08}, {0x02, 0x00}, {0x03, 0x00}, {0x00, 0x00}, // 1/8 x 25, 50, 100 ms; 1/4, 1 x 100 ms
+    {0x01, 0x00}, {0x01, 0x01}, {0x01, 0x02}, {0x01, 0x03},               // 2 x 100, 200, 400, 800 ms
+};
+#define BEAM_VEML7700_RANGE_COUNT (int)(sizeof(BEAM_VEML7700_RANGES) / sizeof(BEAM_VEML7700_RANGES[0]))
+#define BEAM_VEML7700_RAW_LOW 100       // Noise floor: fewer counts step to a more sensitive range
+#define BEAM_VEML7700_RAW_HIGH 60000    // Saturating: step to the least sensitive range
+#define BEAM_VEML7700_RANGE_STEPS 3     // Range changes per reading; each costs two integrations
+
+inline uint16_t beamVEML7700RangeConfig(int index) // Gain and integration time bits only
+{
+    return (uint16_t)(BEAM_VEML7700_RANGES[index].gain << BEAM_VEML7700_GAIN_SHIFT |
+                      BEAM_VEML7700_RANGES[index].integration << BEAM_VEML7700_IT_SHIFT);
+}
+
+inline int beamVEML7700RangeIndex(uint16_t config) // -1 if the configuration is not on the ladder
+{
+    for (int i = 0; i < BEAM_VEML7700_RANGE_COUNT; i++)
+    {
+        if ((config & (BEAM_VEML7700_GAIN_MASK | BEAM_VEML7700_IT_MASK)) == beamVEML7700RangeConfig(i))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Range for the next reading after `raw` counts at `config`, or -1 to keep
+// it. A reading between the noise floor and saturation is kept, so the
+// range only moves when it has to. A saturated reading says nothing about
+// how bright it is, so it goes to the least sensitive range; a faint one
+// goes straight to the shortest range expected to read twice the floor.
+inline int beamVEML7700NextRange(uint16_t config, uint16_t raw)
+{
+    int index = beamVEML7700RangeIndex(config);
+    if (raw >= BEAM_VEML7700_RAW_HIGH)
+    {
+        return index == 0 ? -1 : 0;
+    }
+    if (raw >= BEAM_VEML7700_RAW_LOW || index == BEAM_VEML7700_RANGE_COUNT - 1)
+    {
+        return -1;
+    }
+    float resolution = beamVEML7700Resolution(config);
+    float lux = raw * resolution;
+    for (int i = 0; raw > 0 && i < BEAM_VEML7700_RANGE_COUNT; i++)
+    {
+        float candidate = beamVEML7700Resolution(beamVEML7700RangeConfig(i));
+        if (candidate < resolution && lux / candidate >= 2 * BEAM_VEML7700_RAW_LOW)
+        {
+            return i;
+        }
+    }
+    return BEAM_VEML7700_RANGE_COUNT - 1; // Dark
+}
+
+#endif
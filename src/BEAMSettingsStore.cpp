@@ -0,0 +1,173 @@
+#include "BEAMSettingsStore.h"
+#include <Arduino.h>
+#include "nvs.h"
+#include "esp_rom_crc.h"
+#include "BEAMDebug.h"
+#include "SharedDefs.h"
+
+static RTC_DATA_ATTR BEAMSettingsBlock rtc_settings;
+
+static const char *const settingNames[BEAM_SETTING_COUNT] = BEAM_SETTING_NAMES;
+static const char *const legacyNames[BEAM_SETTING_LEGACY_COUNT] = BEAM_SETTING_LEGACY_NAMES;
+
+bool BEAMSettingsStore::begin(bool timerWake)
+{
+    if (timerWake && rtc_settings.magic == BEAM_SETTINGS_MAGIC && rtc_settings.version == BEAM_SETTINGS_VERSION &&
+        rtc_settings.crc == computeCRC())
+    {
+        return true;
+    }
+    if (timerWake)
+    {
+        BEAM_WARNF(STATE, "  Settings: invalid RTC copy, reloading from NVS\n");
+    }
+    return load();
+}
+
+bool BEAMSettingsStore::load()
+{
+    memset(&rtc_settings, 0, sizeof(rtc_settings));
+    rtc_settings.magic = BEAM_SETTINGS_MAGIC;
+    rtc_settings.version = BEAM_SETTINGS_VERSION;
+
+    // Read-only: the namespace does not exist before the first commit
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(PREFS_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_OK)
+    {
+        for (int i = 0; i < BEAM_SETTING_COUNT; i++)
+        {
+            if (nvs_get_u32(handle, settingNames[i], &rtc_settings.values[i]) == ESP_OK)
+            {
+                rtc_settings.present |= 1UL << i;
+            }
+        }
+        for (int i = 0; i < BEAM_SETTING_LEGACY_COUNT; i++)
+        {
+            nvs_type_t type;
+            if (nvs_find_key(handle, legacyNames[i], &type) == ESP_OK)
+            {
+                rtc_settings.legacy |= 1UL << i;
+            }
+        }
+        nvs_close(handle);
+    }
+    if (rtc_settings.present & (1UL << BEAM_SETTING_NVS_WRITES))
+    {
+        rtc_settings.writeDay = rtc_settings.values[BEAM_SETTING_NVS_WRITES] >> 16;
+        rtc_settings.writesToday = rtc_settings.values[BEAM_SETTING_NVS_WRITES] & 0xFFFF;
+    }
+    seal();
+    BEAM_VERBOSEF(STATE, "  Settings: %d of %d keys loaded from NVS%s\n", __builtin_popcount(rtc_settings.present),
+                         BEAM_SETTING_COUNT, rtc_settings.legacy ? ", legacy keys to erase" : "");
+    return err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND;
+}
+
+bool BEAMSettingsStore::has(BEAMSettingKey key)
+{
+    return rtc_settings.present & (1UL << key);
+}
+
+uint32_t BEAMSettingsStore::get(BEAMSettingKey key, uint32_t defaultValue)
+{
+    return has(key) ? rtc_settings.values[key] : defaultValue;
+}
+
+void BEAMSettingsStore::set(BEAMSettingKey key, uint32_t value)
+{
+    if (has(key) && rtc_settings.values[key] == value)
+    {
+        return; // Unchanged values cost no flash write
+    }
+    rtc_settings.values[key] = value;
+    rtc_settings.present |= 1UL << key;
+    rtc_settings.dirty |= 1UL << key;
+    seal();
+}
+
+bool BEAMSettingsStore::isDirty()
+{
+    return rtc_settings.dirty || rtc_settings.legacy;
+}
+
+uint8_t BEAMSettingsStore::commit(uint32_t unixDay)
+{
+    if (!isDirty())
+    {
+        return 0;
+    }
+    nvs_handle_t handle;
+    if (nvs_open(PREFS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+    {
+        BEAM_ERRORF(STATE, "Settings: failed to open NVS\n");
+        return 0;
+    }
+    uint8_t written = 0;
+    for (int i = 0; i < BEAM_SETTING_COUNT; i++)
+    {
+        if ((rtc_settings.dirty & (1UL << i)) && nvs_set_u32(handle, settingNames[i], rtc_settings.values[i]) == ESP_OK)
+        {
+            written++;
+        }
+    }
+    for (int i = 0; i < BEAM_SETTING_LEGACY_COUNT; i++)
+    {
+        if ((rtc_settings.legacy & (1UL << i)) && nvs_erase_key(handle, legacyNames[i]) == ESP_OK)
+        {
+            written++;
+        }
+    }
+
+    // The counter rides in the first commit of the day and counts itself;
+    // later commits that day only update the RTC copy
+    bool storeCount = !has(BEAM_SETTING_NVS_WRITES) ||
+                      rtc_settings.values[BEAM_SETTING_NVS_WRITES] >> 16 != (unixDay & 0xFFFF);
+    uint32_t today = writesToday(unixDay) + written + (storeCount ? 1 : 0);
+    uint32_t counter = (unixDay & 0xFFFF) << 16 | (today < 0xFFFF ? today : 0xFFFF);
+    if (storeCount && nvs_set_u32(handle, settingNames[BEAM_SETTING_NVS_WRITES], counter) == ESP_OK)
+    {
+        written++;
+    }
+    esp_err_t err = nvs_commit(handle);
+    nvs_close(handle);
+    if (err != ESP_OK)
+    {
+        BEAM_ERRORF(STATE, "Settings: NVS commit failed (%d)\n", err);
+        return 0; // Still dirty: retried by the next commit
+    }
+
+    rtc_settings.dirty = 0;
+    rtc_settings.legacy = 0;
+    if (storeCount)
+    {
+        rtc_settings.values[BEAM_SETTING_NVS_WRITES] = counter;
+        rtc_settings.present |= 1UL << BEAM_SETTING_NVS_WRITES;
+    }
+    rtc_settings.writeDay = counter >> 16;
+    rtc_settings.writesToday = counter & 0xFFFF;
+    rtc_settings.writes += written;
+    seal();
+    BEAM_INFOF(STATE, "Settings: %d NVS entries committed (%d today, %lu since boot)\n", written,
+                      rtc_settings.writesToday, rtc_settings.writes);
+    return written;
+}
+
+uint16_t BEAMSettingsStore::writesToday(uint32_t unixDay)
+{
+    return rtc_settings.writeDay == (unixDay & 0xFFFF) ? rtc_settings.writesToday : 0;
+}
+
+uint32_t BEAMSettingsStore::writes()
+{
+    return rtc_settings.writes;
+}
+
+void BEAMSettingsStore::seal()
+{
+    rtc_settings.crc = computeCRC();
+}
+
+uint32_t BEAMSettingsStore::computeCRC()
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)&rtc_settings, offsetof(BEAMSettingsBlock, crc));
+}
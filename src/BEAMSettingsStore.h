@@ -0,0 +1,79 @@
+#ifndef BEAM_SETTINGS_STORE_H
+#define BEAM_SETTINGS_STORE_H
+
+// Persistent keys of the "beam" NVS namespace (PREFS_NAMESPACE), loaded
+// once per cold boot into RTC memory. Reads are served from that copy, so
+// timer wakes never touch NVS; set() only marks a key dirty, and commit()
+// writes every dirty key in one NVS session with a single nvs_commit().
+// NVS writes are counted per day for flash wear tracking. The count lives
+// in the RTC copy and rides along with the first commit of each day, so it
+// costs at most one entry a day; a cold boot resumes from that entry.
+#include <stddef.h>
+#include <stdint.h>
+
+#define BEAM_SETTINGS_MAGIC 0xBEA8
+#define BEAM_SETTINGS_VERSION 2
+
+// Add a key by appending it here and its NVS name to BEAM_SETTING_NAMES
+enum BEAMSettingKey
+{
+    BEAM_SETTING_BUILD_EPOCH,    // RTCManager: Unix time of the build that set the RTC
+    BEAM_SETTING_LAST_FILE,      // Last data file: day << 8 | sequence (BEAMLogWriter scan start)
+    BEAM_SETTING_LAST_FILE_CARD, // Volume serial of the card holding it
+    BEAM_SETTING_NVS_WRITES,     // NVS entries written: day << 16 | count (commit() only, once a day)
+    BEAM_SETTING_COUNT
+};
+
+#define BEAM_SETTING_NAMES {"buildEpoch", "lastFile", "lastFileCard", "nvsWrites"} // 15 characters at most
+
+// Keys of earlier library versions, erased by the first commit that finds them
+#define BEAM_SETTING_LEGACY_NAMES {"buildTime", "compileTime", "filename"}
+#define BEAM_SETTING_LEGACY_COUNT 3
+
+struct BEAMSettingsBlock
+{
+    uint16_t magic;
+    uint16_t version;
+    uint32_t values[BEAM_SETTING_COUNT];
+    uint32_t present; // Bit per BEAMSettingKey with a value
+    uint32_t dirty;   // Bit per BEAMSettingKey changed since the last commit
+    uint32_t legacy;  // Bit per BEAM_SETTING_LEGACY_NAMES entry found in NVS
+    uint32_t writeDay;    // Days since 1970 of writesToday
+    uint16_t writesToday; // NVS entries written on writeDay
+    uint16_t reserved;
+    uint32_t writes;      // NVS entries written since the cold boot
+    uint32_t crc;         // Must stay last
+};
+
+static_assert(BEAM_SETTING_COUNT <= 32, "present/dirty are 32-bit masks");
+static_assert(sizeof(BEAMSettingsBlock) % sizeof(uint32_t) == 0, "BEAMSettingsBlock must be word aligned");
+
+class BEAMSettingsStore
+{
+public:
+    // Cold boot: loads every key from NVS. Timer wake: keeps the RTC copy,
+    // reloading only if it did not survive sleep intact.
+    bool begin(bool timerWake);
+
+    bool has(BEAMSettingKey key);
+    uint32_t get(BEAMSettingKey key, uint32_t defaultValue = 0);
+    void set(BEAMSettingKey key, uint32_t value); // No NVS write until commit()
+    bool isDirty();
+
+    // Writes the dirty keys (and erases legacy ones) in one NVS session, plus
+    // the day's write count if it has not been stored yet that day. unixDay
+    // (days since 1970) attributes the writes to a day. Returns the number
+    // of entries written, counter included, 0 if nothing was dirty or NVS
+    // failed.
+    uint8_t commit(uint32_t unixDay);
+
+    uint16_t writesToday(uint32_t unixDay); // NVS entries written on that day, across cold boots
+    uint32_t writes();                      // NVS entries written since the cold boot
+
+private:
+    bool load();
+    void seal(); // Recompute the CRC after a change
+    uint32_t computeCRC();
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "BEAMState.h"
+#include <Arduino.h>
+#include "esp_rom_crc.h"
+#include "BEAMDebug.h"
+
+static RTC_DATA_ATTR BEAMStateBlock rtc_state;
+
+BEAMStateBlock &BEAMState::data()
+{
+    return rtc_state;
+}
+
+bool BEAMState::isValid()
+{
+    return rtc_state.magic == BEAM_STATE_MAGIC &&
+           rtc_state.version == BEAM_STATE_VERSION &&
+           rtc_state.size == sizeof(BEAMStateBlock) &&
+           rtc_state.pendingRecords <= LOG_BATCH_CAPACITY &&
+           rtc_state.pendingProfiles <= BEAM_PROFILE_CAPACITY &&
+           rtc_state.crc == computeCRC();
+}
+
+bool BEAMState::validate()
+{
+    if (!isValid())
+    {
+        BEAM_WARNF(STATE, "  State: invalid RTC state block (magic=0x%04X, version=%d), resetting\n",
+                          rtc_state.magic, rtc_state.version);
+        reset();
+        return false;
+    }
+    BEAM_VERBOSEF(STATE, "  State: RTC state valid, wake %lu\n", rtc_state.wakeCount);
+    return true;
+}
+
+void BEAMState::reset()
+{
+    memset(&rtc_state, 0, sizeof(rtc_state));
+    rtc_state.magic = BEAM_STATE_MAGIC;
+    rtc_state.version = BEAM_STATE_VERSION;
+    rtc_state.size = sizeof(BEAMStateBlock);
+    rtc_state.fileSequence = BEAM_STATE_NO_FILE;
+    commit();
+}
+
+void BEAMState::commit()
+{
+    rtc_state.crc = computeCRC();
+}
+
+uint32_t BEAMState::computeCRC()
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)&rtc_state, offsetof(BEAMStateBlock, crc));
+}
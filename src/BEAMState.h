@@ -0,0 +1,83 @@
+#ifndef BEAM_STATE_H
+#define BEAM_STATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "LogRecord.h"
+#include "BEAMProfile.h"
+#include "BEAMSensorCache.h"
+#include "BEAMSchedule.h"
+
+// Cross-wake state kept in RTC memory. Bump BEAM_STATE_VERSION whenever the
+// layout of BEAMStateBlock changes so a stale block is reset, not misread.
+// ULP counters stay in RTC_SLOW_MEM (see ULPMemoryMap.h): the ULP writes
+// them while asleep, so they cannot be covered by the CRC.
+#define BEAM_STATE_MAGIC 0xBEA7
+#define BEAM_STATE_VERSION 15
+#define BEAM_STATE_NO_FILE 0xFF // fileSequence when no file is cached
+
+struct BEAMStateBlock
+{
+    uint16_t magic;
+    uint16_t version;
+    uint16_t size; // sizeof(BEAMStateBlock) when written
+
+    // Alarm scheduling
+    uint16_t alarmInterval;  // Minutes (0 = not set)
+    uint32_t alarmStartTime; // Unix time of the last alarm
+
+    // Sleep bookkeeping
+    uint32_t sleepStartTime; // Unix time when deep sleep started
+    uint32_t sleepSeconds;   // Requested sleep duration
+    uint32_t eventStartTime; // Unix time the ULP window tick of motion events last restarted
+    uint32_t wakeCount;      // Timer wakes since the last reset
+
+    // Settings restored on wake, before the sketch reapplies them
+    char deviceID[4];
+    uint8_t logBatchSize; // Records per SD flush (0/1 = write every wake)
+    uint8_t logFormat;    // BEAMLogFormat
+
+    // Log records waiting for the next SD flush
+    uint16_t droppedRecords; // Oldest records discarded while the SD was unavailable
+    uint8_t pendingRecords;
+
+    // Current data file, so resolving it needs no directory scan
+    uint8_t fileSequence; // NN in /BEAMXXX_YYYYMMDDNN (BEAM_STATE_NO_FILE = none)
+    uint8_t fileFormat;   // BEAMLogFormat the file was created with
+    uint8_t logCompression; // Compress the previous day's files on rollover
+    uint8_t pendingProfiles; // Wake profiles waiting for the next flush
+    uint8_t lightAutoRange;  // VEML7700 auto-ranging on
+    uint8_t powerLevel;      // BEAMPowerLevel of the last wake
+    uint8_t activityWakes;   // Valid entries in activityHistory
+    uint16_t sleepMinutes;   // Adaptive interval of the last sleep (0 = none yet)
+    uint16_t activityHistory[BEAM_SCHEDULE_HISTORY]; // PIR-active per mille, newest first
+    uint32_t fileDay;    // Days since 1970 (RTC local time)
+    uint32_t fileCardID; // Volume serial of the card holding the file
+    uint32_t recordSequence; // record_seq of the last record written
+    BEAMSensorCache sensors; // Sensor configuration for the fast wake path
+    LogRecord records[LOG_BATCH_CAPACITY];
+    BEAMWakeProfile profiles[BEAM_PROFILE_CAPACITY];
+
+    uint32_t crc; // CRC-32 of every field above; must stay last
+};
+
+static_assert(sizeof(BEAMStateBlock) % sizeof(uint32_t) == 0, "BEAMStateBlock must be word aligned");
+static_assert(LOG_BATCH_CAPACITY <= 255, "pendingRecords is 8 bits");
+
+class BEAMState
+{
+public:
+    BEAMStateBlock &data();
+
+    // Checks magic, version, size and CRC. An invalid block is reset and
+    // false is returned so callers can drop any state derived from it.
+    bool validate();
+    bool isValid(); // Same checks, without resetting or logging
+    void reset();
+    void commit(); // Recompute the CRC; call after the last change before sleep
+
+private:
+    uint32_t computeCRC();
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include "BEAMStorage.h"
+#include <string.h>
+
+size_t BEAMFile::read(uint8_t *data, size_t length)
+{
+    if (!_impl)
+    {
+        return 0;
+    }
+    size_t n = _impl->read(data, length);
+    _stats->reads++;
+    _stats->bytesRead += n;
+    return n;
+}
+
+size_t BEAMFile::write(const uint8_t *data, size_t length)
+{
+    if (!_impl)
+    {
+        return 0;
+    }
+    size_t n = _impl->write(data, length);
+    _stats->writes++;
+    _stats->bytesWritten += n;
+    return n;
+}
+
+size_t BEAMFile::println(const char *text)
+{
+    size_t length = strlen(text);
+    if (write((const uint8_t *)text, length) != length)
+    {
+        return 0;
+    }
+    return write((const uint8_t *)"\r\n", 2) == 2 ? length + 2 : 0;
+}
+
+BEAMFile &BEAMFile::operator=(BEAMFile &&other)
+{
+    if (this != &other)
+    {
+        close();
+        _impl = other._impl;
+        _stats = other._stats;
+        other._impl = nullptr;
+    }
+    return *this;
+}
+
+bool BEAMFile::seek(uint32_t position)
+{
+    if (!_impl)
+    {
+        return false;
+    }
+    _stats->seeks++;
+    return _impl->seek(position);
+}
+
+BEAMFile BEAMStorage::open(const char *path, BEAMOpenMode mode)
+{
+    _stats.opens++;
+    BEAMFileImpl *impl = openFile(path, mode);
+    return impl ? BEAMFile(impl, &_stats) : BEAMFile();
+}
+
+bool BEAMStorage::exists(const char *path)
+{
+    _stats.lookups++;
+    return fileExists(path);
+}
+
+bool BEAMStorage::remove(const char *path)
+{
+    _stats.removes++;
+    return removeFile(path);
+}
+
+bool BEAMStorage::truncate(const char *path, uint32_t size)
+{
+    _stats.truncates++;
+    return truncateFile(path, size);
+}
@@ -0,0 +1,104 @@
+#ifndef BEAM_STORAGE_H
+#define BEAM_STORAGE_H
+
+// Storage backends for the logging path. The log writer only sees
+// BEAMStorage, so the same code runs against the SD card (BEAMSDStorage.h)
+// or, on a host, RAM or a directory (extras/log_bench/BEAMHostStorage.h),
+// and every backend counts its I/O the same way. Host-includable (no
+// Arduino dependencies, no STL).
+#include <stddef.h>
+#include <stdint.h>
+
+enum BEAMOpenMode
+{
+    BEAM_OPEN_READ,   // Existing file, read only
+    BEAM_OPEN_WRITE,  // Create or truncate
+    BEAM_OPEN_APPEND, // Create if needed, every write goes to the end
+    BEAM_OPEN_UPDATE  // Existing file, read and overwrite anywhere
+};
+
+// Calls into the backend since the last resetStats()
+struct BEAMStorageStats
+{
+    uint32_t opens;
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t seeks;
+    uint32_t lookups; // exists()
+    uint32_t removes;
+    uint32_t truncates;
+    uint32_t bytesRead;
+    uint32_t bytesWritten;
+
+    uint32_t operations() const { return opens + reads + writes + seeks + lookups + removes + truncates; }
+};
+
+// One open file of a backend; closed when destroyed
+class BEAMFileImpl
+{
+public:
+    virtual ~BEAMFileImpl() {}
+    virtual size_t read(uint8_t *data, size_t length) = 0;
+    virtual size_t write(const uint8_t *data, size_t length) = 0;
+    virtual bool seek(uint32_t position) = 0;
+    virtual uint32_t position() = 0;
+    virtual uint32_t size() = 0;
+};
+
+// Move-only file handle returned by BEAMStorage::open(); counts its I/O
+class BEAMFile
+{
+public:
+    BEAMFile() {}
+    BEAMFile(BEAMFileImpl *impl, BEAMStorageStats *stats) : _impl(impl), _stats(stats) {}
+    BEAMFile(BEAMFile &&other) : _impl(other._impl), _stats(other._stats) { other._impl = nullptr; }
+    BEAMFile &operator=(BEAMFile &&other);
+    BEAMFile(const BEAMFile &) = delete;
+    BEAMFile &operator=(const BEAMFile &) = delete;
+    ~BEAMFile() { close(); }
+
+    explicit operator bool() const { return _impl != nullptr; }
+    size_t read(uint8_t *data, size_t length);
+    size_t write(const uint8_t *data, size_t length);
+    size_t println(const char *text); // text + "\r\n", as Arduino's Print
+    bool seek(uint32_t position);
+    uint32_t position() { return _impl ? _impl->position() : 0; }
+    uint32_t size() { return _impl ? _impl->size() : 0; }
+    void close()
+    {
+        delete _impl;
+        _impl = nullptr;
+    }
+
+private:
+    BEAMFileImpl *_impl = nullptr;
+    BEAMStorageStats *_stats = nullptr;
+};
+
+class BEAMStorage
+{
+public:
+    virtual ~BEAMStorage() {}
+
+    BEAMFile open(const char *path, BEAMOpenMode mode);
+    bool exists(const char *path);
+    bool remove(const char *path);
+    bool truncate(const char *path, uint32_t size);
+
+    // Identifies the medium, so cached file names are dropped when it changes
+    virtual uint32_t volumeID() { return 0; }
+
+    const BEAMStorageStats &stats() const { return _stats; }
+    void resetStats() { _stats = BEAMStorageStats(); }
+
+protected:
+    virtual BEAMFileImpl *openFile(const char *path, BEAMOpenMode mode) = 0;
+    virtual bool fileExists(const char *path) = 0;
+    virtual bool removeFile(const char *path) = 0;
+    virtual bool truncateFile(const char *path, uint32_t size) = 0;
+
+private:
+    BEAMStorageStats _stats = BEAMStorageStats();
+};
+
+#endif
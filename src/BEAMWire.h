@@ -0,0 +1,60 @@
+#ifndef BEAM_WIRE_H
+#define BEAM_WIRE_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// TwoWire that counts bus transactions, so the I2C cost of a wake can be
+// compared between the full and the fast sensor init. A transaction is one
+// addressed access: a register write, or the address phase of a register
+// read. Sensor drivers holding a TwoWire* reach the count through the
+// virtual HardwareI2C interface of arduino-esp32 3.x; on 2.x only BEAM's own
+// register accesses below are counted.
+class BEAMWire : public TwoWire
+{
+public:
+    explicit BEAMWire(uint8_t bus) : TwoWire(bus) {}
+
+    using TwoWire::beginTransmission;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    void beginTransmission(uint8_t address) override
+#else
+    void beginTransmission(uint8_t address)
+#endif
+    {
+        _transactions++;
+        TwoWire::beginTransmission(address);
+    }
+
+    uint32_t transactions() { return _transactions; } // Since boot or wake
+
+    bool readRegisters(uint8_t address, uint8_t reg, uint8_t *data, uint8_t length)
+    {
+        beginTransmission(address);
+        write(reg);
+        if (endTransmission(false) != 0 || requestFrom(address, length) != length)
+        {
+            return false;
+        }
+        for (uint8_t i = 0; i < length; i++)
+        {
+            data[i] = read();
+        }
+        return true;
+    }
+
+    bool writeRegisters(uint8_t address, uint8_t reg, const uint8_t *data, uint8_t length)
+    {
+        beginTransmission(address);
+        write(reg);
+        write(data, length);
+        return endTransmission() == 0;
+    }
+
+    bool writeRegister(uint8_t address, uint8_t reg, uint8_t value) { return writeRegisters(address, reg, &value, 1); }
+
+private:
+    uint32_t _transactions = 0;
+};
+
+#endif
@@ -1,14 +1,14 @@
 #include "HublinkBEAM.h"
 #include "RTCManager.h"
+#include "BEAMDebug.h"
 #include "esp_sleep.h"
 #include "esp_mac.h"
 
-// Use RTC memory to maintain state across deep sleep
-static RTC_DATA_ATTR uint16_t alarm_interval = 0;
-static RTC_DATA_ATTR uint32_t alarm_start_time = 0;
-static RTC_DATA_ATTR uint32_t sleep_start_time = 0;
-
-HublinkBEAM::HublinkBEAM() : _pixel(1, PIN_NEOPIXEL, NEO_GRB + NEO_KHZ800)
+HublinkBEAM::HublinkBEAM() : _pixel(1, PIN_NEOPIXEL, NEO_GRB + NEO_KHZ800),
+                             _sdStorage(SD, SD_MOUNT_POINT),
+                             _wire(0),
+                             _fastSensors(_wire),
+                             _logWriter(&_sdStorage, &_state.data())
 {
     _isSDInitialized = false;
     _isPIRInitialized = false;
@@ -26,7 +26,7 @@ void HublinkBEAM::setDeviceID(String deviceID)
     // Validate device ID: must be exactly 3 characters and alphanumeric
     if (deviceID.length() != 3)
     {
-        Serial.println("Warning: Device ID must be exactly 3 characters, using default 'XXX'");
+        BEAM_WARNF(CORE, "Warning: Device ID must be exactly 3 characters, using default 'XXX'\n");
         _deviceID = "XXX";
         return;
     }
@@ -45,7 +45,7 @@ void HublinkBEAM::setDeviceID(String deviceID)
 
     if (!isValid)
     {
-        Serial.println("Warning: Device ID must be alphanumeric, using default 'XXX'");
+        BEAM_WARNF(CORE, "Warning: Device ID must be alphanumeric, using default 'XXX'\n");
         _deviceID = "XXX";
         return;
     }
@@ -53,11 +53,16 @@ void HublinkBEAM::setDeviceID(String deviceID)
     // Convert to uppercase for consistency
     deviceID.toUpperCase();
     _deviceID = deviceID;
-    Serial.printf("Device ID set to: %s\n", _deviceID.c_str());
+    BEAM_INFOF(CORE, "Device ID set to: %s\n", _deviceID.c_str());
 }
 
 bool HublinkBEAM::begin()
 {
+    if (_profile.phaseMicros[BEAM_PHASE_STARTUP] == 0)
+    {
+        _profile.phaseMicros[BEAM_PHASE_STARTUP] = beamProfileMicros(); // first call only
+    }
+
     // Stop ULP to free up GPIO pins and stop ULP timer
     _ulp.stop();
 
@@ -68,6 +73,7 @@ bool HublinkBEAM::begin()
     initPins();
     setNeoPixel(NEOPIXEL_BLUE);
 
+    BEAMPhaseTimer serialTimer(_profile, BEAM_PHASE_SERIAL);
     Serial.begin(115200);
     if (switchADown())
     {
@@ -77,27 +83,55 @@ bool HublinkBEAM::begin()
         {
             delay(100); // Small delay to prevent tight loop
         }
-        Serial.println("***Debug mode enabled***");
+        BEAM_INFOF(CORE, "***Debug mode enabled***\n");
     }
+    serialTimer.stop();
     // Normal initialization for timer wakeup or regular boot
-    Serial.println("\n\n\n----------\nbeam.begin()...\n----------\n");
+    BEAM_INFOF(CORE, "\n\n\n----------\nbeam.begin()...\n----------\n\n");
 
     // Initialize I2C for all cases
-    Wire.begin();
+    _wire.begin();
     delay(10); // Give I2C time to stabilize
-    Serial.println("  I2C: started");
+    BEAM_VERBOSEF(CORE, "  I2C: started\n");
 
     // Calculate PIR activity percentage if waking from sleep
     esp_sleep_wakeup_cause_t wakeup_reason = esp_sleep_get_wakeup_cause();
     _isWakeFromSleep = (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER);
-    Serial.printf("    Wake from sleep: %s\n", _isWakeFromSleep ? "YES" : "NO");
+    BEAM_INFOF(CORE, "    Wake from sleep: %s\n", _isWakeFromSleep ? "YES" : "NO");
+
+    // Cross-wake state is only trusted if it survived sleep intact; otherwise
+    // treat this as a fresh boot so nothing is derived from corrupt values
+    if (_isWakeFromSleep && !_state.validate())
+    {
+        _isWakeFromSleep = false;
+    }
+    _store.begin(_isWakeFromSleep); // NVS is only read on a cold boot
+    if (_isWakeFromSleep)
+    {
+        // Restore settings so batching decisions work before the sketch reapplies them
+        BEAMStateBlock &state = _state.data();
+        if (state.deviceID[0] != '\0')
+        {
+            _deviceID = String(state.deviceID);
+        }
+        _logBatchSize = state.logBatchSize > 0 ? state.logBatchSize : 1;
+        _logFormat = (BEAMLogFormat)state.logFormat;
+        _logCompression = state.logCompression;
+        _lightAutoRange = state.lightAutoRange;
+        _fastSensors.cache() = state.sensors;
+    }
 
     bool allInitialized = true; // Assume everything is OK until proven otherwise
 
-    // Always reinitialize SD card after deep sleep
-    if (!initSD())
+    // Reinitialize SD card after deep sleep unless log records are being batched
+    if (_isWakeFromSleep && _logBatchSize > 1)
+    {
+        BEAM_INFOF(CORE, "  SD: deferred, %d of %d log records batched\n",
+                         _state.data().pendingRecords, _logBatchSize);
+    }
+    else if (!initSD())
     {
-        Serial.println("*** SD card initialization failed in begin() ***");
+        BEAM_ERRORF(CORE, "*** SD card initialization failed in begin() ***\n");
         allInitialized = false;
     }
 
@@ -113,33 +147,54 @@ bool HublinkBEAM::begin()
         digitalWrite(PIN_FRONT_LED, HIGH);
         _ulp.clearPIRCount();
         _ulp.clearInactivityCounters();
+        _ulp.clearEvents();
         _pir_percent_active = 0.0;
         _inactivity_fraction = 0.0;
-        alarm_interval = 0;
-        alarm_start_time = 0;
 
-        Serial.println("\nHublink BEAM Initialization Report:");
-        Serial.println("--------------------------------");
-        Serial.printf("PIR Sensor: %s\n", _isPIRInitialized ? "OK" : "FAILED");
-        Serial.printf("Battery Monitor: %s", _isBatteryMonitorInitialized ? "OK" : "FAILED");
+        // A reset that kept RTC memory intact (watchdog, reset button) can
+        // still hold batched records; write them out before starting over
+        if (_state.isValid() && _state.data().pendingRecords > 0 && _isSDInitialized && _isRTCInitialized)
+        {
+            BEAM_INFOF(CORE, "Recovering %d batched log records\n", _state.data().pendingRecords);
+            if (_state.data().deviceID[0] != '\0')
+            {
+                _deviceID = String(_state.data().deviceID);
+            }
+            _logFormat = (BEAMLogFormat)_state.data().logFormat;
+            _logCompression = _state.data().logCompression;
+            flushLog();
+        }
+        _state.reset();
+
+        // Store a new build's time now rather than at sleep(), so a reset
+        // before the first sleep does not set the clock back again
+        commitSettings();
+
+        BEAM_INFOF(CORE, "\nHublink BEAM Initialization Report:\n");
+        BEAM_INFOF(CORE, "--------------------------------\n");
+        BEAM_INFOF(CORE, "PIR Sensor: %s\n", _isPIRInitialized ? "OK" : "FAILED");
+        BEAM_INFOF(CORE, "Battery Monitor: %s", _isBatteryMonitorInitialized ? "OK" : "FAILED");
         if (_isBatteryMonitorInitialized)
         {
-            Serial.printf(" (%.2fV, %.1f%%)",
-                          _batteryMonitor.cellVoltage(),
-                          _batteryMonitor.cellPercent());
+            BEAM_INFOF(CORE, " (%.2fV, %.1f%%)",
+                             _batteryMonitor.cellVoltage(),
+                             _batteryMonitor.cellPercent());
         }
-        Serial.println();
-        Serial.printf("Environmental Sensor: %s\n", _isEnvSensorInitialized ? "OK" : "FAILED");
-        Serial.printf("Light Sensor: %s\n", _isLightSensorInitialized ? "OK" : "FAILED");
-        Serial.printf("RTC: %s\n", _isRTCInitialized ? "OK" : "FAILED");
-        Serial.printf("SD Card: %s\n", _isSDInitialized ? "OK" : "FAILED");
-        Serial.printf("Overall Status: %s\n", allInitialized ? "OK" : "FAILED");
-        Serial.println("--------------------------------");
+        BEAM_INFOF(CORE, "\n");
+        BEAM_INFOF(CORE, "Environmental Sensor: %s\n", _isEnvSensorInitialized ? "OK" : "FAILED");
+        BEAM_INFOF(CORE, "Light Sensor: %s\n", _isLightSensorInitialized ? "OK" : "FAILED");
+        BEAM_INFOF(CORE, "RTC: %s\n", _isRTCInitialized ? "OK" : "FAILED");
+        BEAM_INFOF(CORE, "SD Card: %s\n", _isSDInitialized ? "OK" : "FAILED");
+        BEAM_INFOF(CORE, "Overall Status: %s\n", allInitialized ? "OK" : "FAILED");
+        BEAM_INFOF(CORE, "--------------------------------\n");
     }
     else // waking from deep sleep
     {
-        // Calculate and store time values
-        _elapsed_seconds = getUnixTime() - sleep_start_time;
+        // Calculate and store time values; fall back to the requested
+        // duration if the RTC is unavailable
+        BEAMStateBlock &state = _state.data();
+        state.wakeCount++;
+        _elapsed_seconds = _isRTCInitialized ? getUnixTime() - state.sleepStartTime : state.sleepSeconds;
         _active_seconds = static_cast<double>(_ulp.getPIRCount()) * 1.0;
 
         // Calculate activity percentage
@@ -172,10 +227,10 @@ bool HublinkBEAM::begin()
         _inactivity_fraction = 100 / (100 + 0) = 1.0 (100% inactive)
         */
 
-        Serial.printf("\nActivity Report:\n");
-        Serial.printf("  Total time: %d seconds\n", _elapsed_seconds);
-        Serial.printf("  Active time: %.3f seconds\n", _active_seconds);
-        Serial.printf("  Activity percentage: %.3f%%\n", _pir_percent_active * 100.0);
+        BEAM_INFOF(CORE, "\nActivity Report:\n");
+        BEAM_INFOF(CORE, "  Total time: %d seconds\n", _elapsed_seconds);
+        BEAM_INFOF(CORE, "  Active time: %.3f seconds\n", _active_seconds);
+        BEAM_INFOF(CORE, "  Activity percentage: %.3f%%\n", _pir_percent_active * 100.0);
     }
 
     // Set final NeoPixel state based on initialization result
@@ -186,14 +241,14 @@ bool HublinkBEAM::begin()
     }
     else
     {
-        Serial.println("*** INITIALIZATION FAILED ***");
-        Serial.printf("  SD: %s\n", _isSDInitialized ? "OK" : "FAILED");
-        Serial.printf("  PIR: %s\n", _isPIRInitialized ? "OK" : "FAILED");
-        Serial.printf("  Battery: %s\n", _isBatteryMonitorInitialized ? "OK" : "FAILED");
-        Serial.printf("  Env: %s\n", _isEnvSensorInitialized ? "OK" : "FAILED");
-        Serial.printf("  Light: %s\n", _isLightSensorInitialized ? "OK" : "FAILED");
-        Serial.printf("  RTC: %s\n", _isRTCInitialized ? "OK" : "FAILED");
-        Serial.printf("  Low Battery: %s\n", _isLowBattery ? "YES" : "NO");
+        BEAM_ERRORF(CORE, "*** INITIALIZATION FAILED ***\n");
+        BEAM_ERRORF(CORE, "  SD: %s\n", _isSDInitialized ? "OK" : "FAILED");
+        BEAM_ERRORF(CORE, "  PIR: %s\n", _isPIRInitialized ? "OK" : "FAILED");
+        BEAM_ERRORF(CORE, "  Battery: %s\n", _isBatteryMonitorInitialized ? "OK" : "FAILED");
+        BEAM_ERRORF(CORE, "  Env: %s\n", _isEnvSensorInitialized ? "OK" : "FAILED");
+        BEAM_ERRORF(CORE, "  Light: %s\n", _isLightSensorInitialized ? "OK" : "FAILED");
+        BEAM_ERRORF(CORE, "  RTC: %s\n", _isRTCInitialized ? "OK" : "FAILED");
+        BEAM_ERRORF(CORE, "  Low Battery: %s\n", _isLowBattery ? "YES" : "NO");
 
         if (_isLowBattery)
         {
@@ -210,21 +265,24 @@ bool HublinkBEAM::begin()
     {
         uint32_t hash = hashMacAddress();
         uint16_t randomDelaySeconds = hash % (2 * _alarmRandomizationMinutes * 60 + 1);
-        Serial.printf("\nApplying random delay: %d seconds (%.1f minutes) based on MAC address\n",
-                      randomDelaySeconds, randomDelaySeconds / 60.0);
+        BEAM_INFOF(CORE, "\nApplying random delay: %d seconds (%.1f minutes) based on MAC address\n",
+                         randomDelaySeconds, randomDelaySeconds / 60.0);
 
         // Skip delay in debug mode (Switch A down) for faster development
         if (!switchADown())
         {
+            BEAMPhaseTimer delayTimer(_profile, BEAM_PHASE_RANDOM_DELAY);
             delay(randomDelaySeconds * 1000);
         }
         else
         {
-            Serial.println("Debug mode: skipping random delay");
+            BEAM_INFOF(CORE, "Debug mode: skipping random delay\n");
         }
     }
 
-    Serial.flush();
+    BEAMPhaseTimer flushTimer(_profile, BEAM_PHASE_SERIAL_FLUSH);
+    BEAM_DEBUG_FLUSH();
+    flushTimer.stop();
 
     return allInitialized;
 }
@@ -234,20 +292,10 @@ void HublinkBEAM::initPins()
     pinMode(LED_BUILTIN, OUTPUT);
     digitalWrite(LED_BUILTIN, LOW);
 
-    // Initialize SD card pins
-    pinMode(PIN_SD_CS, OUTPUT);
-    digitalWrite(PIN_SD_CS, HIGH);     // Deselect SD card by default
+    // SD card stays unpowered until initSD(); bus pins float until then
     pinMode(PIN_SD_DET, INPUT_PULLUP); // converts to input during sleep
     pinMode(PIN_SD_PWR_EN, OUTPUT);
-    enableSDPower();
-
-    // Add delay for SD card power stabilization
-    delay(50); // Give SD card time to power up and stabilize
-
-    // Ensure SPI pins are configured properly (especially after wake from sleep)
-    pinMode(MOSI, OUTPUT);
-    pinMode(MISO, INPUT);
-    pinMode(SCK, OUTPUT);
+    disableSDPower();
 
     // Initialize on-board LED
     pinMode(PIN_FRONT_LED, OUTPUT);
@@ -273,19 +321,38 @@ void HublinkBEAM::initPins()
 bool HublinkBEAM::initSensors(bool isWakeFromSleep)
 {
     bool allInitialized = true;
-    Serial.println("Initializing sensors...");
+    BEAM_VERBOSEF(CORE, "Initializing sensors...\n");
+
+    // On a timer wake, sensors whose registers still match the cache skip begin()
+    bool fast = isWakeFromSleep && _fastWake;
+    _fastSensorMask = 0;
 
     // Initialize battery monitor with detailed debug
-    if (!_batteryMonitor.begin(&Wire))
+    BEAMPhaseTimer batteryTimer(_profile, BEAM_PHASE_BATTERY_INIT);
+    bool batteryResumed = fast && _fastSensors.resumeBattery();
+    if (batteryResumed)
+    {
+        _fastSensorMask |= BEAM_SENSOR_BATTERY;
+        _isBatteryMonitorInitialized = true;
+        float voltage = _fastSensors.batteryVoltage();
+        BEAM_VERBOSEF(CORE, "  Battery: resumed (%.2fV)\n", voltage);
+        if (voltage < LOW_BATTERY_THRESHOLD)
+        {
+            BEAM_WARNF(CORE, "  Low battery detected: %.2fV (continuing - wake from sleep or debug mode)\n", voltage);
+            _isLowBattery = true;
+        }
+    }
+    else if (!_batteryMonitor.begin(&_wire))
     {
-        Serial.println("  Battery: failed to begin()");
+        BEAM_ERRORF(CORE, "  Battery: failed to begin()\n");
         allInitialized = false;
         _isBatteryMonitorInitialized = false;
     }
     else
     {
-        Serial.println("  Battery: begin() OK");
+        BEAM_VERBOSEF(CORE, "  Battery: begin() OK%s\n", fast ? " (cache mismatch)" : "");
         _isBatteryMonitorInitialized = true;
+        _fastSensors.captureBattery();
 
         // Replace single delay with retry loop
         const uint8_t MAX_RETRIES = 20;
@@ -296,7 +363,7 @@ bool HublinkBEAM::initSensors(bool isWakeFromSleep)
         {
             delay(10); // Shorter delay between attempts
             voltage = _batteryMonitor.cellVoltage();
-            Serial.printf("  Battery init - attempt %d: %.2fV\n", retries + 1, voltage);
+            BEAM_VERBOSEF(CORE, "  Battery init - attempt %d: %.2fV\n", retries + 1, voltage);
 
             if (voltage > 0 && !isnan(voltage))
             {
@@ -307,36 +374,44 @@ bool HublinkBEAM::initSensors(bool isWakeFromSleep)
 
         // Continue with existing battery check logic
         float percent = _batteryMonitor.cellPercent();
-        Serial.printf("  Battery debug - Final values:\n");
-        Serial.printf("    Voltage: %.2fV\n", voltage);
-        Serial.printf("    Percent: %.1f%%\n", percent);
-        Serial.printf("    isnan(voltage): %d\n", isnan(voltage));
+        BEAM_VERBOSEF(CORE, "  Battery debug - Final values:\n");
+        BEAM_VERBOSEF(CORE, "    Voltage: %.2fV\n", voltage);
+        BEAM_VERBOSEF(CORE, "    Percent: %.1f%%\n", percent);
+        BEAM_VERBOSEF(CORE, "    isnan(voltage): %d\n", isnan(voltage));
 
         // Only fail initialization for low battery on first boot (not wake from sleep)
         // Allow to run on low battery if switch A is down (debug mode) or waking from sleep
         if (voltage < LOW_BATTERY_THRESHOLD && !switchADown() && !isWakeFromSleep)
         {
-            Serial.printf("  Low battery detected on boot: %.2fV\n", voltage);
+            BEAM_WARNF(CORE, "  Low battery detected on boot: %.2fV\n", voltage);
             _isLowBattery = true;
             return false;
         }
         else if (voltage < LOW_BATTERY_THRESHOLD)
         {
-            Serial.printf("  Low battery detected: %.2fV (continuing - wake from sleep or debug mode)\n", voltage);
+            BEAM_WARNF(CORE, "  Low battery detected: %.2fV (continuing - wake from sleep or debug mode)\n", voltage);
             _isLowBattery = true;
         }
     }
+    batteryTimer.stop();
 
     // Initialize environmental sensor
-    if (!_envSensor.begin())
+    BEAMPhaseTimer envTimer(_profile, BEAM_PHASE_ENV_INIT);
+    if (fast && _fastSensors.resumeEnvironment())
+    {
+        BEAM_VERBOSEF(CORE, "  BME280: resumed\n");
+        _fastSensorMask |= BEAM_SENSOR_ENV;
+        _isEnvSensorInitialized = true;
+    }
+    else if (!_envSensor.begin(BME280_ADDRESS, &_wire))
     {
-        Serial.println("  BME280: failed");
+        BEAM_ERRORF(CORE, "  BME280: failed\n");
         allInitialized = false;
         _isEnvSensorInitialized = false;
     }
     else
     {
-        Serial.println("  BME280: OK");
+        BEAM_VERBOSEF(CORE, "  BME280: OK%s\n", fast ? " (cache mismatch)" : "");
         // Configure BME280 for forced mode with 1x oversampling
         _envSensor.setSampling(Adafruit_BME280::MODE_FORCED,
                                Adafruit_BME280::SAMPLING_X1, // temperature
@@ -344,57 +419,76 @@ bool HublinkBEAM::initSensors(bool isWakeFromSleep)
                                Adafruit_BME280::SAMPLING_X1, // humidity
                                Adafruit_BME280::FILTER_OFF);
         _isEnvSensorInitialized = true;
+        _fastSensors.captureEnvironment();
     }
+    envTimer.stop();
 
     // Initialize light sensor
-    if (!_lightSensor.begin())
+    BEAMPhaseTimer lightTimer(_profile, BEAM_PHASE_LIGHT_INIT);
+    if (fast && _fastSensors.resumeLight())
     {
-        Serial.println("  VEM7700: failed");
+        BEAM_VERBOSEF(CORE, "  VEM7700: resumed\n");
+        _fastSensorMask |= BEAM_SENSOR_LIGHT;
+        _isLightSensorInitialized = true;
+    }
+    else if (!_lightSensor.begin(&_wire))
+    {
+        BEAM_ERRORF(CORE, "  VEM7700: failed\n");
         allInitialized = false;
         _isLightSensorInitialized = false;
     }
     else
     {
-        Serial.println("  VEM7700: OK");
+        BEAM_VERBOSEF(CORE, "  VEM7700: OK%s\n", fast ? " (cache mismatch)" : "");
         _isLightSensorInitialized = true;
+        _fastSensors.captureLight();
     }
+    lightTimer.stop();
 
     // Initialize RTC
-    if (!_rtc.begin())
+    // The DS3231 keeps time on its own cell; a timer wake only checks
+    // lostPower() and never reads NVS, with or without fast wake
+    BEAMPhaseTimer rtcTimer(_profile, BEAM_PHASE_RTC_INIT);
+    bool rtcFast = fast && (_fastSensors.cache().valid & BEAM_SENSOR_RTC);
+    if (!_rtc.begin(&_wire, isWakeFromSleep, &_store))
     {
-        Serial.println("  RTC: failed");
+        BEAM_ERRORF(CORE, "  RTC: failed\n");
         allInitialized = false;
         _isRTCInitialized = false;
     }
     else
     {
-        Serial.println("  RTC: OK");
+        BEAM_VERBOSEF(CORE, "  RTC: OK%s\n", rtcFast ? " (resumed)" : "");
         _isRTCInitialized = true;
+        _fastSensors.cache().valid |= BEAM_SENSOR_RTC;
+        _fastSensorMask |= rtcFast ? BEAM_SENSOR_RTC : 0;
     }
+    rtcTimer.stop();
 
     // Initialize PIR sensor with optimized init for wake from sleep
-    if (!_pirSensor.begin(Wire, isWakeFromSleep))
+    BEAMPhaseTimer pirTimer(_profile, BEAM_PHASE_PIR_INIT);
+    if (!_pirSensor.begin(_wire, isWakeFromSleep))
     {
-        Serial.println("  PIR: failed");
+        BEAM_ERRORF(CORE, "  PIR: failed\n");
         allInitialized = false;
     }
     else
     {
-        Serial.println("  PIR: OK");
+        BEAM_VERBOSEF(CORE, "  PIR: OK\n");
         if (!isWakeFromSleep)
         {
-            Serial.println("  PIR: starting stabilization");
+            BEAM_VERBOSEF(CORE, "  PIR: starting stabilization\n");
             // Use delay if USB is connected, light sleep has issues disconnecting otherwise
             int delayTime = switchADown() ? 3000 : ZDP323_TSTAB_MS;
             if (Serial)
             {
-                Serial.println("  PIR: using delay (USB connected)");
+                BEAM_VERBOSEF(CORE, "  PIR: using delay (USB connected)\n");
                 setNeoPixel(NEOPIXEL_PURPLE);
                 delay(delayTime);
             }
             else
             {
-                Serial.println("  PIR: using light sleep");
+                BEAM_VERBOSEF(CORE, "  PIR: using light sleep\n");
                 esp_sleep_enable_timer_wakeup(delayTime * 1000); // Convert ms to microseconds
                 esp_light_sleep_start();
                 esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
@@ -402,8 +496,10 @@ bool HublinkBEAM::initSensors(bool isWakeFromSleep)
         }
         _isPIRInitialized = true;
     }
+    pirTimer.stop();
 
-    Serial.printf("  All sensors %s\n", allInitialized ? "OK" : "FAILED");
+    BEAM_INFOF(CORE, "  All sensors %s (%d of 4 resumed, %lu I2C transactions)\n", allInitialized ? "OK" : "FAILED",
+                     __builtin_popcount(_fastSensorMask), _wire.transactions());
     return allInitialized;
 }
 
@@ -423,11 +519,30 @@ void HublinkBEAM::disableNeoPixel()
 
 bool HublinkBEAM::initSD()
 {
+    if (_isSDInitialized)
+    {
+        return true;
+    }
+
     if (!isSDCardPresent())
     {
-        Serial.println("No SD card detected!");
+        BEAM_ERRORF(CORE, "No SD card detected!\n");
         return false;
     }
+    BEAMPhaseTimer timer(_profile, BEAM_PHASE_SD_INIT);
+
+    // Initialize SD card pins
+    pinMode(PIN_SD_CS, OUTPUT);
+    digitalWrite(PIN_SD_CS, HIGH); // Deselect SD card by default
+    enableSDPower();
+
+    // Add delay for SD card power stabilization
+    delay(50); // Give SD card time to power up and stabilize
+
+    // Ensure SPI pins are configured properly (especially after wake from sleep)
+    pinMode(MOSI, OUTPUT);
+    pinMode(MISO, INPUT);
+    pinMode(SCK, OUTPUT);
 
     // Try SD initialization with retry logic
     const uint8_t MAX_RETRIES = 3;
@@ -435,20 +550,21 @@ bool HublinkBEAM::initSD()
     {
         if (attempt > 0)
         {
-            Serial.printf("SD init retry %d/%d\n", attempt + 1, MAX_RETRIES);
+            BEAM_WARNF(CORE, "SD init retry %d/%d\n", attempt + 1, MAX_RETRIES);
             delay(100); // Brief delay between retries
         }
 
-        if (SD.begin(PIN_SD_CS))
+        if (SD.begin(PIN_SD_CS, SPI, 4000000, SD_MOUNT_POINT))
         {
             SD.exists("/x.txt"); // trick to enter SD idle state
+            _sdStorage.updateVolumeID();
             _isSDInitialized = true;
-            Serial.println("SD card initialized successfully");
+            BEAM_VERBOSEF(CORE, "SD card initialized successfully\n");
             return true;
         }
     }
 
-    Serial.println("SD card initialization failed after all retries!");
+    BEAM_ERRORF(CORE, "SD card initialization failed after all retries!\n");
     return false;
 }
 
@@ -477,350 +593,554 @@ bool HublinkBEAM::switchBDown()
     return digitalRead(PIN_SWITCH_B) == LOW;
 }
 
-String HublinkBEAM::getCurrentFilename()
+bool HublinkBEAM::logData()
 {
+    if (switchADown())
+    {
+        delay(2000);
+    }
+
+    BEAMPhaseTimer readTimer(_profile, BEAM_PHASE_SENSOR_READ);
+    LogRecord record = {};
+    record.activityCount = _ulp.getPIRCount(); // clear in sleep()
+    for (uint8_t i = 0; i < LOG_INACTIVITY_THRESHOLDS; i++)
+    {
+        record.inactivityPeriods[i] = _inactivityPeriods[i];
+        record.inactivityCounts[i] = (_inactivityPeriods[i] > 0) ? _ulp.getInactivityCount(i) : 0;
+    }
+    record.longestInactive = _isWakeFromSleep ? _ulp.getLongestInactiveBout() : 0; // 1-second windows
+    record.inactiveBouts = _isWakeFromSleep ? _ulp.getInactiveBoutCount() : 0;
+    record.powerLevel = getPowerLevel();
+    record.sleepSeconds = _isWakeFromSleep ? _state.data().sleepSeconds : 0;
+    _minFreeHeap = ESP.getMinFreeHeap();
+
+    // Check for required sensors; the SD card is only needed when flushing
+    if (!_isRTCInitialized)
+    {
+        BEAM_ERRORF(CORE, "Cannot log: RTC not initialized\n");
+        setNeoPixel(NEOPIXEL_RED);
+        return false;
+    }
+
+    // Set initial NeoPixel color based on motion
+    setNeoPixel(record.activityCount ? NEOPIXEL_GREEN : NEOPIXEL_BLUE);
+
+    // Get date/time and sensor readings
     DateTime now = getDateTime();
-    Serial.println("\nGetting current filename...");
-    Serial.printf("  Wake from sleep: %s\n", _isWakeFromSleep ? "YES" : "NO");
-    Serial.printf("  newFileOnBoot: %s\n", getNewFileOnBoot() ? "YES" : "NO");
-
-    // First check stored filename from preferences
-    _preferences.begin(PREFS_NAMESPACE, false);
-    String storedFilename = _preferences.getString("filename", "");
-    _preferences.end();
-
-    // If we have a stored filename, check if it's from today
-    if (storedFilename.length() > 0)
-    {
-        // Extract date from stored filename (format: /BEAMXXX_YYYYMMDDXX.csv)
-        // Find the underscore after device ID to locate the date part
-        int underscorePos = storedFilename.indexOf('_');
-        if (underscorePos != -1)
-        {
-            int dateStart = underscorePos + 1;
-            int storedYear = storedFilename.substring(dateStart, dateStart + 4).toInt();
-            int storedMonth = storedFilename.substring(dateStart + 4, dateStart + 6).toInt();
-            int storedDay = storedFilename.substring(dateStart + 6, dateStart + 8).toInt();
-
-            Serial.println("\nComparing dates:");
-            Serial.printf("  Stored filename: %s\n", storedFilename.c_str());
-            Serial.printf("  Stored date: %04d-%02d-%02d\n", storedYear, storedMonth, storedDay);
-            Serial.printf("  Current date: %04d-%02d-%02d\n", now.year(), now.month(), now.day());
-
-            bool isFromToday = (storedYear == now.year() &&
-                                storedMonth == now.month() &&
-                                storedDay == now.day());
-
-            // If waking from sleep and file is from today, use it
-            if (_isWakeFromSleep && isFromToday && SD.exists(storedFilename))
-            {
-                Serial.printf("  Using existing file (wake from sleep): %s\n", storedFilename.c_str());
-                return storedFilename;
-            }
+    record.timestamp = now.unixtime();
+    record.millis = millis();
+    readTimer.stop();
+    acquireSensors(record);
 
-            // If not waking from sleep and newFileOnBoot is false, try to use today's file
-            if (!_isWakeFromSleep && !getNewFileOnBoot() && isFromToday && SD.exists(storedFilename))
-            {
-                Serial.printf("  Using existing file (same day): %s\n", storedFilename.c_str());
-                return storedFilename;
-            }
-        }
-        else
+    // Calculate inactivity fraction if period is set and we're waking from sleep
+    _inactivity_fraction = 0.0; // Default for non-wake or no period set
+    if (_isWakeFromSleep && _inactivityPeriods[0] > 0)
+    {
+        const double possible_inactive_periods = static_cast<double>(_elapsed_seconds) /
+                                                 static_cast<double>(_inactivityPeriods[0]);
+        if (possible_inactive_periods > 0)
         {
-            Serial.println("  Invalid stored filename format (no underscore found)");
+            const double inactive_seconds = static_cast<double>(record.inactivityCounts[0]) *
+                                            static_cast<double>(_inactivityPeriods[0]);
+            // note, inactive seconds is tallied based on the inactivity period, not actual single seconds.
+            // So by including active_seconds in the denominator, we are able to calculate the fraction of time
+            // that was inactive to include the time outside of the last inactivity period; even a full
+            // period wasn't met, we still have a true fraction of time that was inactive.
+            _inactivity_fraction = std::min(1.0,
+                                            inactive_seconds / (inactive_seconds + _active_seconds));
         }
     }
 
-    // If we get here, we need to either:
-    // 1. Find first existing file from today (if !newFileOnBoot)
-    // 2. Create a new file (if newFileOnBoot or no existing file found)
-
-    // Try to find existing file from today if newFileOnBoot is false
-    if (!getNewFileOnBoot())
+    if (_inactivityPeriods[0] > 0)
     {
-        char baseFilename[11]; // YYYYMMDD (8 chars + null terminator)
-        snprintf(baseFilename, sizeof(baseFilename), "%04d%02d%02d",
-                 now.year(), now.month(), now.day());
+        BEAM_VERBOSEF(CORE, "  Inactivity period: %d seconds\n", _inactivityPeriods[0]);
+        BEAM_VERBOSEF(CORE, "  Inactivity fraction: %.3f%%\n", _inactivity_fraction * 100.0);
+    }
 
-        Serial.println("  Looking for existing files from today:");
-        // Try each possible number (00-99)
-        for (uint8_t num = 0; num < 100; num++)
-        {
-            char testFilename[28]; // /BEAMXXX_YYYYMMDDXX.csv (23 chars + null terminator)
-            snprintf(testFilename, sizeof(testFilename), "/BEAM%s_%s%02d.csv",
-                     _deviceID.c_str(), baseFilename, num);
-            Serial.printf("    Testing: %s - ", testFilename);
+    record.activityPercent = _pir_percent_active;
+    record.inactivityPercent = _inactivity_fraction;
+    record.minFreeHeap = _minFreeHeap;
+    record.reboot = !_isWakeFromSleep;
 
-            if (SD.exists(testFilename))
+    // Print the columns as they will be logged; record_seq and crc are
+    // assigned when the record is flushed
+    if (BEAM_DEBUG_ENABLED(BEAM_DEBUG_INFO, CORE))
+    {
+        BEAM_INFOF(CORE, "\nLog record:\n");
+        BEAMLogColumns::forEach(
+            [&](const BEAMLogColumn &column, int id, size_t)
             {
-                Serial.println("exists, using this file");
-                _preferences.begin(PREFS_NAMESPACE, false);
-                _preferences.putString("filename", String(testFilename));
-                _preferences.end();
-                return String(testFilename);
-            }
-            Serial.println("not found");
-        }
-        Serial.println("  No existing files found from today");
+                char value[32];
+                if (id != BEAM_COL_RECORD_SEQ && column.type != BEAM_COL_TYPE_CRC &&
+                    beamFormatColumn(column, id, record, 0,
+                                     id == BEAM_COL_DEVICE_ID ? _deviceID.c_str() : HUBLINK_BEAM_VERSION,
+                                     value, sizeof(value)) >= 0)
+                {
+                    BEAM_INFOF(CORE, "  %-22s %s\n", column.name, value);
+                }
+                return true;
+            });
     }
 
-    // Create new file with next available number
-    char baseFilename[11];
-    snprintf(baseFilename, sizeof(baseFilename), "%04d%02d%02d",
-             now.year(), now.month(), now.day());
-    Serial.printf("  Base filename: %s\n", baseFilename);
+    // Decide before queueing, so the new record counts toward the batch
+    bool flush = isLogFlushDue();
+    queueLogRecord(record);
 
-    Serial.println("  Scanning for next available number:");
-    uint8_t nextNum = 0;
-    while (nextNum < 100)
+    bool success = true;
+    if (flush)
     {
-        char testFilename[28]; // /BEAMXXX_YYYYMMDDXX.csv (23 chars + null terminator)
-        snprintf(testFilename, sizeof(testFilename), "/BEAM%s_%s%02d.csv",
-                 _deviceID.c_str(), baseFilename, nextNum);
-        Serial.printf("    Testing: %s - ", testFilename);
+        success = flushLog();
 
-        if (!SD.exists(testFilename))
+        // Motion events only accumulate while asleep
+        if (success && _motionEventLog && _isWakeFromSleep && !isPowerSkipped(BEAM_POWER_SKIP_EXTRAS))
         {
-            Serial.println("available");
-            _preferences.begin(PREFS_NAMESPACE, false);
-            _preferences.putString("filename", String(testFilename));
-            _preferences.end();
-            Serial.println("  Stored in preferences");
-            return String(testFilename);
+            logMotionEvents(_logWriter.currentFile());
         }
-        Serial.println("exists");
-        nextNum++;
+        if (success && _wakeProfiling && !isPowerSkipped(BEAM_POWER_SKIP_EXTRAS))
+        {
+            logWakeProfiles(_logWriter.currentFile());
+        }
+    }
+    else
+    {
+        BEAM_INFOF(CORE, "Batched log record %d/%d, SD flush deferred\n",
+                         _state.data().pendingRecords, _logBatchSize);
+    }
+
+    if (success)
+    {
+        disableNeoPixel(); // Turn off if everything was OK
     }
+    BEAMPhaseTimer flushTimer(_profile, BEAM_PHASE_SERIAL_FLUSH);
+    BEAM_DEBUG_FLUSH();
+    flushTimer.stop();
 
-    Serial.println("Error: No available file numbers!");
-    return String();
+    return success;
 }
 
-bool HublinkBEAM::createFile(String filename)
+void HublinkBEAM::acquireSensors(LogRecord &record)
 {
-    // Ensure filename starts with a forward slash
-    if (!filename.startsWith("/"))
+    // Start every conversion, read what needs none, then sleep until the
+    // slowest is due: the wake costs the longest conversion, not their sum.
+    // Conversions are started at register level, which needs the cache that
+    // every init fills; without it a sensor is read through its driver.
+    BEAMPhaseTimer startTimer(_profile, BEAM_PHASE_SENSOR_READ);
+    uint8_t cached = _fastSensors.cache().valid;
+    bool envWanted = _isEnvSensorInitialized && !isPowerSkipped(BEAM_POWER_SKIP_ENV);
+    bool lightWanted = _isLightSensorInitialized && !isPowerSkipped(BEAM_POWER_SKIP_LIGHT);
+    bool env = envWanted && (cached & BEAM_SENSOR_ENV) && _fastSensors.startEnvironment();
+    bool light = lightWanted && (cached & BEAM_SENSOR_LIGHT);
+    uint32_t due = env ? _fastSensors.environmentDueMillis() : millis();
+    if (light && (int32_t)(_fastSensors.lightDueMillis() - due) > 0)
+    {
+        due = _fastSensors.lightDueMillis();
+    }
+    record.batteryVoltage = _isBatteryMonitorInitialized ? getBatteryVoltage() : -1.0f;
+    startTimer.stop();
+
+    BEAMPhaseTimer waitTimer(_profile, BEAM_PHASE_SENSOR_WAIT);
+    waitUntil(due);
+    waitTimer.stop();
+
+    BEAMPhaseTimer collectTimer(_profile, BEAM_PHASE_SENSOR_READ);
+    if (env && _fastSensors.collectEnvironment())
+    {
+        record.temperatureC = _fastSensors.temperature();
+        record.pressureHpa = _fastSensors.pressure() / 100.0F;
+        record.humidityPercent = _fastSensors.humidity();
+    }
+    else if (envWanted)
+    {
+        if (!(_fastSensorMask & BEAM_SENSOR_ENV))
+        {
+            _envSensor.takeForcedMeasurement();
+        }
+        record.temperatureC = getTemperature();
+        record.pressureHpa = getPressure();
+        record.humidityPercent = getHumidity();
+    }
+    else
     {
-        filename = "/" + filename;
+        record.temperatureC = -273.15f;
+        record.pressureHpa = -1.0f;
+        record.humidityPercent = -1.0f;
     }
-
-    File file = SD.open(filename, FILE_WRITE);
-    if (!file)
+    record.lightSetting = BEAM_LIGHT_SETTING_NONE;
+    if (light)
     {
-        Serial.println("Failed to create file: " + filename);
-        return false;
+        uint16_t raw = _fastSensors.readALS();
+        for (uint8_t step = 0; _lightAutoRange && step < BEAM_VEML7700_RANGE_STEPS; step++)
+        {
+            int range = beamVEML7700NextRange(_fastSensors.cache().vemlConfig, raw);
+            if (range < 0 || !_fastSensors.setLightConfig(BEAM_VEML7700_GAIN_MASK | BEAM_VEML7700_IT_MASK,
+                                                          beamVEML7700RangeConfig(range)))
+            {
+                break;
+            }
+            BEAM_VERBOSEF(CORE, "  VEM7700: %u counts, range %d (%d ms)\n", raw, range,
+                                beamVEML7700IntegrationMs(_fastSensors.cache().vemlConfig));
+            collectTimer.stop();
+            waitTimer.start();
+            waitUntil(_fastSensors.lightDueMillis());
+            waitTimer.stop();
+            collectTimer.start();
+            raw = _fastSensors.readALS();
+        }
+        record.lux = raw * beamVEML7700Resolution(_fastSensors.cache().vemlConfig); // As readLux(VEML_LUX_NORMAL)
+        record.lightSetting = beamVEML7700Setting(_fastSensors.cache().vemlConfig);
+    }
+    else
+    {
+        record.lux = lightWanted ? getLux() : -1.0f;
     }
+}
 
-    // Write header row
-    if (file.println(CSV_HEADER))
+void HublinkBEAM::waitUntil(uint32_t dueMillis)
+{
+    int32_t remaining = (int32_t)(dueMillis - millis());
+    if (remaining <= 0)
     {
-        Serial.println("Created new log file: " + filename);
-        file.close();
-        return true;
+        return;
     }
+    // Use delay if USB is connected, light sleep has issues disconnecting otherwise
+    if (Serial || remaining < LIGHT_SLEEP_MIN_MS)
+    {
+        delay(remaining);
+        return;
+    }
+    BEAM_DEBUG_FLUSH(); // The UART stops in light sleep
+    esp_sleep_enable_timer_wakeup((uint64_t)remaining * 1000);
+    esp_light_sleep_start();
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+}
 
-    Serial.println("Failed to write header to file: " + filename);
-    file.close();
-    return false;
+void HublinkBEAM::setLogBatchSize(uint8_t records)
+{
+    _logBatchSize = constrain(records, 1, LOG_BATCH_CAPACITY);
 }
 
-bool HublinkBEAM::logData()
+bool HublinkBEAM::isLogFlushDue()
 {
-    if (switchADown())
+    BEAMStateBlock &state = _state.data();
+    bool eventLog = _motionEventLog && !isPowerSkipped(BEAM_POWER_SKIP_EXTRAS);
+    return !_isWakeFromSleep ||                        // boot: write immediately
+           state.pendingRecords + 1 >= _logBatchSize || // batch full with the next record
+           _isLowBattery ||                             // flush while there is power to do it
+           eventLog ||                                  // event file is written every wake
+           isAlarmDue();                                // sync will want the data
+}
+
+void HublinkBEAM::queueLogRecord(const LogRecord &record)
+{
+    BEAMStateBlock &state = _state.data();
+    if (state.pendingRecords >= LOG_BATCH_CAPACITY)
     {
-        delay(2000);
+        // SD unavailable for a full batch: keep the newest records
+        memmove(&state.records[0], &state.records[1], sizeof(LogRecord) * (LOG_BATCH_CAPACITY - 1));
+        state.pendingRecords--;
+        state.droppedRecords++;
+        BEAM_WARNF(CORE, "Log batch full, dropped oldest record (%d total)\n", state.droppedRecords);
     }
+    state.records[state.pendingRecords++] = record;
+}
 
-    uint16_t pirCount = _ulp.getPIRCount(); // clear in sleep()
-    uint16_t inactivityCount = (_inactivityPeriod > 0) ? _ulp.getInactivityCount() : 0;
-    _minFreeHeap = ESP.getMinFreeHeap();
-
-    // Check for required sensors and SD card
-    if (!_isSDInitialized)
+bool HublinkBEAM::flushLog()
+{
+    BEAMStateBlock &state = _state.data();
+    if (state.pendingRecords == 0)
     {
-        Serial.println("Cannot log: SD card not initialized");
-        setNeoPixel(NEOPIXEL_RED);
-        return false;
+        return true;
     }
 
-    if (!isSDCardPresent())
+    // Power, mount and check the SD card unless another backend is in use
+    bool onSD = _logWriter.getStorage() == &_sdStorage;
+    if (onSD && !initSD())
     {
-        Serial.println("Cannot log: SD card not present");
+        BEAM_ERRORF(CORE, "Cannot flush log: SD card not initialized\n");
         setNeoPixel(NEOPIXEL_RED);
         return false;
     }
 
-    // Test SD card is actually working by attempting to read card info
-    if (!SD.cardSize())
+    BEAMPhaseTimer checkTimer(_profile, BEAM_PHASE_SD_CHECK);
+    if (onSD && !isSDCardPresent())
     {
-        Serial.println("Cannot log: SD card not responding (cardSize failed)");
+        BEAM_ERRORF(CORE, "Cannot flush log: SD card not present\n");
         setNeoPixel(NEOPIXEL_RED);
         return false;
     }
 
-    if (!_isRTCInitialized)
+    // Test SD card is actually working by attempting to read card info
+    if (onSD && !SD.cardSize())
     {
-        Serial.println("Cannot log: RTC not initialized");
+        BEAM_ERRORF(CORE, "Cannot flush log: SD card not responding (cardSize failed)\n");
         setNeoPixel(NEOPIXEL_RED);
         return false;
     }
 
-    String currentFile = getCurrentFilename();
+    checkTimer.stop();
 
-    // Check if file exists, create it with header if it doesn't
-    if (!SD.exists(currentFile))
+    // Write runs of records from the same day to that day's file
+    uint32_t writeStart = beamProfileMicros();
+    _logWriter.configure(logSettings());
+    uint8_t written = _logWriter.writeRecords(state.records, state.pendingRecords);
+    uint32_t selectMicros = _logWriter.selectMicros();
+    _profile.phaseMicros[BEAM_PHASE_FILE_SELECT] += selectMicros;
+    _profile.phaseMicros[BEAM_PHASE_FILE_WRITE] += beamProfileMicros() - writeStart - selectMicros;
+    bool success = written == state.pendingRecords;
+    if (written > 0)
     {
-        if (!createFile(currentFile))
-        {
-            setNeoPixel(NEOPIXEL_RED);
-            delay(1000); // linger for a moment on error
-            return false;
-        }
+        // Where a cold boot starts its scan for today's files; NVS is
+        // written at sleep(), and only when the file changed
+        _store.set(BEAM_SETTING_LAST_FILE, state.fileDay << 8 | state.fileSequence);
+        _store.set(BEAM_SETTING_LAST_FILE_CARD, state.fileCardID);
     }
-
-    // Open file in append mode
-    File dataFile = SD.open(currentFile, FILE_APPEND);
-    if (!dataFile)
+    if (!success && onSD)
     {
-        Serial.println("Failed to open file for logging: " + currentFile);
-        Serial.println("*** SD card may have failed after initialization ***");
         // Try to check if SD card is still present and working
         if (!isSDCardPresent())
         {
-            Serial.println("SD card no longer present!");
+            BEAM_ERRORF(CORE, "SD card no longer present!\n");
         }
         else if (!SD.cardSize())
         {
-            Serial.println("SD card no longer responding!");
+            BEAM_ERRORF(CORE, "SD card no longer responding!\n");
         }
-        setNeoPixel(NEOPIXEL_RED);
-        delay(1000); // linger for a moment on error
-        return false;
     }
 
-    // Set initial NeoPixel color based on motion
-    setNeoPixel(pirCount ? NEOPIXEL_GREEN : NEOPIXEL_BLUE);
+    // Keep whatever did not make it to the card for the next flush
+    state.pendingRecords -= written;
+    if (state.pendingRecords > 0)
+    {
+        memmove(&state.records[0], &state.records[written], sizeof(LogRecord) * state.pendingRecords);
+    }
+    const BEAMStorageStats &io = _logWriter.getStorage()->stats();
+    BEAM_INFOF(CORE, "Flushed %d log records to %s (%lu storage ops, %lu bytes written since boot)\n",
+                     written, _logWriter.currentFile(), io.operations(), io.bytesWritten);
 
-    // Get date/time and sensor readings
-    DateTime now = getDateTime();
+    if (!success)
+    {
+        setNeoPixel(NEOPIXEL_RED); // Show error state
+        delay(1000);               // linger for a moment on error
+    }
+    return success;
+}
+
+BEAMLogSettings HublinkBEAM::logSettings()
+{
+    BEAMLogSettings settings;
+    strlcpy(settings.deviceID, _deviceID.c_str(), sizeof(settings.deviceID));
+    settings.libraryVersion = HUBLINK_BEAM_VERSION;
+    settings.format = _logFormat;
+    settings.compression = _logCompression;
+    settings.newFileOnBoot = _newFileOnBoot;
+    settings.wakeFromSleep = _isWakeFromSleep;
+    settings.lastFile = _store.get(BEAM_SETTING_LAST_FILE);
+    settings.lastFileCard = _store.get(BEAM_SETTING_LAST_FILE_CARD);
+    return settings;
+}
 
-    // Take forced measurement before reading BME280 values
-    if (_isEnvSensorInitialized)
+bool HublinkBEAM::logMotionEvents(String dataFilename)
+{
+    BEAMPhaseTimer timer(_profile, BEAM_PHASE_EVENTS);
+    ULPMotionEvent events[ULP_EVENT_BUFFER_SIZE];
+    uint16_t count = _ulp.readEvents(events, ULP_EVENT_BUFFER_SIZE);
+    uint16_t dropped = _ulp.getEventOverflow();
+    uint16_t windows = _ulp.getWindowCount();
+
+    if (count == 0 && dropped == 0)
     {
-        _envSensor.takeForcedMeasurement();
+        return true;
     }
 
-    float batteryV = _isBatteryMonitorInitialized ? getBatteryVoltage() : -1.0f;
-    float tempC = _isEnvSensorInitialized ? getTemperature() : -273.15f;
-    float pressHpa = _isEnvSensorInitialized ? getPressure() : -1.0f;
-    float humidity = _isEnvSensorInitialized ? getHumidity() : -1.0f;
-    float lux = _isLightSensorInitialized ? getLux() : -1.0f;
+    // /BEAMXXX_YYYYMMDDXX.csv -> /BEAMXXX_YYYYMMDDXX_events.csv
+    String eventFile = dataFilename.substring(0, dataFilename.length() - 4) + "_events.csv";
+    BEAMStorage &storage = *_logWriter.getStorage();
+    if (!storage.exists(eventFile.c_str()) && !_logWriter.createFile(eventFile.c_str(), EVENTS_CSV_HEADER))
+    {
+        return false;
+    }
 
-    // Calculate inactivity fraction if period is set and we're waking from sleep
-    _inactivity_fraction = 0.0; // Default for non-wake or no period set
-    if (_isWakeFromSleep && _inactivityPeriod > 0)
+    BEAMFile file = storage.open(eventFile.c_str(), BEAM_OPEN_APPEND);
+    if (!file)
     {
-        const double possible_inactive_periods = static_cast<double>(_elapsed_seconds) /
-                                                 static_cast<double>(_inactivityPeriod);
-        if (possible_inactive_periods > 0)
-        {
-            const double inactive_seconds = static_cast<double>(inactivityCount) *
-                                            static_cast<double>(_inactivityPeriod);
-            // note, inactive seconds is tallied based on _inactivityPeriod, not actual single seconds.
-            // So by including active_seconds in the denominator, we are able to calculate the fraction of time
-            // that was inactive to include the time outside of the last _inactivityPeriod; even a full
-            // _inactivityPeriod wasn't met, we still have a true fraction of time that was inactive.
-            _inactivity_fraction = std::min(1.0,
-                                            inactive_seconds / (inactive_seconds + _active_seconds));
-        }
+        BEAM_ERRORF(CORE, "Failed to open events file: %s\n", eventFile.c_str());
+        return false;
     }
 
-    if (_inactivityPeriod > 0)
-    {
-        Serial.printf("  Inactivity period: %d seconds\n", _inactivityPeriod);
-        Serial.printf("  Inactivity fraction: %.3f%%\n", _inactivity_fraction * 100.0);
-    }
-
-    // Format data string with new fields
-    char dataString[128];
-    snprintf(dataString, sizeof(dataString),
-             "%04d-%02d-%02d %02d:%02d:%02d,%lu,%s,%s,%.3f,%.2f,%.2f,%.2f,%.4f,%d,%.3f,%d,%d,%.3f,%lu,%d",
-             now.year(), now.month(), now.day(),
-             now.hour(), now.minute(), now.second(),
-             millis(),
-             _deviceID.c_str(),
-             HUBLINK_BEAM_VERSION,
-             batteryV,
-             tempC,
-             pressHpa,
-             humidity,
-             lux,
-             pirCount,
-             _pir_percent_active,
-             _inactivityPeriod,
-             inactivityCount,
-             _inactivity_fraction,
-             _minFreeHeap,
-             !_isWakeFromSleep);
-
-    // Write data
-    bool success = dataFile.println(dataString);
-    dataFile.close();
-
-    // Print formatted values using the same variables
-    char datetime[20];
-    snprintf(datetime, sizeof(datetime), "%04d-%02d-%02d %02d:%02d:%02d",
-             now.year(), now.month(), now.day(),
-             now.hour(), now.minute(), now.second());
-
-    Serial.println("\n" + currentFile + ":");
-    Serial.println("DateTime:    " + String(datetime));
-    Serial.println("Millis:      " + String(millis()));
-    Serial.println("Device ID:   " + _deviceID);
-    Serial.println("Version:     " + String(HUBLINK_BEAM_VERSION));
-    Serial.println("Battery V:   " + String(batteryV));
-    Serial.println("Temp °C:     " + String(tempC));
-    Serial.println("Press hPa:   " + String(pressHpa));
-    Serial.println("Humidity %:  " + String(humidity));
-    Serial.println("Light lux:   " + String(lux));
-    Serial.println("PIR Count:   " + String(pirCount));
-    Serial.println("PIR Active:  " + String(_pir_percent_active));
-    Serial.println("Inact Sec:   " + String(_inactivityPeriod));
-    Serial.println("Inact Count: " + String(inactivityCount));
-    Serial.println("Inact Frac:  " + String(_inactivity_fraction));
-    Serial.println("Min Heap:    " + String(_minFreeHeap));
-    Serial.println("Is Reboot:   " + String(!_isWakeFromSleep));
+    // Windows are ~1 second; spread them over the time since the tick
+    // restarted, which spans several sleeps if earlier events were kept
+    uint32_t eventStart = _state.data().eventStartTime;
+    uint32_t span = _isRTCInitialized ? getUnixTime() - eventStart : _elapsed_seconds;
+    double windowSeconds = (windows > 0) ? static_cast<double>(span) / windows : 1.0;
+    char line[40];
+    bool written = true;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        DateTime t(eventStart + static_cast<uint32_t>((events[i].window - 1) * windowSeconds));
+        snprintf(line, sizeof(line), "%04d-%02d-%02d %02d:%02d:%02d,%lu,%s",
+                 t.year(), t.month(), t.day(), t.hour(), t.minute(), t.second(),
+                 events[i].window, events[i].onset ? "onset" : "offset");
+        written = file.println(line) > 0 && written;
+    }
 
-    if (success)
+    // Buffer overflowed during sleep: window column holds the number of lost events
+    if (dropped > 0)
     {
-        disableNeoPixel(); // Turn off if everything was OK
+        DateTime now = getDateTime();
+        snprintf(line, sizeof(line), "%04d-%02d-%02d %02d:%02d:%02d,%d,dropped",
+                 now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second(),
+                 dropped);
+        written = file.println(line) > 0 && written;
     }
-    else
+    file.close();
+    if (!written)
     {
-        Serial.println("Failed to write to file: " + currentFile);
-        setNeoPixel(NEOPIXEL_RED); // Show error state
-        delay(1000);               // linger for a moment on error
+        BEAM_ERRORF(CORE, "Failed to write motion events to %s, keeping them for the next wake\n", eventFile.c_str());
+        return false;
     }
-    Serial.flush();
 
-    return success;
+    _ulp.consumeEvents(count, dropped);
+    BEAM_INFOF(CORE, "Logged %d motion events (%d dropped) to %s\n", count, dropped, eventFile.c_str());
+    return true;
+}
+
+BEAMEnergyEstimate HublinkBEAM::estimateEnergy(uint32_t sleepMinutes, uint32_t syncEveryMinutes, uint32_t syncSeconds)
+{
+    BEAMWakeProfile profile = _profile;
+    profile.awakeMicros = beamProfileMicros(); // up to now
+    BEAMEnergyConfig config = beamDefaultEnergyConfig(sleepMinutes);
+    config.syncEveryMinutes = syncEveryMinutes;
+    config.syncSeconds = syncSeconds;
+    config.ulpTimerMode = _ulp.getSamplingMode() == ULP_MODE_TIMER;
+    config.sdShare = 1.0f / _logBatchSize; // SD phases are measured on flush wakes
+    config.batteryMAh = _batteryMAh;
+    return beamEstimateEnergy(profile, config, _energyCurrents);
+}
+
+void HublinkBEAM::queueWakeProfile()
+{
+    BEAMStateBlock &state = _state.data();
+    _profile.timestamp = _isRTCInitialized ? state.sleepStartTime : 0;
+    _profile.wake = _isWakeFromSleep ? state.wakeCount : 0;
+    _profile.sleepSeconds = state.sleepSeconds;
+    _profile.awakeMicros = beamProfileMicros();
+    _profile.i2cTransactions = _wire.transactions();
+    if (state.pendingProfiles >= BEAM_PROFILE_CAPACITY)
+    {
+        // No flush for a while: keep the newest profiles
+        memmove(&state.profiles[0], &state.profiles[1], sizeof(BEAMWakeProfile) * (BEAM_PROFILE_CAPACITY - 1));
+        state.pendingProfiles--;
+    }
+    state.profiles[state.pendingProfiles++] = _profile;
+}
+
+bool HublinkBEAM::logWakeProfiles(String dataFilename)
+{
+    BEAMStateBlock &state = _state.data();
+    if (state.pendingProfiles == 0)
+    {
+        return true;
+    }
+
+    // /BEAMXXX_YYYYMMDDXX.csv -> /BEAMXXX_YYYYMMDDXX_profile.csv
+    String profileFile = dataFilename.substring(0, dataFilename.length() - 4) + "_profile.csv";
+    BEAMStorage &storage = *_logWriter.getStorage();
+    if (!storage.exists(profileFile.c_str()) && !_logWriter.createFile(profileFile.c_str(), BEAM_PROFILE_CSV_HEADER))
+    {
+        return false;
+    }
+
+    BEAMFile file = storage.open(profileFile.c_str(), BEAM_OPEN_APPEND);
+    if (!file)
+    {
+        BEAM_ERRORF(CORE, "Failed to open profile file: %s\n", profileFile.c_str());
+        return false;
+    }
+
+    // datetime (19 characters), then up to 10 digits and a comma per column
+    char line[19 + (BEAM_PHASE_COUNT + 8) * 11 + 1];
+    BEAMEnergyConfig config = beamDefaultEnergyConfig(0);
+    config.ulpTimerMode = _ulp.getSamplingMode() == ULP_MODE_TIMER;
+    config.batteryMAh = _batteryMAh;
+    float totalUAh = 0;
+    float totalSeconds = 0;
+    for (uint8_t i = 0; i < state.pendingProfiles; i++)
+    {
+        const BEAMWakeProfile &profile = state.profiles[i];
+        config.sleepSeconds = profile.sleepSeconds;
+        BEAMEnergyEstimate estimate = beamEstimateEnergy(profile, config, _energyCurrents);
+        totalUAh += estimate.cycleUAh;
+        totalSeconds += estimate.cycleSeconds;
+
+        char *out = line + beamWriteDateTime(line, profile.timestamp);
+        *out++ = ',';
+        out += beamWriteUnsigned(out, profile.wake);
+        *out++ = ',';
+        out += beamWriteUnsigned(out, profile.sleepSeconds);
+        *out++ = ',';
+        out += beamWriteUnsigned(out, profile.awakeMicros);
+        uint32_t accounted = 0;
+        for (uint8_t phase = 0; phase < BEAM_PHASE_COUNT; phase++)
+        {
+            *out++ = ',';
+            out += beamWriteUnsigned(out, profile.phaseMicros[phase]);
+            accounted += profile.phaseMicros[phase];
+        }
+        *out++ = ',';
+        out += beamWriteUnsigned(out, profile.awakeMicros > accounted ? profile.awakeMicros - accounted : 0);
+        *out++ = ',';
+        out += beamWriteFixed(out, lroundf(estimate.cycleUAh * 10), 1);
+        *out++ = ',';
+        out += beamWriteFixed(out, lroundf(estimate.days * 10), 1);
+        *out++ = ',';
+        out += beamWriteUnsigned(out, profile.i2cTransactions);
+        *out = '\0';
+        file.println(line);
+    }
+    file.close();
+
+    // The wakes since the last flush are a full batch cycle, so their mean is representative
+    float averageUA = totalSeconds > 0 ? totalUAh * 3600.0f / totalSeconds : 0;
+    BEAM_VERBOSEF(CORE, "Logged %d wake profiles to %s\n", state.pendingProfiles, profileFile.c_str());
+    BEAM_INFOF(CORE, "Energy: %.1f uAh per cycle, %.0f uA average, projected %.0f days on %d mAh\n",
+                     totalUAh / state.pendingProfiles, averageUA,
+                     averageUA > 0 ? config.batteryMAh * config.usableFraction * 1000.0f / averageUA / 24.0f : 0.0f,
+                     _batteryMAh);
+    state.pendingProfiles = 0;
+    return true;
 }
 
 void HublinkBEAM::sleep(uint32_t minutes)
 {
+    BEAMPhaseTimer prepTimer(_profile, BEAM_PHASE_SLEEP_PREP);
+    minutes = scheduleSleep(minutes);
+    uint8_t factor = beamPowerSleepFactor(_powerLadder, getPowerLevel());
+    if (factor > 1)
+    {
+        BEAM_INFOF(CORE, "Power level %d: sleep interval stretched %dx\n", _powerLevel, factor);
+        minutes *= factor;
+    }
     uint32_t seconds = minutes * 60; // Convert minutes to seconds
+    BEAMStateBlock &state = _state.data();
 
     // Record sleep start time for PIR activity calculation
+    state.sleepSeconds = seconds;
+    strlcpy(state.deviceID, _deviceID.c_str(), sizeof(state.deviceID));
+    state.logBatchSize = _logBatchSize;
+    state.logFormat = _logFormat;
+    state.logCompression = _logCompression;
+    state.lightAutoRange = _lightAutoRange;
+    state.sensors = _fastSensors.cache();
     if (_isRTCInitialized)
     {
-        sleep_start_time = getUnixTime();
-        Serial.printf("Recording sleep start time: %d\n", sleep_start_time);
+        state.sleepStartTime = getUnixTime();
+        BEAM_VERBOSEF(CORE, "Recording sleep start time: %lu\n", state.sleepStartTime);
     }
 
-    // Configure ULP inactivity period if set
-    if (_inactivityPeriod > 0)
+    // Configure ULP inactivity periods (0 leaves a slot disabled)
+    for (uint8_t i = 0; i < ULP_INACTIVITY_THRESHOLDS; i++)
     {
-        _ulp.setInactivityPeriod(_inactivityPeriod);
+        _ulp.setInactivityPeriod(_inactivityPeriods[i], i);
     }
 
     // Prepare for sleep
@@ -840,30 +1160,102 @@ void HublinkBEAM::sleep(uint32_t minutes)
         _pirSensor.enableTriggerMode();
     }
 
-    if (_isBatteryMonitorInitialized)
+    if (_fastSensorMask & BEAM_SENSOR_BATTERY)
+    {
+        _fastSensors.sleepBattery(); // Sleep stays enabled from the last full init
+    }
+    else if (_isBatteryMonitorInitialized)
     {
         _batteryMonitor.enableSleep(true); // Enable sleep capability
         _batteryMonitor.sleep(true);       // Enter sleep mode
     }
 
-    Serial.printf("Entering deep sleep for %d minutes (%d seconds)\n", minutes, seconds);
-    Serial.flush();
+    commitSettings(); // The one NVS write of a wake, if any key changed
+
+    BEAM_INFOF(CORE, "Entering deep sleep for %d minutes (%d seconds), %lu I2C transactions this wake\n",
+                     minutes, seconds, _wire.transactions());
+    prepTimer.stop();
+    BEAMPhaseTimer flushTimer(_profile, BEAM_PHASE_SERIAL_FLUSH);
+    Serial.flush(); // Sketch output too, before the UART powers down
+    flushTimer.stop();
+    BEAMPhaseTimer ulpTimer(_profile, BEAM_PHASE_SLEEP_PREP);
     disableNeoPixel();
 
     // Enable timer wakeup
     uint64_t microseconds = (uint64_t)seconds * 1000000ULL;
     esp_sleep_enable_timer_wakeup(microseconds);
     _ulp.begin(); // configure pins
+
+    // Motion events that were not logged (failed or skipped flush) stay in
+    // the ring and keep their window tick; otherwise the tick restarts
+    if (!_motionEventLog || !_ulp.hasEvents())
+    {
+        _ulp.clearEvents();
+        state.eventStartTime = state.sleepStartTime;
+    }
     _ulp.start(); // load/start ULP program
+    ulpTimer.stop();
+
+    if (_wakeProfiling && !isPowerSkipped(BEAM_POWER_SKIP_EXTRAS))
+    {
+        queueWakeProfile();
+    }
+    _state.commit(); // last state change before deep sleep
     esp_deep_sleep_start();
 }
 
+uint32_t HublinkBEAM::scheduleSleep(uint32_t minutes)
+{
+    BEAMStateBlock &state = _state.data();
+    if (_sleepSchedule.maxMinutes == 0)
+    {
+        state.sleepMinutes = 0;
+        state.activityWakes = 0;
+        return minutes;
+    }
+
+    // The history restarts with a reset; the first interval is the shortest
+    uint16_t minMinutes = _sleepSchedule.minMinutes > 0 ? _sleepSchedule.minMinutes : minutes;
+    if (_isWakeFromSleep)
+    {
+        state.activityWakes = beamScheduleRecord(state.activityHistory, state.activityWakes,
+                                                 (uint16_t)(_pir_percent_active * 1000.0 + 0.5));
+    }
+    else
+    {
+        state.activityWakes = 0;
+    }
+    uint16_t next = beamScheduleNext(_sleepSchedule, minMinutes, state.sleepMinutes, state.activityHistory,
+                                     state.activityWakes);
+    if (next != state.sleepMinutes)
+    {
+        BEAM_INFOF(CORE, "Adaptive sleep: %d -> %d minutes (activity %.1f%%)\n", state.sleepMinutes, next,
+                         state.activityWakes ? state.activityHistory[0] / 10.0 : 0.0);
+    }
+    state.sleepMinutes = next;
+    return next;
+}
+
+void HublinkBEAM::commitSettings()
+{
+    _store.commit(_isRTCInitialized ? getUnixTime() / 86400 : 0);
+}
+
+uint16_t HublinkBEAM::getNVSWritesToday()
+{
+    return _store.writesToday(_isRTCInitialized ? getUnixTime() / 86400 : 0);
+}
+
 float HublinkBEAM::getBatteryVoltage()
 {
     if (!_isBatteryMonitorInitialized)
     {
         return -1.0;
     }
+    if (_fastSensorMask & BEAM_SENSOR_BATTERY)
+    {
+        return _fastSensors.batteryVoltage();
+    }
     return _batteryMonitor.cellVoltage();
 }
 
@@ -873,16 +1265,64 @@ float HublinkBEAM::getBatteryPercent()
     {
         return -1.0;
     }
+    if (_fastSensorMask & BEAM_SENSOR_BATTERY)
+    {
+        return _fastSensors.batteryPercent();
+    }
     return _batteryMonitor.cellPercent();
 }
 
+float HublinkBEAM::getBatteryChargeRate()
+{
+    if (!_isBatteryMonitorInitialized)
+    {
+        return NAN;
+    }
+    if (_fastSensorMask & BEAM_SENSOR_BATTERY)
+    {
+        return _fastSensors.batteryChargeRate();
+    }
+    return _batteryMonitor.chargeRate();
+}
+
+uint8_t HublinkBEAM::getPowerLevel()
+{
+    if (!_powerLevelChecked)
+    {
+        updatePowerLevel();
+    }
+    return _powerLevel;
+}
+
+void HublinkBEAM::updatePowerLevel()
+{
+    // Called lazily, so the sketch's setPowerLadder() applies to this wake
+    _powerLevelChecked = true;
+    BEAMStateBlock &state = _state.data();
+    uint8_t previous = state.powerLevel < BEAM_POWER_LEVEL_COUNT ? state.powerLevel : BEAM_POWER_NORMAL;
+    if (!_isBatteryMonitorInitialized)
+    {
+        _powerLevel = previous;
+        return;
+    }
+    float volts = getBatteryVoltage();
+    float percent = getBatteryPercent();
+    float rate = getBatteryChargeRate();
+    _powerLevel = beamPowerLevel(_powerLadder, previous, volts, percent, rate);
+    state.powerLevel = _powerLevel;
+    if (_powerLevel != previous)
+    {
+        BEAM_WARNF(CORE, "Power level %d -> %d (%.2fV, %.1f%%, %+.2f%%/h)\n", previous, _powerLevel, volts, percent, rate);
+    }
+}
+
 bool HublinkBEAM::isBatteryConnected()
 {
     if (!_isBatteryMonitorInitialized)
     {
         return false;
     }
-    float voltage = _batteryMonitor.cellVoltage();
+    float voltage = (_fastSensorMask & BEAM_SENSOR_BATTERY) ? _fastSensors.batteryVoltage() : _batteryMonitor.cellVoltage();
     return !isnan(voltage);
 }
 
@@ -892,6 +1332,10 @@ float HublinkBEAM::getTemperature()
     {
         return -273.15; // Absolute zero as error value
     }
+    if (_fastSensorMask & BEAM_SENSOR_ENV)
+    {
+        return _fastSensors.temperature();
+    }
     return _envSensor.readTemperature();
 }
 
@@ -901,6 +1345,10 @@ float HublinkBEAM::getPressure()
     {
         return -1.0;
     }
+    if (_fastSensorMask & BEAM_SENSOR_ENV)
+    {
+        return _fastSensors.pressure() / 100.0F;
+    }
     return _envSensor.readPressure() / 100.0F; // Convert Pa to hPa
 }
 
@@ -910,6 +1358,10 @@ float HublinkBEAM::getHumidity()
     {
         return -1.0;
     }
+    if (_fastSensorMask & BEAM_SENSOR_ENV)
+    {
+        return _fastSensors.humidity();
+    }
     return _envSensor.readHumidity();
 }
 
@@ -919,6 +1371,11 @@ float HublinkBEAM::getAltitude()
     {
         return -1.0;
     }
+    if (_fastSensorMask & BEAM_SENSOR_ENV)
+    {
+        // Same formula as Adafruit_BME280::readAltitude()
+        return 44330.0 * (1.0 - pow(_fastSensors.pressure() / 100.0F / SEALEVELPRESSURE_HPA, 0.1903));
+    }
     return _envSensor.readAltitude(SEALEVELPRESSURE_HPA);
 }
 
@@ -933,6 +1390,10 @@ float HublinkBEAM::getLux()
     {
         return -1.0;
     }
+    if (_fastSensorMask & BEAM_SENSOR_LIGHT)
+    {
+        return _fastSensors.lux();
+    }
     return _lightSensor.readLux();
 }
 
@@ -942,6 +1403,10 @@ uint16_t HublinkBEAM::getRawALS()
     {
         return 0;
     }
+    if (_fastSensorMask & BEAM_SENSOR_LIGHT)
+    {
+        return _fastSensors.readALS();
+    }
     return _lightSensor.readALS();
 }
 
@@ -951,6 +1416,10 @@ uint16_t HublinkBEAM::getRawWhite()
     {
         return 0;
     }
+    if (_fastSensorMask & BEAM_SENSOR_LIGHT)
+    {
+        return _fastSensors.readWhite();
+    }
     return _lightSensor.readWhite();
 }
 
@@ -961,17 +1430,35 @@ bool HublinkBEAM::isLightSensorConnected()
 
 void HublinkBEAM::setLightGain(uint8_t gain)
 {
-    if (_isLightSensorInitialized)
+    if (_lightAutoRange)
+    {
+        return; // logData() picks the range
+    }
+    if (_fastSensorMask & BEAM_SENSOR_LIGHT)
+    {
+        _fastSensors.setLightConfig(BEAM_VEML7700_GAIN_MASK, gain << BEAM_VEML7700_GAIN_SHIFT); // Writes only a change
+    }
+    else if (_isLightSensorInitialized)
     {
         _lightSensor.setGain(gain);
+        _fastSensors.captureLight();
     }
 }
 
 void HublinkBEAM::setLightIntegrationTime(uint8_t time)
 {
-    if (_isLightSensorInitialized)
+    if (_lightAutoRange)
+    {
+        return; // logData() picks the range
+    }
+    if (_fastSensorMask & BEAM_SENSOR_LIGHT)
+    {
+        _fastSensors.setLightConfig(BEAM_VEML7700_IT_MASK, time << BEAM_VEML7700_IT_SHIFT);
+    }
+    else if (_isLightSensorInitialized)
     {
         _lightSensor.setIntegrationTime(time);
+        _fastSensors.captureLight();
     }
 }
 
@@ -1036,77 +1523,94 @@ bool HublinkBEAM::alarm(uint16_t minutes)
 {
     if (!_isRTCInitialized)
     {
-        Serial.println("alarm: RTC not initialized");
+        BEAM_ERRORF(CORE, "alarm: RTC not initialized\n");
         return false;
     }
 
     uint32_t current_time = getUnixTime();
+    BEAMStateBlock &state = _state.data();
 
     // If minutes > 0, we're potentially setting up the alarm
     if (minutes > 0)
     {
         // Only update interval and start time if this is first setup
-        if (alarm_start_time == 0)
+        if (state.alarmStartTime == 0)
         {
-            alarm_interval = minutes;
-            alarm_start_time = current_time;
-            Serial.printf("alarm: First setup - interval %d minutes, start time %d\n",
-                          minutes, current_time);
+            state.alarmInterval = minutes;
+            state.alarmStartTime = current_time;
+            BEAM_INFOF(CORE, "alarm: First setup - interval %d minutes, start time %d\n",
+                             minutes, current_time);
             return false;
         }
         // Otherwise just update the interval if it changed
-        else if (alarm_interval != minutes)
+        else if (state.alarmInterval != minutes)
         {
-            alarm_interval = minutes;
-            Serial.printf("alarm: Updated interval to %d minutes\n", minutes);
+            state.alarmInterval = minutes;
+            BEAM_INFOF(CORE, "alarm: Updated interval to %d minutes\n", minutes);
         }
     }
 
     // If no interval is set, we can't check the alarm
-    if (alarm_interval == 0)
+    if (state.alarmInterval == 0)
     {
-        Serial.println("alarm: No interval set");
+        BEAM_INFOF(CORE, "alarm: No interval set\n");
+        return false;
+    }
+
+    if (isPowerSkipped(BEAM_POWER_SKIP_SYNC))
+    {
+        BEAM_INFOF(CORE, "alarm: sync suspended at power level %d\n", _powerLevel);
         return false;
     }
 
     // Check if enough time has elapsed since the last alarm
-    uint32_t interval_seconds = (uint32_t)alarm_interval * 60;
-    uint32_t next_alarm = alarm_start_time + interval_seconds;
+    uint32_t interval_seconds = (uint32_t)state.alarmInterval * 60;
+    uint32_t next_alarm = state.alarmStartTime + interval_seconds;
 
-    Serial.println("\nChecking alarm condition:");
-    Serial.printf("  Current time: %d\n", current_time);
-    Serial.printf("  Next alarm: %d\n", next_alarm);
-    Serial.printf("  Time to alarm: %d seconds\n",
-                  (current_time < next_alarm) ? (next_alarm - current_time) : 0);
+    BEAM_VERBOSEF(CORE, "\nChecking alarm condition:\n");
+    BEAM_VERBOSEF(CORE, "  Current time: %d\n", current_time);
+    BEAM_VERBOSEF(CORE, "  Next alarm: %d\n", next_alarm);
+    BEAM_VERBOSEF(CORE, "  Time to alarm: %d seconds\n",
+                        (current_time < next_alarm) ? (next_alarm - current_time) : 0);
 
     if (current_time >= next_alarm)
     {
         // Update start time to the next interval
-        alarm_start_time = next_alarm;
-        Serial.println("  → Alarm triggered!");
+        state.alarmStartTime = next_alarm;
+        BEAM_VERBOSEF(CORE, "  → Alarm triggered!\n");
         // If next_alarm is not in the future the RTC must have been adjusted
-        // so we need to reset the alarm_start_time and next_alarm
+        // so we need to reset the alarm start time and next_alarm
         if (next_alarm <= current_time)
         {
-            Serial.println("  Time adjustment detected, resetting alarm");
-            alarm_start_time = current_time;
-            next_alarm = alarm_start_time + interval_seconds;
+            BEAM_VERBOSEF(CORE, "  Time adjustment detected, resetting alarm\n");
+            state.alarmStartTime = current_time;
+            next_alarm = state.alarmStartTime + interval_seconds;
         }
         return true;
     }
 
-    Serial.println("  → Not triggered");
+    BEAM_VERBOSEF(CORE, "  → Not triggered\n");
     return false;
 }
 
+bool HublinkBEAM::isAlarmDue()
+{
+    BEAMStateBlock &state = _state.data();
+    if (!_isRTCInitialized || state.alarmInterval == 0 || isPowerSkipped(BEAM_POWER_SKIP_SYNC))
+    {
+        return false;
+    }
+    return getUnixTime() >= state.alarmStartTime + (uint32_t)state.alarmInterval * 60;
+}
+
 uint32_t HublinkBEAM::hashMacAddress()
 {
     uint8_t mac[6];
     esp_read_mac(mac, ESP_MAC_BT); // Get Bluetooth MAC address
 
     // Print MAC address for debugging
-    Serial.printf("Device MAC: %02X:%02X:%02X:%02X:%02X:%02X\n",
-                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    BEAM_VERBOSEF(CORE, "Device MAC: %02X:%02X:%02X:%02X:%02X:%02X\n",
+                        mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
 
     // Simple hash combining all 6 bytes
     uint32_t hash = 0;
@@ -11,9 +11,19 @@
 #include "Adafruit_VEML7700.h"
 #include "RTCManager.h"
 #include "ULPManager.h"
+#include "BEAMState.h"
+#include "LogFormat.h"
+#include "BEAMSDStorage.h"
+#include "BEAMLogWriter.h"
+#include "BEAMProfile.h"
+#include "BEAMEnergy.h"
+#include "BEAMWire.h"
+#include "BEAMFastSensors.h"
+#include "BEAMPower.h"
+#include "BEAMSchedule.h"
+#include "BEAMSettingsStore.h"
 #include <Adafruit_NeoPixel.h>
 #include "esp_sleep.h"
-#include <Preferences.h>
 #include "SharedDefs.h"
 #include <RTClib.h>
 
@@ -30,6 +40,7 @@ class DateTime;
 #define PIN_SWITCH_A 6   // Switch A
 #define PIN_SWITCH_B 5   // Switch B
 #define PIN_SD_PWR_EN 10 // SD card VDD LDO enable
+#define SD_MOUNT_POINT "/sd" // VFS path of the SD card
 #define TP_1 8
 #define TP_2 15
 
@@ -47,12 +58,15 @@ class DateTime;
 
 // Rules
 #define LOW_BATTERY_THRESHOLD 3.7
+#define LIGHT_SLEEP_MIN_MS 5 // Shorter sensor waits use delay(); light sleep entry and exit cost ~1 ms
 
 // Library Version
 #define HUBLINK_BEAM_VERSION "2.1.0"
 
-// CSV Header
-#define CSV_HEADER "datetime,millis,device_id,library_version,battery_voltage,temperature_c,pressure_hpa,humidity_percent,lux,activity_count,activity_percent,inactivity_period_s,inactivity_count,inactivity_percent,min_free_heap,reboot"
+// CSV Header: CSV_HEADER lives in LogFormat.h
+static_assert(ULP_INACTIVITY_THRESHOLDS == LOG_INACTIVITY_THRESHOLDS && LOG_INACTIVITY_THRESHOLDS == 3,
+              "CSV_HEADER and LogRecord list exactly three inactivity thresholds");
+#define EVENTS_CSV_HEADER "datetime,window,event"
 
 class HublinkBEAM
 {
@@ -61,6 +75,7 @@ public:
     bool begin();
     bool initSD();
     bool logData();
+    bool flushLog(); // Write batched records to the SD card now (e.g. before hublink.sync())
     void sleep(uint32_t minutes);
 
     // File creation behavior
@@ -71,9 +86,94 @@ public:
     void setDeviceID(String deviceID);
     String getDeviceID() { return _deviceID; }
 
-    // Inactivity period control
-    void setInactivityPeriod(uint16_t seconds) { _inactivityPeriod = seconds; }
-    uint16_t getInactivityPeriod() { return _inactivityPeriod; }
+    // Inactivity period control (index 0 is the primary threshold, 1..N-1 are extra CSV columns)
+    void setInactivityPeriod(uint16_t seconds, uint8_t index = 0)
+    {
+        if (index < ULP_INACTIVITY_THRESHOLDS)
+            _inactivityPeriods[index] = seconds;
+    }
+    uint16_t getInactivityPeriod(uint8_t index = 0) { return index < ULP_INACTIVITY_THRESHOLDS ? _inactivityPeriods[index] : 0; }
+
+    // ULP sampling mode: ULP_MODE_CONTINUOUS (default) or ULP_MODE_TIMER at sampleHz
+    void setULPSamplingMode(ULPSamplingMode mode, uint16_t sampleHz = ULP_DEFAULT_SAMPLE_HZ) { _ulp.setSamplingMode(mode, sampleHz); }
+    ULPSamplingMode getULPSamplingMode() { return _ulp.getSamplingMode(); }
+
+    // Log batching: keep up to `records` rows in RTC memory and power the SD
+    // card once per batch (1 = write every wake). A batch is also flushed on
+    // boot, low battery, a due sync alarm, or when the motion event log is on.
+    void setLogBatchSize(uint8_t records);
+    uint8_t getLogBatchSize() { return _logBatchSize; }
+    bool isLogFlushDue(); // True if the next logData() will mount the SD card
+
+    // Data file format: LOG_FORMAT_CSV (.csv, default) or LOG_FORMAT_BINARY
+    // (.bin, decode with extras/log_decoder). Applies to the next new file.
+    void setLogFormat(BEAMLogFormat format) { _logFormat = format; }
+    BEAMLogFormat getLogFormat() { return _logFormat; }
+
+    // Compress the previous day's files to <name>.lz when the date rolls over
+    // (decompress with extras/log_compress). The original is removed once
+    // the compressed copy has been read back and matches its CRC.
+    void setLogCompression(bool value) { _logCompression = value; }
+    bool getLogCompression() { return _logCompression; }
+
+    // Storage backend for log files (default: the SD card). Other backends
+    // skip the SD power and card checks; stats() counts I/O since boot.
+    void setStorage(BEAMStorage *storage) { _logWriter.setStorage(storage ? storage : &_sdStorage); }
+    BEAMStorage &getStorage() { return *_logWriter.getStorage(); }
+
+    // Motion event log: writes ULP onset/offset events to <logfile>_events.csv
+    void setMotionEventLog(bool value) { _motionEventLog = value; }
+    bool getMotionEventLog() { return _motionEventLog; }
+
+    // Wake profiling: queue the time spent in each phase of every wake (see
+    // BEAMProfile.h) and append the queued rows to <logfile>_profile.csv on
+    // each flush. Up to BEAM_PROFILE_CAPACITY wakes are kept between flushes.
+    void setWakeProfiling(bool value) { _wakeProfiling = value; }
+    bool getWakeProfiling() { return _wakeProfiling; }
+    const BEAMWakeProfile &getWakeProfile() { return _profile; } // This wake so far
+
+    // Energy model (BEAMEnergy.h): per-phase currents and battery capacity
+    // behind the charge_uah and projected_days profile columns. The default
+    // sleep currents are from ULP-Power.xlsx; awake currents are typical.
+    void setEnergyCurrents(const BEAMEnergyCurrents &currents) { _energyCurrents = currents; }
+    const BEAMEnergyCurrents &getEnergyCurrents() { return _energyCurrents; }
+    void setBatteryCapacity(uint16_t mAh) { _batteryMAh = mAh; }
+    uint16_t getBatteryCapacity() { return _batteryMAh; }
+    // Projection if every cycle were this wake followed by sleep(sleepMinutes),
+    // with a sync of syncSeconds every syncEveryMinutes (0 = none). SD phases
+    // count once per log batch, so call it after a logData() that flushed.
+    BEAMEnergyEstimate estimateEnergy(uint32_t sleepMinutes, uint32_t syncEveryMinutes = 0, uint32_t syncSeconds = 0);
+
+    // Fast wake (default on): on a timer wake, check a register or two of
+    // each sensor against the configuration cached by the last full init and
+    // read them directly instead of running each driver's begin(). A sensor
+    // whose registers differ is fully reinitialized. Call before begin().
+    void setFastWake(bool value) { _fastWake = value; }
+    bool getFastWake() { return _fastWake; }
+    uint8_t getFastSensors() { return _fastSensorMask; } // BEAM_SENSOR_* bits resumed this wake
+    uint32_t getI2CTransactions() { return _wire.transactions(); } // This wake so far
+
+    // Persistent settings (BEAMSettingsStore.h): NVS is read once per cold
+    // boot and written in one commit at sleep(), only for changed keys
+    uint16_t getNVSWritesToday(); // NVS entries written today, across cold boots
+    uint32_t getNVSWrites() { return _store.writes(); } // Since the last cold boot
+
+    // Battery degradation ladder (BEAMPower.h): each wake picks a level from
+    // the battery voltage, state of charge and charge rate. Lower levels
+    // stretch sleep(), skip the light and environmental reads, stop the
+    // alarm() sync and finally log only the ULP counters. The level is in
+    // each row (power_level) and transitions are reported on Serial.
+    // beamNoPowerLadder() turns it off.
+    void setPowerLadder(const BEAMPowerLadder &ladder) { _powerLadder = ladder; }
+    const BEAMPowerLadder &getPowerLadder() { return _powerLadder; }
+    uint8_t getPowerLevel(); // BEAMPowerLevel of this wake
+
+    // Activity-adaptive sleep interval (BEAMSchedule.h): with a schedule
+    // from beamAdaptiveSleepSchedule(min, max), sleep() picks its interval
+    // from the PIR activity of the last wakes instead of its argument. Each
+    // row records the interval it covers (sleep_interval_s).
+    void setSleepSchedule(const BEAMSleepSchedule &schedule) { _sleepSchedule = schedule; }
+    const BEAMSleepSchedule &getSleepSchedule() { return _sleepSchedule; }
 
     // Alarm randomization control
     void setAlarmRandomization(uint16_t minutes) { _alarmRandomizationMinutes = minutes; }
@@ -86,6 +186,7 @@ public:
     // Battery monitoring functions
     float getBatteryVoltage();
     float getBatteryPercent();
+    float getBatteryChargeRate(); // %/hour, negative while discharging (NAN if unavailable)
     bool isBatteryConnected();
 
     // Environmental monitoring functions
@@ -104,6 +205,12 @@ public:
     // Light sensor configuration
     void setLightGain(uint8_t gain);            // Set ALS gain (VEML7700_GAIN_*)
     void setLightIntegrationTime(uint8_t time); // Set integration time (VEML7700_IT_*)
+    // Auto-range: each logData() keeps the last wake's gain and integration
+    // time unless the reading saturates or falls below the noise floor, then
+    // moves along BEAM_VEML7700_RANGES and reads again. The fixed settings
+    // above are ignored while it is on. The range used is in each row.
+    void setLightAutoRange(bool value) { _lightAutoRange = value; }
+    bool getLightAutoRange() { return _lightAutoRange; }
 
     // RTC functions
     DateTime getDateTime();
@@ -124,8 +231,18 @@ public:
 private:
     void initPins();
     bool initSensors(bool isWakeFromSleep);
-    String getCurrentFilename();      // Gets filename in YYYYMMDD.csv format
-    bool createFile(String filename); // Creates new file with header
+    void acquireSensors(LogRecord &record); // Battery, environment and light, conversions overlapped
+    void waitUntil(uint32_t dueMillis);     // Light sleep unless USB is connected
+    void queueLogRecord(const LogRecord &record);                  // Appends to the RTC batch
+    BEAMLogSettings logSettings();                                  // Current settings for _logWriter
+    bool isAlarmDue();                                              // Sync alarm would trigger now
+    void updatePowerLevel();                                        // Steps the ladder once per wake
+    void commitSettings();                                          // Writes changed store keys to NVS
+    uint32_t scheduleSleep(uint32_t minutes);                       // Adaptive interval for sleep()
+    bool isPowerSkipped(uint8_t skip) { return beamPowerSkips(_powerLadder, getPowerLevel()) & skip; }
+    bool logMotionEvents(String dataFilename); // Drains ULP motion events to the events file
+    void queueWakeProfile();                   // Completes this wake's profile in the RTC state block
+    bool logWakeProfiles(String dataFilename); // Drains queued wake profiles to the profile file
     bool isSDCardPresent();           // Checks if SD card is inserted
     void enableSDPower();
     void disableSDPower();
@@ -133,16 +250,32 @@ private:
     bool _isLowBattery;
     bool _isWakeFromSleep;                   // Track wake state
     bool _newFileOnBoot = true;              // Controls whether to create new file on each boot
+    bool _motionEventLog = false;            // Controls whether ULP motion events are logged
+    bool _wakeProfiling = false;             // Controls whether wake profiles are logged
+    bool _fastWake = true;                   // Controls whether timer wakes skip sensor begin()
+    bool _lightAutoRange = false;            // Controls whether logData() picks the VEML7700 range
+    BEAMPowerLadder _powerLadder = beamDefaultPowerLadder();
+    uint8_t _powerLevel = BEAM_POWER_NORMAL; // BEAMPowerLevel of this wake
+    bool _powerLevelChecked = false;         // updatePowerLevel() ran this wake
+    BEAMSleepSchedule _sleepSchedule = beamFixedSleepSchedule();
+    BEAMWakeProfile _profile = {};           // Phase times of this wake
+    BEAMEnergyCurrents _energyCurrents = beamDefaultCurrents();
+    uint16_t _batteryMAh = BEAM_ENERGY_BATTERY_MAH; // Battery capacity for projections
+    uint8_t _logBatchSize = 1;               // Log records per SD flush
+    BEAMLogFormat _logFormat = LOG_FORMAT_CSV; // Data file format
+    bool _logCompression = false;            // Compress closed daily files
     String _deviceID = "XXX";                // Device ID for filename (3 characters)
     double _pir_percent_active;              // Track PIR activity as fraction of sleep time
     double _inactivity_fraction;             // Track inactivity as fraction of possible periods
-    uint16_t _inactivityPeriod = 0;          // Inactivity period in seconds (0 = disabled)
+    uint16_t _inactivityPeriods[ULP_INACTIVITY_THRESHOLDS] = {0}; // Inactivity periods in seconds (0 = disabled)
     uint16_t _alarmRandomizationMinutes = 0; // Alarm randomization in minutes (0 = disabled)
     uint32_t _minFreeHeap;                   // Track minimum free heap
     uint32_t _elapsed_seconds;               // Store elapsed time for inactivity calculations
     double _active_seconds;                  // Store active time for inactivity calculations
-    File _dataFile;
     bool _isSDInitialized;
+    BEAMWire _wire; // I2C bus 0 with a transaction count
+    BEAMFastSensors _fastSensors;
+    uint8_t _fastSensorMask = 0; // BEAM_SENSOR_* bits read through _fastSensors this wake
     ZDP323 _pirSensor;
     bool _isPIRInitialized;
     Adafruit_MAX17048 _batteryMonitor;
@@ -152,10 +285,13 @@ private:
     Adafruit_VEML7700 _lightSensor;
     bool _isLightSensorInitialized;
     RTCManager _rtc;
+    BEAMSettingsStore _store;
     bool _isRTCInitialized;
     Adafruit_NeoPixel _pixel;
     ULPManager _ulp;
-    Preferences _preferences;
+    BEAMState _state; // CRC-protected cross-wake state in RTC memory
+    BEAMSDStorage _sdStorage;
+    BEAMLogWriter _logWriter; // Daily files on _sdStorage or setStorage()
 };
 
 #endif
\ No newline at end of file
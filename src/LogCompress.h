@@ -0,0 +1,318 @@
+#ifndef LOG_COMPRESS_H
+#define LOG_COMPRESS_H
+
+// LZSS compression for closed daily log files. Host-includable (no Arduino
+// dependencies) so extras/log_compress decompresses exactly what the device
+// wrote. RAM: about 7 KB to compress, 2.5 KB to decompress.
+//
+// Stream layout: BEAMLZFileHeader, then groups of one flag byte and up to
+// eight items. Flag bit i (LSB first) marks item i as a match: two bytes,
+// big endian, holding 11 bits of distance-1 and 5 bits of length-3;
+// otherwise the item is one literal byte. A match with length code
+// BEAM_LZ_END_CODE ends the stream and is followed by the original size and
+// its CRC-32 (uint32 each, little endian).
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "LogFormat.h"
+
+#define BEAM_LZ_MAGIC "BLZ"
+#define BEAM_LZ_VERSION 1
+#define BEAM_LZ_EXTENSION ".lz"         // Appended to the compressed file's name
+#define BEAM_LZ_WINDOW_BITS 11
+#define BEAM_LZ_WINDOW (1 << BEAM_LZ_WINDOW_BITS) // 2 KB of history
+#define BEAM_LZ_MIN_MATCH 3
+#define BEAM_LZ_END_CODE 31                       // Length code reserved for end of stream
+#define BEAM_LZ_MAX_MATCH (BEAM_LZ_MIN_MATCH + BEAM_LZ_END_CODE - 1)
+#define BEAM_LZ_HASH_BITS 10
+#define BEAM_LZ_INPUT 1024 // Bytes read per refill
+
+struct __attribute__((packed)) BEAMLZFileHeader
+{
+    char magic[3];      // BEAM_LZ_MAGIC, not null terminated
+    uint8_t version;    // BEAM_LZ_VERSION
+    uint8_t windowBits; // BEAM_LZ_WINDOW_BITS
+    uint8_t minMatch;   // BEAM_LZ_MIN_MATCH
+    uint16_t reserved;
+};
+
+// Stream callbacks: read returns 0 at end of input, write returns false on error
+typedef size_t (*BEAMLZRead)(void *context, uint8_t *data, size_t length);
+typedef bool (*BEAMLZWrite)(void *context, const uint8_t *data, size_t length);
+
+struct BEAMLZEncoder
+{
+    uint8_t window[BEAM_LZ_WINDOW + BEAM_LZ_INPUT]; // history + lookahead
+    uint32_t head[1 << BEAM_LZ_HASH_BITS];          // Last position + 1 per 3-byte hash
+    uint8_t group[1 + 8 * 2];                       // Flag byte + up to eight items
+};
+
+struct BEAMLZDecoder
+{
+    uint8_t window[BEAM_LZ_WINDOW]; // Ring of the last output bytes
+    uint8_t input[256];
+    uint8_t output[256];
+};
+
+inline uint32_t beamLZHash(const uint8_t *p)
+{
+    uint32_t key = (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2];
+    return (key * 2654435761u) >> (32 - BEAM_LZ_HASH_BITS);
+}
+
+inline void beamLZPutLE32(uint8_t *p, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+// Compresses everything `read` returns. Sizes are optional outputs.
+inline bool beamLZCompress(BEAMLZEncoder &e, BEAMLZRead read, void *in, BEAMLZWrite write, void *out,
+                           uint32_t *originalSize = NULL, uint32_t *compressedSize = NULL)
+{
+    BEAMLZFileHeader header;
+    memcpy(header.magic, BEAM_LZ_MAGIC, sizeof(header.magic));
+    header.version = BEAM_LZ_VERSION;
+    header.windowBits = BEAM_LZ_WINDOW_BITS;
+    header.minMatch = BEAM_LZ_MIN_MATCH;
+    header.reserved = 0;
+    if (!write(out, (const uint8_t *)&header, sizeof(header)))
+    {
+        return false;
+    }
+
+    memset(e.head, 0, sizeof(e.head));
+    uint32_t written = sizeof(header);
+    uint32_t size = 0;
+    uint32_t crc = 0;
+    uint32_t base = 0; // Stream offset of window[0]
+    size_t filled = 0;
+    size_t pos = 0;
+    bool eof = false;
+    size_t groupLength = 1;
+    uint8_t items = 0;
+    e.group[0] = 0;
+
+    while (true)
+    {
+        // Keep a full match of lookahead, sliding the window back when needed
+        if (!eof && filled - pos < BEAM_LZ_MAX_MATCH)
+        {
+            if (pos > BEAM_LZ_WINDOW)
+            {
+                size_t shift = pos - BEAM_LZ_WINDOW;
+                memmove(e.window, e.window + shift, filled - shift);
+                base += shift;
+                pos -= shift;
+                filled -= shift;
+            }
+            size_t n = read(in, e.window + filled, sizeof(e.window) - filled);
+            eof = (n == 0);
+            crc = beamCRC32(e.window + filled, n, crc);
+            size += n;
+            filled += n;
+            continue;
+        }
+        if (pos >= filled)
+        {
+            break;
+        }
+
+        // One candidate per hash bucket: fast, and good enough for log rows
+        size_t available = filled - pos;
+        size_t matchLength = 0;
+        uint32_t distance = 0;
+        if (available >= BEAM_LZ_MIN_MATCH)
+        {
+            uint32_t h = beamLZHash(e.window + pos);
+            uint32_t candidate = e.head[h];
+            e.head[h] = base + pos + 1;
+            distance = base + pos + 1 - candidate;
+            if (candidate != 0 && distance <= BEAM_LZ_WINDOW)
+            {
+                const uint8_t *a = e.window + pos;
+                const uint8_t *b = a - distance; // may overlap a, as in the decoder
+                size_t limit = available < BEAM_LZ_MAX_MATCH ? available : BEAM_LZ_MAX_MATCH;
+                while (matchLength < limit && a[matchLength] == b[matchLength])
+                {
+                    matchLength++;
+                }
+            }
+        }
+
+        if (matchLength >= BEAM_LZ_MIN_MATCH)
+        {
+            uint16_t code = (uint16_t)((distance - 1) << 5 | (matchLength - BEAM_LZ_MIN_MATCH));
+            e.group[0] |= 1 << items;
+            e.group[groupLength++] = code >> 8;
+            e.group[groupLength++] = code & 0xFF;
+            for (size_t k = 1; k < matchLength && pos + k + BEAM_LZ_MIN_MATCH <= filled; k++)
+            {
+                e.head[beamLZHash(e.window + pos + k)] = base + pos + k + 1;
+            }
+            pos += matchLength;
+        }
+        else
+        {
+            e.group[groupLength++] = e.window[pos++];
+        }
+
+        if (++items == 8)
+        {
+            if (!write(out, e.group, groupLength))
+            {
+                return false;
+            }
+            written += groupLength;
+            groupLength = 1;
+            items = 0;
+            e.group[0] = 0;
+        }
+    }
+
+    // End marker, then the trailer the decoder checks its output against
+    e.group[0] |= 1 << items;
+    e.group[groupLength++] = 0;
+    e.group[groupLength++] = BEAM_LZ_END_CODE;
+    uint8_t trailer[8];
+    beamLZPutLE32(trailer, size);
+    beamLZPutLE32(trailer + 4, crc);
+    if (!write(out, e.group, groupLength) || !write(out, trailer, sizeof(trailer)))
+    {
+        return false;
+    }
+    written += groupLength + sizeof(trailer);
+
+    if (originalSize)
+    {
+        *originalSize = size;
+    }
+    if (compressedSize)
+    {
+        *compressedSize = written;
+    }
+    return true;
+}
+
+// Buffered byte reader for the decoder; false at end of input
+inline bool beamLZNextByte(BEAMLZDecoder &d, BEAMLZRead read, void *in, size_t &index, size_t &length, uint8_t &byte)
+{
+    if (index == length)
+    {
+        length = read(in, d.input, sizeof(d.input));
+        index = 0;
+        if (length == 0)
+        {
+            return false;
+        }
+    }
+    byte = d.input[index++];
+    return true;
+}
+
+// Decompresses a stream and checks it against the trailer's size and CRC.
+// `write` may be NULL to only verify a file.
+inline bool beamLZDecompress(BEAMLZDecoder &d, BEAMLZRead read, void *in, BEAMLZWrite write, void *out,
+                             uint32_t *originalSize = NULL)
+{
+    BEAMLZFileHeader header;
+    if (read(in, (uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, BEAM_LZ_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != BEAM_LZ_VERSION ||
+        header.windowBits != BEAM_LZ_WINDOW_BITS ||
+        header.minMatch != BEAM_LZ_MIN_MATCH)
+    {
+        return false;
+    }
+
+    size_t index = 0;
+    size_t length = 0;
+    size_t outputLength = 0;
+    uint32_t size = 0;
+    uint32_t crc = 0;
+
+    while (true)
+    {
+        uint8_t flags;
+        if (!beamLZNextByte(d, read, in, index, length, flags))
+        {
+            return false; // truncated
+        }
+        for (uint8_t item = 0; item < 8; item++)
+        {
+            uint8_t first;
+            if (!beamLZNextByte(d, read, in, index, length, first))
+            {
+                return false;
+            }
+
+            uint32_t distance = 0;
+            uint32_t count = 1;
+            if (flags & (1 << item))
+            {
+                uint8_t second;
+                if (!beamLZNextByte(d, read, in, index, length, second))
+                {
+                    return false;
+                }
+                uint16_t code = (uint16_t)(first << 8 | second);
+                if ((code & 0x1F) == BEAM_LZ_END_CODE)
+                {
+                    // Trailer: original size and CRC
+                    uint8_t trailer[8];
+                    for (size_t i = 0; i < sizeof(trailer); i++)
+                    {
+                        if (!beamLZNextByte(d, read, in, index, length, trailer[i]))
+                        {
+                            return false;
+                        }
+                    }
+                    crc = beamCRC32(d.output, outputLength, crc);
+                    if (write && outputLength > 0 && !write(out, d.output, outputLength))
+                    {
+                        return false;
+                    }
+                    uint32_t expectedSize = 0;
+                    uint32_t expectedCRC = 0;
+                    for (int i = 3; i >= 0; i--)
+                    {
+                        expectedSize = expectedSize << 8 | trailer[i];
+                        expectedCRC = expectedCRC << 8 | trailer[4 + i];
+                    }
+                    if (originalSize)
+                    {
+                        *originalSize = size;
+                    }
+                    return size == expectedSize && crc == expectedCRC;
+                }
+                distance = (code >> 5) + 1;
+                count = (code & 0x1F) + BEAM_LZ_MIN_MATCH;
+                if (distance > size)
+                {
+                    return false; // reaches before the start of the file
+                }
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint8_t byte = distance ? d.window[(size - distance) & (BEAM_LZ_WINDOW - 1)] : first;
+                d.window[size & (BEAM_LZ_WINDOW - 1)] = byte;
+                size++;
+                d.output[outputLength++] = byte;
+                if (outputLength == sizeof(d.output))
+                {
+                    crc = beamCRC32(d.output, outputLength, crc);
+                    if (write && !write(out, d.output, outputLength))
+                    {
+                        return false;
+                    }
+                    outputLength = 0;
+                }
+            }
+        }
+    }
+}
+
+#endif
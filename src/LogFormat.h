@@ -0,0 +1,904 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+// Data file formats. Host-includable (no Arduino dependencies) so the
+// decoder in extras/log_decoder produces exactly the rows the device writes.
+//
+// CSV files hold CSV_HEADER and one text row per record, with the sensor
+// readings printed as "%.<decimals>f" of the measured values. Binary files
+// hold a BEAMLogFileHeader followed by fixed-size records of the readings
+// scaled to integers, rounded as printf rounds them (beamFixed()), so a
+// decoded binary file is identical to the CSV the device would write except
+// for NaN readings and negative readings that round to zero ("-0.00").
+//
+// Every record carries a sequence number and a CRC-32 (zlib polynomial), so
+// a torn write at the end of a file is detectable without parsing it all.
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <utility>
+#include "LogRecord.h"
+#include "BEAMSensorCache.h"
+
+enum BEAMLogFormat
+{
+    LOG_FORMAT_CSV,
+    LOG_FORMAT_BINARY
+};
+
+// Column schema. Every column of a data file is described once here; the
+// CSV header, the CSV row formatter, the binary record layout, its encoder
+// and the serial dump are all generated from BEAM_LOG_SCHEMA.
+enum BEAMLogColumnID
+{
+    BEAM_COL_DATETIME,
+    BEAM_COL_MILLIS,
+    BEAM_COL_DEVICE_ID,
+    BEAM_COL_LIBRARY_VERSION,
+    BEAM_COL_BATTERY_VOLTAGE,
+    BEAM_COL_TEMPERATURE,
+    BEAM_COL_PRESSURE,
+    BEAM_COL_HUMIDITY,
+    BEAM_COL_LUX,
+    BEAM_COL_ACTIVITY_COUNT,
+    BEAM_COL_ACTIVITY_PERCENT,
+    BEAM_COL_INACTIVITY_PERIOD,
+    BEAM_COL_INACTIVITY_COUNT,
+    BEAM_COL_INACTIVITY_PERCENT,
+    BEAM_COL_MIN_FREE_HEAP,
+    BEAM_COL_REBOOT,
+    BEAM_COL_INACTIVITY_PERIOD_2,
+    BEAM_COL_INACTIVITY_COUNT_2,
+    BEAM_COL_INACTIVITY_PERIOD_3,
+    BEAM_COL_INACTIVITY_COUNT_3,
+    BEAM_COL_LONGEST_INACTIVE,
+    BEAM_COL_INACTIVE_BOUTS,
+    BEAM_COL_LUX_GAIN,
+    BEAM_COL_LUX_INTEGRATION,
+    BEAM_COL_POWER_LEVEL,
+    BEAM_COL_SLEEP_INTERVAL,
+    BEAM_COL_RECORD_SEQ,
+    BEAM_COL_CRC,
+    BEAM_LOG_COLUMN_COUNT
+};
+
+enum BEAMLogColumnType : uint8_t
+{
+    BEAM_COL_TYPE_DATETIME, // Unix seconds, written YYYY-MM-DD hh:mm:ss
+    BEAM_COL_TYPE_UNSIGNED, // Unsigned integer, value x 10^decimals
+    BEAM_COL_TYPE_SIGNED,   // Signed integer, value x 10^decimals
+    BEAM_COL_TYPE_TEXT,     // Same for the whole file; kept in the binary file header
+    BEAM_COL_TYPE_CRC       // CRC-32 of everything before it in the row or record
+};
+
+struct BEAMLogColumn
+{
+    const char *name;       // CSV header name
+    BEAMLogColumnType type;
+    uint8_t size;           // Bytes in a binary record; longest value for TEXT
+    uint8_t decimals;       // Digits after the decimal point
+};
+
+constexpr BEAMLogColumn BEAM_LOG_SCHEMA[BEAM_LOG_COLUMN_COUNT] = {
+    {"datetime", BEAM_COL_TYPE_DATETIME, 4, 0},
+    {"millis", BEAM_COL_TYPE_UNSIGNED, 4, 0},
+    {"device_id", BEAM_COL_TYPE_TEXT, 3, 0},
+    {"library_version", BEAM_COL_TYPE_TEXT, 11, 0},
+    {"battery_voltage", BEAM_COL_TYPE_SIGNED, 2, 3},  // -1 = failed
+    {"temperature_c", BEAM_COL_TYPE_SIGNED, 2, 2},    // -273.15 = failed
+    {"pressure_hpa", BEAM_COL_TYPE_SIGNED, 4, 2},     // -1 = failed
+    {"humidity_percent", BEAM_COL_TYPE_SIGNED, 2, 2}, // -1 = failed
+    {"lux", BEAM_COL_TYPE_SIGNED, 4, 4},              // -1 = failed
+    {"activity_count", BEAM_COL_TYPE_UNSIGNED, 2, 0},
+    {"activity_percent", BEAM_COL_TYPE_UNSIGNED, 2, 3},
+    {"inactivity_period_s", BEAM_COL_TYPE_UNSIGNED, 2, 0},
+    {"inactivity_count", BEAM_COL_TYPE_UNSIGNED, 2, 0},
+    {"inactivity_percent", BEAM_COL_TYPE_UNSIGNED, 2, 3},
+    {"min_free_heap", BEAM_COL_TYPE_UNSIGNED, 4, 0},
+    {"reboot", BEAM_COL_TYPE_UNSIGNED, 1, 0},
+    {"inactivity_period_2_s", BEAM_COL_TYPE_UNSIGNED, 2, 0},
+    {"inactivity_count_2", BEAM_COL_TYPE_UNSIGNED, 2, 0},
+    {"inactivity_period_3_s", BEAM_COL_TYPE_UNSIGNED, 2, 0},
+    {"inactivity_count_3", BEAM_COL_TYPE_UNSIGNED, 2, 0},
+    {"longest_inactive_s", BEAM_COL_TYPE_UNSIGNED, 2, 0},
+    {"inactive_bouts", BEAM_COL_TYPE_UNSIGNED, 2, 0},
+    {"lux_gain", BEAM_COL_TYPE_UNSIGNED, 2, 3},           // 0 = light sensor not read
+    {"lux_integration_ms", BEAM_COL_TYPE_UNSIGNED, 2, 0}, // 0 = light sensor not read
+    {"power_level", BEAM_COL_TYPE_UNSIGNED, 1, 0},        // BEAMPowerLevel
+    {"sleep_interval_s", BEAM_COL_TYPE_UNSIGNED, 4, 0},   // 0 = first row after a reset
+    {"record_seq", BEAM_COL_TYPE_UNSIGNED, 4, 0},
+    {"crc", BEAM_COL_TYPE_CRC, 4, 0},
+};
+
+static_assert(LOG_INACTIVITY_THRESHOLDS == 3, "BEAM_LOG_SCHEMA holds exactly three inactivity thresholds");
+
+#define BEAM_LOG_COLUMN(id) (1UL << (id))
+#define BEAM_LOG_ALL_COLUMNS ((1UL << BEAM_LOG_COLUMN_COUNT) - 1)
+#define BEAM_LOG_REQUIRED_COLUMNS \
+    (BEAM_LOG_COLUMN(BEAM_COL_DATETIME) | BEAM_LOG_COLUMN(BEAM_COL_RECORD_SEQ) | BEAM_LOG_COLUMN(BEAM_COL_CRC))
+
+// Columns left out of this build's files, e.g. build flag
+// -DBEAM_LOG_DROP_COLUMNS="(BEAM_LOG_COLUMN(BEAM_COL_MILLIS)|BEAM_LOG_COLUMN(BEAM_COL_MIN_FREE_HEAP))"
+#ifndef BEAM_LOG_DROP_COLUMNS
+#define BEAM_LOG_DROP_COLUMNS 0
+#endif
+
+static_assert(((BEAM_LOG_DROP_COLUMNS) & BEAM_LOG_REQUIRED_COLUMNS) == 0,
+              "datetime, record_seq and crc are needed to find and check records");
+
+constexpr uint32_t BEAM_LOG_COLUMNS = BEAM_LOG_ALL_COLUMNS & ~(uint32_t)(BEAM_LOG_DROP_COLUMNS);
+
+constexpr bool beamValidColumns(uint32_t columns)
+{
+    return (columns & ~(uint32_t)BEAM_LOG_ALL_COLUMNS) == 0 &&
+           (columns & BEAM_LOG_REQUIRED_COLUMNS) == BEAM_LOG_REQUIRED_COLUMNS;
+}
+
+constexpr size_t beamStoredSize(const BEAMLogColumn &column)
+{
+    return column.type == BEAM_COL_TYPE_TEXT ? 0 : column.size;
+}
+
+// Offset of a column in a binary record (columns are stored in CSV order)
+constexpr size_t beamColumnOffset(uint32_t columns, int id)
+{
+    size_t offset = 0;
+    for (int i = 0; i < id; i++)
+    {
+        offset += (columns & BEAM_LOG_COLUMN(i)) ? beamStoredSize(BEAM_LOG_SCHEMA[i]) : 0;
+    }
+    return offset;
+}
+
+constexpr size_t beamLogRecordSize(uint32_t columns)
+{
+    return beamColumnOffset(columns, BEAM_LOG_COLUMN_COUNT);
+}
+
+constexpr size_t beamDigits(uint32_t value)
+{
+    return value < 10 ? 1 : 1 + beamDigits(value / 10);
+}
+
+// Longest text a column can produce
+constexpr size_t beamColumnWidth(const BEAMLogColumn &column)
+{
+    switch (column.type)
+    {
+    case BEAM_COL_TYPE_DATETIME:
+        return 19;
+    case BEAM_COL_TYPE_TEXT:
+        return column.size;
+    case BEAM_COL_TYPE_CRC:
+        return 2 * column.size;
+    default:
+        break;
+    }
+    bool isSigned = column.type == BEAM_COL_TYPE_SIGNED;
+    uint32_t largest = column.size >= 4 ? (isSigned ? 0x80000000UL : 0xFFFFFFFFUL)
+                                        : (1UL << (8 * column.size - isSigned)) - !isSigned;
+    size_t digits = beamDigits(largest);
+    if (column.decimals > 0)
+    {
+        digits = (digits > column.decimals ? digits : column.decimals + 1) + 1; // leading 0 and point
+    }
+    return digits + isSigned;
+}
+
+constexpr size_t beamMaxColumnWidth()
+{
+    size_t widest = 0;
+    for (int id = 0; id < BEAM_LOG_COLUMN_COUNT; id++)
+    {
+        size_t width = beamColumnWidth(BEAM_LOG_SCHEMA[id]);
+        widest = width > widest ? width : widest;
+    }
+    return widest;
+}
+
+constexpr size_t beamCSVHeaderLength(uint32_t columns)
+{
+    size_t length = 0;
+    for (int id = 0; id < BEAM_LOG_COLUMN_COUNT; id++)
+    {
+        if (columns & BEAM_LOG_COLUMN(id))
+        {
+            for (const char *c = BEAM_LOG_SCHEMA[id].name; *c; c++)
+            {
+                length++;
+            }
+            length++; // comma, or the terminator after the last column
+        }
+    }
+    return length - 1;
+}
+
+// Buffer size for one CSV row, including the terminator
+constexpr size_t beamCSVRowSize(uint32_t columns)
+{
+    size_t size = 0;
+    for (int id = 0; id < BEAM_LOG_COLUMN_COUNT; id++)
+    {
+        size += (columns & BEAM_LOG_COLUMN(id)) ? beamColumnWidth(BEAM_LOG_SCHEMA[id]) + 1 : 0;
+    }
+    return size;
+}
+
+// Writes the header line for a column set (beamCSVHeaderLength() + 1 bytes)
+constexpr void beamWriteCSVHeader(uint32_t columns, char *out)
+{
+    size_t length = 0;
+    for (int id = 0; id < BEAM_LOG_COLUMN_COUNT; id++)
+    {
+        if (columns & BEAM_LOG_COLUMN(id))
+        {
+            if (length > 0)
+            {
+                out[length++] = ',';
+            }
+            for (const char *c = BEAM_LOG_SCHEMA[id].name; *c; c++)
+            {
+                out[length++] = *c;
+            }
+        }
+    }
+    out[length] = '\0';
+}
+
+template <uint32_t Columns>
+struct BEAMLogCSVHeader
+{
+    char text[beamCSVHeaderLength(Columns) + 1] = {};
+    constexpr BEAMLogCSVHeader() { beamWriteCSVHeader(Columns, text); }
+};
+
+// Column set fixed at compile time: iteration is unrolled and columns
+// outside Columns generate no code
+template <uint32_t Columns>
+struct BEAMStaticColumns
+{
+    static_assert(beamValidColumns(Columns), "column set must include datetime, record_seq and crc");
+    static constexpr uint32_t mask = Columns;
+
+    // Calls f(column, id, offset) for each column in CSV order; offset is the
+    // column's position in a binary record. Stops when f returns false.
+    template <typename F>
+    static bool forEach(F &&f)
+    {
+        return forEach(f, std::make_index_sequence<BEAM_LOG_COLUMN_COUNT>());
+    }
+
+private:
+    template <typename F, size_t... I>
+    static bool forEach(F &f, std::index_sequence<I...>)
+    {
+        return ((!(Columns & BEAM_LOG_COLUMN(I)) ||
+                 f(BEAM_LOG_SCHEMA[I], (int)I, std::integral_constant<size_t, beamColumnOffset(Columns, I)>::value)) &&
+                ...);
+    }
+};
+
+// Column set read from a file header (host decoder)
+struct BEAMColumnSet
+{
+    uint32_t mask;
+
+    template <typename F>
+    bool forEach(F &&f) const
+    {
+        size_t offset = 0;
+        for (int id = 0; id < BEAM_LOG_COLUMN_COUNT; id++)
+        {
+            if (mask & BEAM_LOG_COLUMN(id))
+            {
+                if (!f(BEAM_LOG_SCHEMA[id], id, offset))
+                {
+                    return false;
+                }
+                offset += beamStoredSize(BEAM_LOG_SCHEMA[id]);
+            }
+        }
+        return true;
+    }
+};
+
+// This build's files
+typedef BEAMStaticColumns<BEAM_LOG_COLUMNS> BEAMLogColumns;
+inline constexpr BEAMLogCSVHeader<BEAM_LOG_COLUMNS> beamLogCSVHeader;
+#define CSV_HEADER (beamLogCSVHeader.text)
+#define BEAM_LOG_RECORD_SIZE beamLogRecordSize(BEAM_LOG_COLUMNS)
+#define BEAM_LOG_CSV_ROW_SIZE beamCSVRowSize(BEAM_LOG_COLUMNS)
+#define BEAM_LOG_MAX_RECORD_SIZE beamLogRecordSize(BEAM_LOG_ALL_COLUMNS) // Any column set
+#define BEAM_LOG_MAX_CSV_ROW_SIZE beamCSVRowSize(BEAM_LOG_ALL_COLUMNS)
+
+#define BEAM_LOG_MAGIC "BEAM"
+#define BEAM_LOG_FORMAT_VERSION 6 // Bump when the record encoding changes
+
+struct __attribute__((packed)) BEAMLogFileHeader
+{
+    char magic[4];          // BEAM_LOG_MAGIC, not null terminated
+    uint8_t formatVersion;  // BEAM_LOG_FORMAT_VERSION
+    uint8_t headerSize;     // sizeof(BEAMLogFileHeader)
+    uint16_t recordSize;    // beamLogRecordSize(columns)
+    char deviceID[4];       // device_id column, null terminated
+    char libraryVersion[12]; // library_version column, null terminated
+    uint32_t columns;       // BEAM_LOG_COLUMN() bits of the columns present
+};
+
+// One encoded record: the stored columns in CSV order, little endian, with
+// the crc column last
+struct BEAMLogBinaryRecord
+{
+    uint8_t data[BEAM_LOG_RECORD_SIZE];
+};
+
+#define BEAM_LOG_CRC_DIGITS 8 // crc column: lowercase hex, zero padded
+
+// CRC-32 as in zlib's crc32(), so ingest scripts can check rows directly.
+// Half a byte per step from a 16-entry table: a quarter of the bitwise
+// loop's work for 64 bytes of flash.
+constexpr uint32_t BEAM_CRC32_NIBBLES[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+inline uint32_t beamCRC32(const void *data, size_t length, uint32_t crc = 0)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    while (length--)
+    {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ BEAM_CRC32_NIBBLES[crc & 0xF];
+        crc = (crc >> 4) ^ BEAM_CRC32_NIBBLES[crc & 0xF];
+    }
+    return ~crc;
+}
+
+inline void beamStoreField(uint8_t *field, size_t size, uint32_t value)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        field[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+inline uint32_t beamLoadField(const uint8_t *field, size_t size)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        value |= (uint32_t)field[i] << (8 * i);
+    }
+    return value;
+}
+
+constexpr double beamPow10(uint8_t decimals)
+{
+    return decimals == 0 ? 1.0 : 10.0 * beamPow10(decimals - 1);
+}
+
+// beamScaled() splits a reading into two 26-bit halves, whose products
+// with 10^decimals are exact while 10^decimals fits in 26 bits
+constexpr bool beamExactDecimals()
+{
+    for (int id = 0; id < BEAM_LOG_COLUMN_COUNT; id++)
+    {
+        if (BEAM_LOG_SCHEMA[id].decimals > 7)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(beamExactDecimals(), "readings need at most 7 decimals to scale exactly");
+
+// A reading in units of 10^-decimals, rounded as printf rounds it: to the
+// nearest integer, ties to even. Only a product that lands on a tie can be
+// wrong, so then the product's rounding error (Dekker's exact product, no
+// fma() needed) says on which side of the tie the exact value lies.
+inline double beamScaled(double value, uint8_t decimals)
+{
+    const double scale = beamPow10(decimals);
+    double product = value * scale;
+    double rounded = nearbyint(product);
+    if (fabs(product - rounded) == 0.5)
+    {
+        double split = value * 134217729.0; // 2^27 + 1
+        double high = split - (split - value);
+        double low = value - high;
+        double error = low * scale - (product - high * scale);
+        if (error != 0)
+        {
+            rounded = error > 0 ? ceil(product) : floor(product);
+        }
+    }
+    return rounded;
+}
+
+// A sensor reading in a column's fixed-point units
+inline uint32_t beamFixed(double value, int id)
+{
+    return (uint32_t)(int64_t)beamScaled(value, BEAM_LOG_SCHEMA[id].decimals);
+}
+
+// Value stored for a column (wraps to the column's size, as a cast would)
+inline uint32_t beamColumnValue(const LogRecord &record, int id, uint32_t sequence)
+{
+    switch (id)
+    {
+    case BEAM_COL_DATETIME:
+        return record.timestamp;
+    case BEAM_COL_MILLIS:
+        return record.millis;
+    case BEAM_COL_BATTERY_VOLTAGE:
+        return beamFixed(record.batteryVoltage, id);
+    case BEAM_COL_TEMPERATURE:
+        return beamFixed(record.temperatureC, id);
+    case BEAM_COL_PRESSURE:
+        return beamFixed(record.pressureHpa, id);
+    case BEAM_COL_HUMIDITY:
+        return beamFixed(record.humidityPercent, id);
+    case BEAM_COL_LUX:
+        return beamFixed(record.lux, id);
+    case BEAM_COL_ACTIVITY_COUNT:
+        return record.activityCount;
+    case BEAM_COL_ACTIVITY_PERCENT:
+        return beamFixed(record.activityPercent, id);
+    case BEAM_COL_INACTIVITY_PERIOD:
+        return record.inactivityPeriods[0];
+    case BEAM_COL_INACTIVITY_COUNT:
+        return record.inactivityCounts[0];
+    case BEAM_COL_INACTIVITY_PERCENT:
+        return beamFixed(record.inactivityPercent, id);
+    case BEAM_COL_MIN_FREE_HEAP:
+        return record.minFreeHeap;
+    case BEAM_COL_REBOOT:
+        return record.reboot ? 1 : 0;
+    case BEAM_COL_INACTIVITY_PERIOD_2:
+        return record.inactivityPeriods[1];
+    case BEAM_COL_INACTIVITY_COUNT_2:
+        return record.inactivityCounts[1];
+    case BEAM_COL_INACTIVITY_PERIOD_3:
+        return record.inactivityPeriods[2];
+    case BEAM_COL_INACTIVITY_COUNT_3:
+        return record.inactivityCounts[2];
+    case BEAM_COL_LONGEST_INACTIVE:
+        return record.longestInactive;
+    case BEAM_COL_INACTIVE_BOUTS:
+        return record.inactiveBouts;
+    case BEAM_COL_LUX_GAIN:
+        return record.lightSetting == BEAM_LIGHT_SETTING_NONE
+                   ? 0
+                   : beamFixed(beamVEML7700Gain(beamVEML7700SettingConfig(record.lightSetting)), id);
+    case BEAM_COL_LUX_INTEGRATION:
+        return record.lightSetting == BEAM_LIGHT_SETTING_NONE
+                   ? 0
+                   : beamVEML7700IntegrationMs(beamVEML7700SettingConfig(record.lightSetting));
+    case BEAM_COL_POWER_LEVEL:
+        return record.powerLevel;
+    case BEAM_COL_SLEEP_INTERVAL:
+        return record.sleepSeconds;
+    case BEAM_COL_RECORD_SEQ:
+        return sequence;
+    default:
+        return 0;
+    }
+}
+
+// Reading of a column measured as a float or double; false for the other
+// columns
+inline bool beamColumnFloat(const LogRecord &record, int id, double *value)
+{
+    switch (id)
+    {
+    case BEAM_COL_BATTERY_VOLTAGE:
+        *value = record.batteryVoltage;
+        return true;
+    case BEAM_COL_TEMPERATURE:
+        *value = record.temperatureC;
+        return true;
+    case BEAM_COL_PRESSURE:
+        *value = record.pressureHpa;
+        return true;
+    case BEAM_COL_HUMIDITY:
+        *value = record.humidityPercent;
+        return true;
+    case BEAM_COL_LUX:
+        *value = record.lux;
+        return true;
+    case BEAM_COL_ACTIVITY_PERCENT:
+        *value = record.activityPercent;
+        return true;
+    case BEAM_COL_INACTIVITY_PERCENT:
+        *value = record.inactivityPercent;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Encodes a record (beamLogRecordSize(columns.mask) bytes) and sets its CRC
+template <typename Columns>
+inline void beamEncodeRecord(const Columns &columns, const LogRecord &record, uint32_t sequence, uint8_t *out)
+{
+    columns.forEach(
+        [&](const BEAMLogColumn &column, int id, size_t offset)
+        {
+            if (column.type == BEAM_COL_TYPE_CRC)
+            {
+                beamStoreField(out + offset, column.size, beamCRC32(out, offset));
+            }
+            else if (column.type != BEAM_COL_TYPE_TEXT)
+            {
+                beamStoreField(out + offset, column.size, beamColumnValue(record, id, sequence));
+            }
+            return true;
+        });
+}
+
+inline BEAMLogBinaryRecord beamEncodeRecord(const LogRecord &record, uint32_t sequence)
+{
+    BEAMLogBinaryRecord out;
+    beamEncodeRecord(BEAMLogColumns(), record, sequence, out.data);
+    return out;
+}
+
+inline void beamInitFileHeader(BEAMLogFileHeader &header, const char *deviceID, const char *libraryVersion)
+{
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BEAM_LOG_MAGIC, sizeof(header.magic));
+    header.formatVersion = BEAM_LOG_FORMAT_VERSION;
+    header.headerSize = sizeof(BEAMLogFileHeader);
+    header.recordSize = BEAM_LOG_RECORD_SIZE;
+    snprintf(header.deviceID, sizeof(header.deviceID), "%s", deviceID); // Cut to fit, null terminated
+    snprintf(header.libraryVersion, sizeof(header.libraryVersion), "%s", libraryVersion);
+    header.columns = BEAM_LOG_COLUMNS;
+}
+
+// Any valid header; the device also needs header.columns == BEAM_LOG_COLUMNS
+// before it appends to a file
+inline bool beamCheckFileHeader(const BEAMLogFileHeader &header)
+{
+    return memcmp(header.magic, BEAM_LOG_MAGIC, sizeof(header.magic)) == 0 &&
+           header.formatVersion == BEAM_LOG_FORMAT_VERSION &&
+           header.headerSize == sizeof(BEAMLogFileHeader) &&
+           beamValidColumns(header.columns) &&
+           header.recordSize == beamLogRecordSize(header.columns);
+}
+
+// crc and record_seq are always the last two columns of a record
+inline bool beamCheckBinaryRecord(const uint8_t *record, size_t size)
+{
+    return beamLoadField(record + size - 4, 4) == beamCRC32(record, size - 4);
+}
+
+inline bool beamCheckBinaryRecord(const BEAMLogBinaryRecord &record)
+{
+    return beamCheckBinaryRecord(record.data, sizeof(record.data));
+}
+
+inline uint32_t beamRecordSequence(const uint8_t *record, size_t size)
+{
+    return beamLoadField(record + size - 8, 4);
+}
+
+// Checks one CSV row (without its line terminator) against its crc column
+// and returns its record_seq. False for torn rows and for the header line.
+inline bool beamCheckCSVRow(const char *row, size_t length, uint32_t *sequence)
+{
+    // ...,<record_seq>,<crc>
+    size_t crcStart = length;
+    while (crcStart > 0 && row[crcStart - 1] != ',')
+    {
+        crcStart--;
+    }
+    if (crcStart == 0 || length - crcStart != BEAM_LOG_CRC_DIGITS)
+    {
+        return false;
+    }
+
+    uint32_t crc = 0;
+    for (size_t i = crcStart; i < length; i++)
+    {
+        char c = row[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else
+            return false;
+        crc = (crc << 4) | digit;
+    }
+    if (crc != beamCRC32(row, crcStart))
+    {
+        return false;
+    }
+
+    size_t seqStart = crcStart - 1;
+    while (seqStart > 0 && row[seqStart - 1] != ',')
+    {
+        seqStart--;
+    }
+    uint32_t value = 0;
+    for (size_t i = seqStart; i < crcStart - 1; i++)
+    {
+        value = value * 10 + (row[i] - '0');
+    }
+    *sequence = value;
+    return true;
+}
+
+// Unix seconds to calendar fields (days-from-civil inverse, no time zone)
+inline void beamCivilTime(uint32_t t, int &year, int &month, int &day, int &hour, int &minute, int &second)
+{
+    uint32_t days = t / 86400;
+    uint32_t rem = t % 86400;
+    hour = rem / 3600;
+    minute = rem % 3600 / 60;
+    second = rem % 60;
+
+    uint32_t z = days + 719468;
+    uint32_t era = z / 146097;
+    uint32_t doe = z - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = yoe + era * 400 + (month <= 2);
+}
+
+// Number text without printf (newlib's float formatting dominates row
+// formatting on the device). Each matches the conversion noted for it byte
+// for byte; beamCSVRowSize() leaves room for the longest output.
+
+// "%0*lu" with minDigits (1-10)
+inline size_t beamWriteUnsigned(char *out, uint32_t value, uint8_t minDigits = 1)
+{
+    char digits[10];
+    size_t n = 0;
+    do
+    {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0 || n < minDigits);
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+// "%.<decimals>f" of value / 10^decimals. The double passed to printf is
+// always within a rounding error of that decimal, so printf prints exactly
+// the integer's digits with the point inserted.
+inline size_t beamWriteFixed(char *out, int64_t value, uint8_t decimals)
+{
+    size_t length = 0;
+    if (value < 0)
+    {
+        out[length++] = '-';
+        value = -value;
+    }
+    size_t n = beamWriteUnsigned(out + length, (uint32_t)value, decimals + 1);
+    if (decimals > 0)
+    {
+        char *point = out + length + n - decimals;
+        memmove(point + 1, point, decimals);
+        *point = '.';
+        n++;
+    }
+    return length + n;
+}
+
+// "%08lx"
+inline size_t beamWriteHex(char *out, uint32_t value)
+{
+    for (int i = 7; i >= 0; i--)
+    {
+        out[i] = "0123456789abcdef"[value & 0xF];
+        value >>= 4;
+    }
+    return 8;
+}
+
+// "%04d-%02d-%02d %02d:%02d:%02d" of the calendar time
+inline size_t beamWriteDateTime(char *out, uint32_t unixTime)
+{
+    int year, month, day, hour, minute, second;
+    beamCivilTime(unixTime, year, month, day, hour, minute, second);
+    size_t n = beamWriteUnsigned(out, year, 4);
+    out[n++] = '-';
+    n += beamWriteUnsigned(out + n, month, 2);
+    out[n++] = '-';
+    n += beamWriteUnsigned(out + n, day, 2);
+    out[n++] = ' ';
+    n += beamWriteUnsigned(out + n, hour, 2);
+    out[n++] = ':';
+    n += beamWriteUnsigned(out + n, minute, 2);
+    out[n++] = ':';
+    n += beamWriteUnsigned(out + n, second, 2);
+    return n;
+}
+
+// Formats one stored or TEXT column; returns its length, or -1 if it does not fit
+inline int beamFormatField(const BEAMLogColumn &column, const uint8_t *field, const char *text,
+                           char *buffer, size_t size)
+{
+    char scratch[beamMaxColumnWidth() + 1];
+    char *out = size > beamMaxColumnWidth() ? buffer : scratch; // short buffer: check the real length
+    size_t length;
+    switch (column.type)
+    {
+    case BEAM_COL_TYPE_DATETIME:
+        length = beamWriteDateTime(out, beamLoadField(field, column.size));
+        break;
+    case BEAM_COL_TYPE_UNSIGNED:
+        length = beamWriteFixed(out, beamLoadField(field, column.size), column.decimals);
+        break;
+    case BEAM_COL_TYPE_SIGNED:
+    {
+        uint32_t bits = beamLoadField(field, column.size);
+        uint32_t sign = 1UL << (8 * column.size - 1);
+        length = beamWriteFixed(out, (int32_t)((bits ^ sign) - sign), column.decimals); // sign-extend
+        break;
+    }
+    case BEAM_COL_TYPE_TEXT:
+        length = strnlen(text, column.size);
+        memcpy(out, text, length);
+        break;
+    default:
+        return -1;
+    }
+    if (length >= size)
+    {
+        return -1;
+    }
+    if (out != buffer)
+    {
+        memcpy(buffer, out, length);
+    }
+    buffer[length] = '\0';
+    return (int)length;
+}
+
+// True if a reading fits its column's stored range once scaled and rounded
+inline bool beamFloatInRange(const BEAMLogColumn &column, double value)
+{
+    bool isSigned = column.type == BEAM_COL_TYPE_SIGNED;
+    double largest = ldexp(1.0, 8 * column.size - isSigned) - 1;
+    double scaled = beamScaled(value, column.decimals);
+    return scaled <= largest && (isSigned ? scaled >= -largest - 1 : !signbit(value));
+}
+
+// "%.<decimals>f" of a reading whose scaled value fits in 32 bits, or is
+// NaN or infinite; returns the length, or -1 if it does not fit
+inline int beamFormatFloat(const BEAMLogColumn &column, double value, char *buffer, size_t size)
+{
+    char out[beamMaxColumnWidth() + 1];
+    size_t length = 0;
+    if (signbit(value))
+    {
+        out[length++] = '-'; // also "-0.00" for a small negative reading
+    }
+    if (isnan(value) || isinf(value))
+    {
+        memcpy(out + length, isnan(value) ? "nan" : "inf", 3);
+        length += 3;
+    }
+    else
+    {
+        length += beamWriteFixed(out + length, (uint32_t)beamScaled(fabs(value), column.decimals), column.decimals);
+    }
+    if (length >= size)
+    {
+        return -1;
+    }
+    memcpy(buffer, out, length);
+    buffer[length] = '\0';
+    return (int)length;
+}
+
+// Formats one column of a record as the CSV writer does. Readings outside
+// the column's stored range (never produced by the sensors) print as stored,
+// which keeps the row within beamCSVRowSize(); NaN and infinity print as
+// printf prints them.
+inline int beamFormatColumn(const BEAMLogColumn &column, int id, const LogRecord &record, uint32_t sequence,
+                            const char *text, char *buffer, size_t size)
+{
+    double value;
+    if (beamColumnFloat(record, id, &value) && (!isfinite(value) || beamFloatInRange(column, value)))
+    {
+        return beamFormatFloat(column, value, buffer, size);
+    }
+    uint8_t field[4];
+    beamStoreField(field, beamStoredSize(column), beamColumnValue(record, id, sequence));
+    return beamFormatField(column, field, text, buffer, size);
+}
+
+// Joins the columns into one row and appends the crc; format(column, id,
+// offset, buffer, size) writes each other column. Returns the row length,
+// or -1 if it does not fit (beamCSVRowSize(columns.mask) always does).
+template <typename Columns, typename F>
+inline int beamFormatCSVColumns(const Columns &columns, char *buffer, size_t size, F &&format)
+{
+    size_t length = 0;
+    bool fits = columns.forEach(
+        [&](const BEAMLogColumn &column, int id, size_t offset)
+        {
+            if (length > 0)
+            {
+                if (length + 1 >= size)
+                {
+                    return false;
+                }
+                buffer[length++] = ',';
+            }
+            int n;
+            if (column.type == BEAM_COL_TYPE_CRC)
+            {
+                // crc covers the row text up to and including the comma before it
+                if (size - length <= BEAM_LOG_CRC_DIGITS)
+                {
+                    return false;
+                }
+                n = beamWriteHex(buffer + length, beamCRC32(buffer, length));
+                buffer[length + n] = '\0';
+            }
+            else
+            {
+                n = format(column, id, offset, buffer + length, size - length);
+            }
+            if (n < 0)
+            {
+                return false;
+            }
+            length += n;
+            return true;
+        });
+    return fits ? (int)length : -1;
+}
+
+// CSV row of a record, from its measured values (the device's CSV files)
+template <typename Columns>
+inline int beamFormatCSVRow(const Columns &columns, const LogRecord &record, uint32_t sequence,
+                            const char *deviceID, const char *libraryVersion, char *buffer, size_t size)
+{
+    return beamFormatCSVColumns(columns, buffer, size,
+                                [&](const BEAMLogColumn &column, int id, size_t, char *out, size_t outSize)
+                                {
+                                    const char *text = id == BEAM_COL_DEVICE_ID ? deviceID : libraryVersion;
+                                    return beamFormatColumn(column, id, record, sequence, text, out, outSize);
+                                });
+}
+
+inline int beamFormatCSVRow(const LogRecord &record, uint32_t sequence, const char *deviceID,
+                            const char *libraryVersion, char *buffer, size_t size)
+{
+    return beamFormatCSVRow(BEAMLogColumns(), record, sequence, deviceID, libraryVersion, buffer, size);
+}
+
+// CSV row of an encoded record, from its stored integers (the decoder)
+template <typename Columns>
+inline int beamFormatCSVRow(const Columns &columns, const uint8_t *record, const char *deviceID,
+                            const char *libraryVersion, char *buffer, size_t size)
+{
+    return beamFormatCSVColumns(columns, buffer, size,
+                                [&](const BEAMLogColumn &column, int id, size_t offset, char *out, size_t outSize)
+                                {
+                                    const char *text = id == BEAM_COL_DEVICE_ID ? deviceID : libraryVersion;
+                                    return beamFormatField(column, record + offset, text, out, outSize);
+                                });
+}
+
+inline int beamFormatCSVRow(const BEAMLogBinaryRecord &record, const char *deviceID, const char *libraryVersion,
+                            char *buffer, size_t size)
+{
+    return beamFormatCSVRow(BEAMLogColumns(), record.data, deviceID, libraryVersion, buffer, size);
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+// One data row, captured at wake time and formatted when it reaches the SD
+// card. Plain fixed-width fields so records can sit in RTC memory between
+// wakes. Device ID and library version are added at format time.
+#include <stdint.h>
+
+#ifndef LOG_BATCH_CAPACITY
+#define LOG_BATCH_CAPACITY 32 // Records retained in RTC memory between SD flushes
+#endif
+
+#define LOG_INACTIVITY_THRESHOLDS 3
+
+struct LogRecord
+{
+    uint32_t timestamp; // Unix time
+    uint32_t millis;
+    uint32_t minFreeHeap;
+    uint32_t sleepSeconds; // Sleep interval that ended with this wake (0 after a reset)
+    double activityPercent;   // 0-1, kept double: the CSV prints "%.3f" of the computed ratio
+    double inactivityPercent; // 0-1, for inactivityPeriods[0]
+    float batteryVoltage;
+    float temperatureC;
+    float pressureHpa;
+    float humidityPercent;
+    float lux;
+    uint16_t activityCount;
+    uint16_t inactivityPeriods[LOG_INACTIVITY_THRESHOLDS]; // Seconds
+    uint16_t inactivityCounts[LOG_INACTIVITY_THRESHOLDS];
+    uint16_t longestInactive; // Seconds
+    uint16_t inactiveBouts;
+    uint8_t reboot;
+    uint8_t lightSetting; // VEML7700 gain and integration time of lux (beamVEML7700Setting())
+    uint8_t powerLevel;   // BEAMPowerLevel of the wake
+    uint8_t reserved[7];
+};
+
+static_assert(sizeof(LogRecord) % sizeof(double) == 0, "LogRecord must have no tail padding in RTC memory");
+
+#endif
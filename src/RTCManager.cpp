@@ -1,43 +1,40 @@
 #include "RTCManager.h"
+#include "BEAMDebug.h"
+#include "BEAMBuildTime.h"
+
+// Computed by the compiler when this file is built; no parsing at boot
+static constexpr uint32_t BUILD_EPOCH = beamBuildEpoch(__DATE__, __TIME__);
+static_assert(BUILD_EPOCH > SECONDS_FROM_1970_TO_2000, "__DATE__ did not parse");
 
 const char *RTCManager::_daysOfWeek[] = {
     "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
 
-RTCManager::RTCManager() : _isInitialized(false)
+RTCManager::RTCManager() : _store(nullptr), _isInitialized(false)
 {
 }
 
-bool RTCManager::begin()
+bool RTCManager::begin(TwoWire *wire, bool timerWake, BEAMSettingsStore *store)
 {
-    if (!_rtc.begin())
+    _store = store;
+    if (!_rtc.begin(wire))
     {
-        Serial.println("Couldn't find RTC");
-        return false;
-    }
-
-    if (!_preferences.begin(PREFS_NAMESPACE, false))
-    {
-        Serial.println("Failed to initialize preferences");
+        BEAM_ERRORF(RTC, "Couldn't find RTC\n");
         return false;
     }
 
     // Only check for new compilation on hard reset
-    esp_reset_reason_t reset_reason = esp_reset_reason();
-    bool isWakeFromSleep = (reset_reason == ESP_SLEEP_WAKEUP_TIMER);
-
-    if (!isWakeFromSleep && isNewCompilation())
+    if (!timerWake && isNewCompilation())
     {
         updateRTC();
         updateCompilationID();
     }
     else if (_rtc.lostPower())
     {
-        Serial.println("RTC lost power, updating time from compilation");
+        BEAM_WARNF(RTC, "RTC lost power, updating time from compilation\n");
         updateRTC();
     }
 
     _isInitialized = true;
-    _preferences.end();
     return true;
 }
 
@@ -88,125 +85,42 @@ DateTime RTCManager::getFutureTime(int days, int hours, int minutes, int seconds
     return now() + span;
 }
 
-String RTCManager::getCompileDateTime()
+uint32_t RTCManager::getBuildEpoch()
 {
-    // Use compiler macros for build time
-    const char *compileDate = __DATE__; // Format: "Mmm dd yyyy"
-    const char *compileTime = __TIME__; // Format: "hh:mm:ss"
-
-    // Parse date components
-    char month[4];
-    int day, year;
-    sscanf(compileDate, "%s %d %d", month, &day, &year);
-
-    // Convert month string to number
-    int monthNum = 1;
-    const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
-    for (int i = 0; i < 12; i++)
-    {
-        if (strncmp(month, months[i], 3) == 0)
-        {
-            monthNum = i + 1;
-            break;
-        }
-    }
-
-    // Parse time components
-    int hour, minute, second;
-    sscanf(compileTime, "%d:%d:%d", &hour, &minute, &second);
-
-    char compileDateTime[32];
-    // Format with just the compile date and time
-    snprintf(compileDateTime, sizeof(compileDateTime),
-             "%04d-%02d-%02d %02d:%02d:%02d",
-             year, monthNum, day,
-             hour, minute, second);
-
-    return String(compileDateTime);
+    return BUILD_EPOCH;
 }
 
 DateTime RTCManager::getCompensatedDateTime()
 {
-    // Parse the compile time directly
-    const char *compileDate = __DATE__; // Format: "Mmm dd yyyy"
-    const char *compileTime = __TIME__; // Format: "hh:mm:ss"
-
-    // Parse date components
-    char month[4];
-    int day, year;
-    sscanf(compileDate, "%s %d %d", month, &day, &year);
-
-    // Convert month string to number
-    int monthNum = 1;
-    const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
-    for (int i = 0; i < 12; i++)
-    {
-        if (strncmp(month, months[i], 3) == 0)
-        {
-            monthNum = i + 1;
-            break;
-        }
-    }
-
-    // Parse time components
-    int hour, minute, second;
-    sscanf(compileTime, "%d:%d:%d", &hour, &minute, &second);
-
-    // Create DateTime object from compile time
-    DateTime compileDateTime(year, monthNum, day, hour, minute, second);
-
     // Add upload delay compensation
-    return compileDateTime + TimeSpan(0, 0, 0, UPLOAD_DELAY_SECONDS);
+    return DateTime(BUILD_EPOCH + UPLOAD_DELAY_SECONDS);
 }
 
 bool RTCManager::isNewCompilation()
 {
-    _preferences.begin(PREFS_NAMESPACE, false);
-    const String currentBuildTime = getCompileDateTime();
-    String storedBuildTime = _preferences.getString("buildTime", "");
-
-    // Store new build time
-    if (currentBuildTime != storedBuildTime)
+    if (!_store)
     {
-        _preferences.putString("buildTime", currentBuildTime);
+        return false;
     }
-    _preferences.end();
-
-    Serial.println("\nChecking build status:");
-    Serial.println("---------------------------");
-    Serial.println("Current build ID:  " + currentBuildTime);
-    Serial.println("Previous build ID: " + storedBuildTime);
-    Serial.println("Is new upload:     " + String(currentBuildTime != storedBuildTime));
-    Serial.println("---------------------------\n");
-
-    return currentBuildTime != storedBuildTime;
+    uint32_t storedEpoch = _store->get(BEAM_SETTING_BUILD_EPOCH);
+    BEAM_VERBOSEF(RTC, "Build epoch %lu, stored %lu: %s\n", (unsigned long)BUILD_EPOCH,
+                       (unsigned long)storedEpoch, storedEpoch != BUILD_EPOCH ? "new upload" : "same build");
+    return storedEpoch != BUILD_EPOCH;
 }
 
 void RTCManager::updateCompilationID()
 {
-    _preferences.begin(PREFS_NAMESPACE, false);
-    const String currentCompileTime = getCompileDateTime();
-
-    Serial.println("\nUpdating compilation ID:");
-    Serial.println("----------------------");
-    Serial.println("Storing new compile time: " + currentCompileTime);
-
-    _preferences.putString("compileTime", currentCompileTime.c_str());
-
-    // Verify storage
-    String verifyTime = _preferences.getString("compileTime", "");
-    Serial.println("Verified stored time:    " + verifyTime);
-    Serial.println("Storage successful:      " + String(verifyTime == currentCompileTime));
-    Serial.println("----------------------\n");
-
-    _preferences.end();
+    if (_store)
+    {
+        _store->set(BEAM_SETTING_BUILD_EPOCH, BUILD_EPOCH); // Written by the next commit
+    }
 }
 
 void RTCManager::updateRTC()
 {
-    Serial.println("\nUpdating RTC time:");
-    Serial.println("----------------");
-    Serial.println("Compile time: " + getCompileDateTime());
+    BEAM_VERBOSEF(RTC, "\nUpdating RTC time:\n");
+    BEAM_VERBOSEF(RTC, "----------------\n");
+    BEAM_VERBOSEF(RTC, "Build epoch: %lu\n", (unsigned long)BUILD_EPOCH);
 
     // Get compensated DateTime
     DateTime compensatedTime = getCompensatedDateTime();
@@ -216,7 +130,7 @@ void RTCManager::updateRTC()
     snprintf(timeStr, sizeof(timeStr), "%04d-%02d-%02d %02d:%02d:%02d",
              compensatedTime.year(), compensatedTime.month(), compensatedTime.day(),
              compensatedTime.hour(), compensatedTime.minute(), compensatedTime.second());
-    Serial.println("Compensated time: " + String(timeStr));
+    BEAM_VERBOSEF(RTC, "Compensated time: %s\n", timeStr);
 
     // Update RTC with compensated time
     _rtc.adjust(compensatedTime);
@@ -227,6 +141,6 @@ void RTCManager::updateRTC()
     snprintf(currentTimeStr, sizeof(currentTimeStr), "%04d-%02d-%02d %02d:%02d:%02d",
              currentTime.year(), currentTime.month(), currentTime.day(),
              currentTime.hour(), currentTime.minute(), currentTime.second());
-    Serial.println("Verified time: " + String(currentTimeStr));
-    Serial.println("----------------\n");
+    BEAM_VERBOSEF(RTC, "Verified time: %s\n", currentTimeStr);
+    BEAM_VERBOSEF(RTC, "----------------\n\n");
 }
\ No newline at end of file
@@ -3,8 +3,7 @@
 
 #include <Arduino.h>
 #include <RTClib.h>
-#include <Preferences.h>
-#include "SharedDefs.h"
+#include "BEAMSettingsStore.h"
 
 #define UPLOAD_DELAY_SECONDS 30 // Compensation for delay between compilation and upload
 
@@ -12,7 +11,11 @@ class RTCManager
 {
 public:
     RTCManager();
-    bool begin();
+    // On a timer wake the DS3231 has kept time and settings and no new
+    // build can have been uploaded, so only lostPower() is checked. The
+    // build is compared with the one stored in store; without a store the
+    // RTC is only set from the build time after a power loss.
+    bool begin(TwoWire *wire = &Wire, bool timerWake = false, BEAMSettingsStore *store = nullptr);
 
     // Basic RTC functions
     DateTime now();
@@ -22,9 +25,11 @@ public:
     void adjustRTC(uint32_t timestamp);
     void adjustRTC(const DateTime &dt);
 
-    // Compilation time management
+    // Compilation time management: the build is identified by its Unix time,
+    // kept as BEAM_SETTING_BUILD_EPOCH and changed only by a new upload
     bool isNewCompilation();
     void updateCompilationID();
+    static uint32_t getBuildEpoch();
 
     // Helper functions
     String getDayOfWeek();
@@ -33,11 +38,10 @@ public:
 
 private:
     RTC_DS3231 _rtc;
-    Preferences _preferences;
+    BEAMSettingsStore *_store;
     bool _isInitialized;
 
     void updateRTC();
-    String getCompileDateTime();
     DateTime getCompensatedDateTime();
     static const char *_daysOfWeek[7];
 
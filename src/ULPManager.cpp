@@ -1,86 +1,32 @@
 #include "ULPManager.h"
 #include "HublinkBEAM.h"
+#include "ULPProgram.h"
+#include "BEAMDebug.h"
 
 #define LED_PIN GPIO_NUM_13
 #define LED_GPIO_INDEX 13
 
-// ULP program to monitor PIR trigger (GPIO3) for LOW state with optimized delay
-const ulp_insn_t ulp_program[] = {
-    // Initialize registers
-    I_MOVI(R2, PIR_COUNT), // R2 = PIR count address (preserve)
-    I_MOVI(R3, 1),         // Initialize motion flag in R3 (1 = no motion detected yet)
-
-    // Start of 1-second window
-    M_LABEL(1),
-    I_MOVI(R1, 40000), // Load sampling iteration count
-    // I_WR_REG(RTC_GPIO_OUT_REG, LED_GPIO_INDEX + RTC_GPIO_OUT_DATA_S, LED_GPIO_INDEX + RTC_GPIO_OUT_DATA_S, 0), // LED off at start
-
-    // Sampling loop
-    M_LABEL(2),
-    I_RD_REG(RTC_GPIO_IN_REG, 3 + RTC_GPIO_IN_NEXT_S, 3 + RTC_GPIO_IN_NEXT_S),
-    M_BG(3, 0),    // If GPIO HIGH (no motion), continue to delay
-    I_MOVI(R3, 0), // Set motion flag (0 = motion detected)
-
-    // Delay and loop control
-    M_LABEL(3),
-    I_DELAY(415),      // ~25µs delay
-    I_SUBI(R1, R1, 1), // Decrement iteration counter
-    I_MOVR(R0, R1),    // Move counter to R0 for comparison
-    M_BE(4, 0),        // If counter = 0, sampling window complete
-    I_MOVR(R0, R3),    // Move motion flag to R0 for final processing
-    M_BE(2, 1),        // If no motion detected yet (R3 = 1), continue sampling
-    M_BX(3),           // Motion already detected, just continue delay
-
-    // 1-second window complete - process results
-    M_LABEL(4),
-    I_MOVR(R0, R3), // Move motion flag to R0 for final processing
-    M_BE(5, 0),     // If motion detected (R0 = 0), increment PIR count
-    M_BX(6),        // Otherwise handle inactivity tracking
-
-    // Increment PIR count
-    M_LABEL(5),
-    I_LD(R1, R2, 0),   // Load current PIR count
-    I_ADDI(R1, R1, 1), // Increment count
-    I_ST(R1, R2, 0),   // Store updated count
-    M_BX(8),           // Reset tracker, start next window
-
-    // Handle inactivity tracking
-    M_LABEL(6),
-    I_MOVI(R1, INACTIVITY_TRACKER), // Use R1 for tracker address
-    I_LD(R0, R1, 0),                // Load current tracker value
-    I_ADDI(R0, R0, 1),              // Increment tracker
-    I_ST(R0, R1, 0),                // Store updated tracker
-    I_MOVI(R1, INACTIVITY_PERIOD),  // Load period address
-    I_LD(R1, R1, 0),                // Load period value into R1
-    I_SUBR(R0, R1, R0),             // R0 =  period - tracker
-    M_BG(9, 1),                     // If (period - tracker) > 1, start next window; else increment INACTIVITY_COUNT
-
-    // Increment INACTIVITY_COUNT then reset tracker
-    I_MOVI(R1, INACTIVITY_COUNT), // Load count address
-    I_LD(R0, R1, 0),              // Load current INACTIVITY_COUNT
-    I_ADDI(R0, R0, 1),            // Increment INACTIVITY_COUNT
-    I_ST(R0, R1, 0),              // Store updated INACTIVITY_COUNT
-    // I_WR_REG(RTC_GPIO_OUT_REG, LED_GPIO_INDEX + RTC_GPIO_OUT_DATA_S, LED_GPIO_INDEX + RTC_GPIO_OUT_DATA_S, 1), // LED on
-
-    // Reset tracker
-    M_LABEL(8),
-    I_MOVI(R0, 0),                  // Set R0 to 0
-    I_MOVI(R1, INACTIVITY_TRACKER), // Put INACTIVITY_TRACKER into R1
-    I_ST(R0, R1, 0),                // Store/reset tracker
-
-    M_LABEL(9),
-    I_MOVI(R3, 1), // Reset motion flag for next window
-    M_BX(1),       // Jump back to start of 1-second window
-};
-
 ULPManager::ULPManager()
 {
     _initialized = false;
+    _mode = ULP_MODE_CONTINUOUS;
+    _sampleHz = ULP_DEFAULT_SAMPLE_HZ;
+}
+
+void ULPManager::setSamplingMode(ULPSamplingMode mode, uint16_t sampleHz)
+{
+    if (sampleHz < ULP_MIN_SAMPLE_HZ || sampleHz > ULP_MAX_SAMPLE_HZ)
+    {
+        BEAM_WARNF(ULP, "  ULP: sample rate %d Hz out of range, using %d Hz\n", sampleHz, ULP_DEFAULT_SAMPLE_HZ);
+        sampleHz = ULP_DEFAULT_SAMPLE_HZ;
+    }
+    _mode = mode;
+    _sampleHz = sampleHz;
 }
 
 void ULPManager::begin()
 {
-    Serial.println("  ULP: begin");
+    BEAM_VERBOSEF(ULP, "  ULP: begin\n");
 
     // Configure LED pin for debugging
     rtc_gpio_init((gpio_num_t)LED_BUILTIN);
@@ -98,38 +44,68 @@ void ULPManager::begin()
     rtc_gpio_pullup_dis(SDA_GPIO); // Use hardware pullup
     rtc_gpio_pulldown_dis(SDA_GPIO);
 
-    // Clear all counters
+    // Clear all counters; motion events stay queued until the caller has
+    // logged them (readEvents(), then consumeEvents())
     clearPIRCount();
     clearInactivityCounters();
 
     _initialized = true;
-    Serial.println("  ULP: initialization complete");
+    BEAM_VERBOSEF(ULP, "  ULP: initialization complete\n");
 }
 
 void ULPManager::start()
 {
-    Serial.println("  ULP: starting program");
+    BEAM_VERBOSEF(ULP, "  ULP: starting program\n");
 
     // Always reload the ULP program when starting
-    size_t size = sizeof(ulp_program) / sizeof(ulp_insn_t);
-    esp_err_t err = ulp_process_macros_and_load(PROG_START, ulp_program, &size);
+    const ulp_insn_t *program = ulp_program.insns.data();
+    size_t size = ulp_program.insns.size();
+    size_t words = ulp_program.words;
+    if (_mode == ULP_MODE_TIMER)
+    {
+        program = ulp_timer_program.insns.data();
+        size = ulp_timer_program.insns.size();
+        words = ulp_timer_program.words;
+
+        // Each wakeup takes one sample; windowMs worth of samples make a window
+        uint32_t samplesPerWindow = (uint32_t)_sampleHz * ULP_PROGRAM_CONFIG.windowMs / 1000;
+        RTC_SLOW_MEM[WINDOW_MOTION] = 0;
+        RTC_SLOW_MEM[WINDOW_SAMPLES] = 0;
+        RTC_SLOW_MEM[SAMPLES_PER_WINDOW] = samplesPerWindow > 0 ? samplesPerWindow : 1;
+        ulp_set_wakeup_period(0, 1000000UL / _sampleHz);
+        BEAM_VERBOSEF(ULP, "  ULP: timer mode at %d Hz\n", _sampleHz);
+    }
+
+    esp_err_t err = ulp_process_macros_and_load(PROG_START, program, &size);
     if (err != ESP_OK)
     {
-        Serial.printf("  ULP: program load error: %d\n", err);
+        BEAM_ERRORF(ULP, "  ULP: program load error: %d\n", err);
         return;
     }
 
+    // The word counts in ULPProgram.h size the compile-time memory check;
+    // they are only verified against the table on the host, where branch
+    // macros expand differently
+    if (size != words)
+    {
+        BEAM_ERRORF(ULP, "  ULP: program loaded as %u words, ULPProgram.h counts %u\n", (unsigned)size,
+                         (unsigned)words);
+    }
+
     err = ulp_run(PROG_START);
     if (err != ESP_OK)
     {
-        Serial.printf("  ULP: start error: %d\n", err);
+        BEAM_ERRORF(ULP, "  ULP: start error: %d\n", err);
         return;
     }
-    Serial.println("  ULP: program started");
+    BEAM_VERBOSEF(ULP, "  ULP: program started\n");
 }
 
 void ULPManager::stop()
 {
+    // Stop timer-driven wakeups before releasing the pins
+    ulp_timer_stop();
+
     // First disable holds
     rtc_gpio_hold_dis(SDA_GPIO);
     rtc_gpio_hold_dis((gpio_num_t)PIN_SD_PWR_EN);
@@ -143,49 +119,141 @@ void ULPManager::stop()
     rtc_gpio_set_direction((gpio_num_t)PIN_SD_PWR_EN, RTC_GPIO_MODE_DISABLED);
     rtc_gpio_deinit((gpio_num_t)PIN_SD_PWR_EN);
 
-    Serial.println("  ULP: program stopped");
+    BEAM_VERBOSEF(ULP, "  ULP: program stopped\n");
 }
 
 uint16_t ULPManager::getPIRCount()
 {
     uint16_t count = (uint16_t)(RTC_SLOW_MEM[PIR_COUNT] & 0xFFFF);
-    Serial.printf("  ULP: current PIR count: %d\n", count);
+    BEAM_VERBOSEF(ULP, "  ULP: current PIR count: %d\n", count);
     return count;
 }
 
 void ULPManager::clearPIRCount()
 {
-    Serial.println("  ULP: clearing PIR count");
+    BEAM_VERBOSEF(ULP, "  ULP: clearing PIR count\n");
     RTC_SLOW_MEM[PIR_COUNT] = 0;
-    Serial.printf("  ULP: verified count is now: %d\n", (uint16_t)(RTC_SLOW_MEM[PIR_COUNT] & 0xFFFF));
+    BEAM_VERBOSEF(ULP, "  ULP: verified count is now: %d\n", (uint16_t)(RTC_SLOW_MEM[PIR_COUNT] & 0xFFFF));
 }
 
-void ULPManager::setInactivityPeriod(uint16_t seconds)
+void ULPManager::setInactivityPeriod(uint16_t seconds, uint8_t index)
 {
-    Serial.printf("  ULP: setting inactivity period to %d seconds\n", seconds);
-    RTC_SLOW_MEM[INACTIVITY_PERIOD] = seconds;
+    if (index >= ULP_INACTIVITY_THRESHOLDS)
+    {
+        return;
+    }
+    BEAM_VERBOSEF(ULP, "  ULP: setting inactivity period %d to %d seconds\n", index, seconds);
+    RTC_SLOW_MEM[ULP_INACTIVITY_WORD(INACTIVITY_PERIOD, index)] = seconds;
 }
 
-uint16_t ULPManager::getInactivityCount()
+uint16_t ULPManager::getInactivityCount(uint8_t index)
 {
-    uint16_t count = (uint16_t)(RTC_SLOW_MEM[INACTIVITY_COUNT] & 0xFFFF);
-    Serial.printf("  ULP: current inactivity count: %d\n", count);
+    if (index >= ULP_INACTIVITY_THRESHOLDS)
+    {
+        return 0;
+    }
+    uint16_t count = (uint16_t)(RTC_SLOW_MEM[ULP_INACTIVITY_WORD(INACTIVITY_COUNT, index)] & 0xFFFF);
+    BEAM_VERBOSEF(ULP, "  ULP: current inactivity count %d: %d\n", index, count);
     return count;
 }
 
 uint16_t ULPManager::getInactivityTracker()
 {
     uint16_t tracker = (uint16_t)(RTC_SLOW_MEM[INACTIVITY_TRACKER] & 0xFFFF);
-    Serial.printf("  ULP: current inactivity tracker: %d\n", tracker);
+    BEAM_VERBOSEF(ULP, "  ULP: current inactivity tracker: %d\n", tracker);
     return tracker;
 }
 
 void ULPManager::clearInactivityCounters()
 {
-    Serial.println("  ULP: clearing inactivity counters");
-    RTC_SLOW_MEM[INACTIVITY_COUNT] = 0;
-    RTC_SLOW_MEM[INACTIVITY_TRACKER] = 0;
-    Serial.printf("  ULP: verified counters are now: count=%d, tracker=%d\n",
-                  (uint16_t)(RTC_SLOW_MEM[INACTIVITY_COUNT] & 0xFFFF),
-                  (uint16_t)(RTC_SLOW_MEM[INACTIVITY_TRACKER] & 0xFFFF));
-}
\ No newline at end of file
+    BEAM_VERBOSEF(ULP, "  ULP: clearing inactivity counters\n");
+    for (uint8_t i = 0; i < ULP_INACTIVITY_THRESHOLDS; i++)
+    {
+        RTC_SLOW_MEM[ULP_INACTIVITY_WORD(INACTIVITY_COUNT, i)] = 0;
+        RTC_SLOW_MEM[ULP_INACTIVITY_WORD(INACTIVITY_TRACKER, i)] = 0;
+    }
+    RTC_SLOW_MEM[BOUT_LENGTH] = 0;
+    RTC_SLOW_MEM[LONGEST_BOUT] = 0;
+    RTC_SLOW_MEM[BOUT_COUNT] = 0;
+    BEAM_VERBOSEF(ULP, "  ULP: verified counters are now: count=%d, tracker=%d\n",
+                       (uint16_t)(RTC_SLOW_MEM[INACTIVITY_COUNT] & 0xFFFF),
+                       (uint16_t)(RTC_SLOW_MEM[INACTIVITY_TRACKER] & 0xFFFF));
+}
+
+uint16_t ULPManager::getLongestInactiveBout()
+{
+    uint16_t longest = (uint16_t)(RTC_SLOW_MEM[LONGEST_BOUT] & 0xFFFF);
+    BEAM_VERBOSEF(ULP, "  ULP: longest inactive bout: %d\n", longest);
+    return longest;
+}
+
+uint16_t ULPManager::getInactiveBoutCount()
+{
+    uint16_t bouts = (uint16_t)(RTC_SLOW_MEM[BOUT_COUNT] & 0xFFFF);
+    BEAM_VERBOSEF(ULP, "  ULP: inactive bouts: %d\n", bouts);
+    return bouts;
+}
+
+uint16_t ULPManager::readEvents(ULPMotionEvent *events, uint16_t maxEvents)
+{
+    uint16_t head = (uint16_t)(RTC_SLOW_MEM[EVENT_HEAD] & 0xFFFF);
+    uint16_t tail = (uint16_t)(RTC_SLOW_MEM[EVENT_TAIL] & 0xFFFF);
+    uint16_t count = 0;
+    uint32_t base = 0; // Unwraps the 15-bit window tick
+    uint16_t lastTick = 0;
+
+    while (tail != head && count < maxEvents)
+    {
+        uint16_t word = (uint16_t)(RTC_SLOW_MEM[EVENT_BUFFER + (tail & (ULP_EVENT_BUFFER_SIZE - 1))] & 0xFFFF);
+        uint16_t tick = word & ULP_EVENT_TICK_MASK;
+        if (tick < lastTick)
+        {
+            base += ULP_EVENT_TICK_MASK + 1;
+        }
+        lastTick = tick;
+        events[count].window = base + tick;
+        events[count].onset = !(word & ULP_EVENT_OFFSET_BIT);
+        count++;
+        tail++;
+    }
+
+    BEAM_VERBOSEF(ULP, "  ULP: read %d motion events\n", count);
+    return count;
+}
+
+void ULPManager::consumeEvents(uint16_t count, uint16_t dropped)
+{
+    // Hand the logged slots back to the ULP. A busy-loop program keeps
+    // running after ulp_timer_stop(), so events dropped since
+    // getEventOverflow() was read may already be counted: subtract only the
+    // logged drops instead of zeroing the counter.
+    RTC_SLOW_MEM[EVENT_TAIL] = (RTC_SLOW_MEM[EVENT_TAIL] + count) & 0xFFFF;
+    uint16_t overflow = (uint16_t)(RTC_SLOW_MEM[EVENT_OVERFLOW] & 0xFFFF);
+    RTC_SLOW_MEM[EVENT_OVERFLOW] = (uint16_t)(overflow - dropped);
+}
+
+bool ULPManager::hasEvents()
+{
+    return (RTC_SLOW_MEM[EVENT_HEAD] & 0xFFFF) != (RTC_SLOW_MEM[EVENT_TAIL] & 0xFFFF) ||
+           (RTC_SLOW_MEM[EVENT_OVERFLOW] & 0xFFFF) != 0;
+}
+
+uint16_t ULPManager::getEventOverflow()
+{
+    return (uint16_t)(RTC_SLOW_MEM[EVENT_OVERFLOW] & 0xFFFF);
+}
+
+uint16_t ULPManager::getWindowCount()
+{
+    return (uint16_t)(RTC_SLOW_MEM[WINDOW_TICK] & 0xFFFF);
+}
+
+void ULPManager::clearEvents()
+{
+    BEAM_VERBOSEF(ULP, "  ULP: clearing motion events\n");
+    RTC_SLOW_MEM[WINDOW_TICK] = 0;
+    RTC_SLOW_MEM[MOTION_STATE] = 0;
+    RTC_SLOW_MEM[EVENT_HEAD] = 0;
+    RTC_SLOW_MEM[EVENT_TAIL] = 0;
+    RTC_SLOW_MEM[EVENT_OVERFLOW] = 0;
+}
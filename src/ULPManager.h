@@ -7,19 +7,28 @@
 #include "soc/rtc_io_reg.h"
 #include "ulp_common.h"
 #include "SharedDefs.h"
+#include "ULPMemoryMap.h"
 
-// Move constants outside the class
-enum
+// ESP32-S3 specific GPIO mappings
+#define SDA_GPIO GPIO_NUM_3 // GPIO3 for SDA
+
+// ULP sampling modes
+enum ULPSamplingMode
 {
-    PIR_COUNT,          // RTC memory location for motion counter
-    INACTIVITY_COUNT,   // Count of times inactivity period was exceeded
-    INACTIVITY_TRACKER, // Current consecutive inactive seconds
-    INACTIVITY_PERIOD,  // Target period for inactivity in seconds
-    PROG_START          // Program start address
+    ULP_MODE_CONTINUOUS, // Busy loop sampling every ~25us, ULP always awake
+    ULP_MODE_TIMER       // One sample per ULP timer wakeup, ULP halts in between
 };
 
-// ESP32-S3 specific GPIO mappings
-#define SDA_GPIO GPIO_NUM_3 // GPIO3 for SDA
+// Motion event read back from the ULP ring buffer
+struct ULPMotionEvent
+{
+    uint32_t window; // 1-based window tick at which the motion state changed
+    bool onset;      // true = motion started, false = motion stopped
+};
+
+#define ULP_DEFAULT_SAMPLE_HZ 20 // Timer mode sample rate
+#define ULP_MIN_SAMPLE_HZ 1
+#define ULP_MAX_SAMPLE_HZ 1000
 
 class ULPManager
 {
@@ -29,18 +38,37 @@ public:
     void start(); // Initialize and start the ULP program
     void stop();  // Stop the ULP program
 
+    // Sampling mode (applied on next start())
+    void setSamplingMode(ULPSamplingMode mode, uint16_t sampleHz = ULP_DEFAULT_SAMPLE_HZ);
+    ULPSamplingMode getSamplingMode() { return _mode; }
+    uint16_t getSampleRate() { return _sampleHz; }
+
     // PIR count methods
     uint16_t getPIRCount();
     void clearPIRCount();
 
-    // Inactivity tracking methods
-    void setInactivityPeriod(uint16_t seconds);
-    uint16_t getInactivityCount();
+    // Inactivity tracking methods (index selects one of ULP_INACTIVITY_THRESHOLDS slots)
+    void setInactivityPeriod(uint16_t seconds, uint8_t index = 0);
+    uint16_t getInactivityCount(uint8_t index = 0);
     uint16_t getInactivityTracker();
     void clearInactivityCounters();
 
+    // Inactive bout statistics, in 1-second windows
+    uint16_t getLongestInactiveBout();
+    uint16_t getInactiveBoutCount();
+
+    // Motion event methods
+    uint16_t readEvents(ULPMotionEvent *events, uint16_t maxEvents); // Oldest first; stay queued...
+    void consumeEvents(uint16_t count, uint16_t dropped); // ...until consumed once they are written
+    bool hasEvents();                   // Unconsumed events or overflow
+    uint16_t getEventOverflow();
+    uint16_t getWindowCount();
+    void clearEvents();
+
 private:
     bool _initialized;
+    ULPSamplingMode _mode;
+    uint16_t _sampleHz;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef ULP_MEMORY_MAP_H
+#define ULP_MEMORY_MAP_H
+
+// RTC_SLOW_MEM word layout shared by the ULP program, ULPManager and the
+// host-side emulator (extras/ulp_emulator). Kept free of ESP-IDF includes so
+// it can be compiled on the host.
+
+// Motion event ring buffer length in words (must be a power of two)
+#ifndef ULP_EVENT_BUFFER_SIZE
+#define ULP_EVENT_BUFFER_SIZE 8
+#endif
+
+// Simultaneous inactivity thresholds, each a {COUNT, TRACKER, PERIOD} slot
+#ifndef ULP_INACTIVITY_THRESHOLDS
+#define ULP_INACTIVITY_THRESHOLDS 3
+#endif
+#define ULP_INACTIVITY_SLOT_WORDS 3
+#define ULP_INACTIVITY_WORD(word, index) ((word) + (index) * ULP_INACTIVITY_SLOT_WORDS)
+
+// Event word layout: bits 0-14 window tick, bit 15 set for offset
+#define ULP_EVENT_TICK_MASK 0x7FFF
+#define ULP_EVENT_OFFSET_BIT 0x8000
+
+enum
+{
+    PIR_COUNT,          // RTC memory location for motion counter
+    INACTIVITY_COUNT,   // Count of times inactivity period was exceeded
+    INACTIVITY_TRACKER, // Current consecutive inactive seconds
+    INACTIVITY_PERIOD,  // Target period for inactivity in seconds
+    // Thresholds 1..N-1 repeat the COUNT/TRACKER/PERIOD slot here
+    BOUT_LENGTH = ULP_INACTIVITY_WORD(INACTIVITY_COUNT, ULP_INACTIVITY_THRESHOLDS), // Current inactive bout in windows
+    LONGEST_BOUT,       // Longest inactive bout in windows
+    BOUT_COUNT,         // Number of inactive bouts started
+    WINDOW_MOTION,      // Timer mode: 1 if any sample in the current window saw motion
+    WINDOW_SAMPLES,     // Timer mode: samples taken so far in the current window
+    SAMPLES_PER_WINDOW, // Timer mode: samples per 1-second window (= wakeup rate in Hz)
+    WINDOW_TICK,        // Windows completed since the ULP was started
+    MOTION_STATE,       // 1 if the last completed window saw motion
+    EVENT_HEAD,         // Events written by the ULP (free-running)
+    EVENT_TAIL,         // Events consumed by the main CPU (free-running)
+    EVENT_OVERFLOW,     // Events dropped because the buffer was full
+    EVENT_BUFFER,       // Start of the motion event ring buffer
+    PROG_START = EVENT_BUFFER + ULP_EVENT_BUFFER_SIZE // Program start address
+};
+
+static_assert((ULP_EVENT_BUFFER_SIZE & (ULP_EVENT_BUFFER_SIZE - 1)) == 0,
+              "ULP_EVENT_BUFFER_SIZE must be a power of two");
+
+#endif
@@ -0,0 +1,374 @@
+#ifndef ULP_PROGRAM_H
+#define ULP_PROGRAM_H
+
+// ULP instruction tables. Requires the ULP macro set to be in scope: on the
+// device that is esp32s3/ulp.h (via ULPManager.h), on the host it is the shim
+// in extras/ulp_emulator/ulp_shim.h. Include from one translation unit only.
+//
+// Programs are assembled at compile time from a ULPProgramConfig: timing is
+// derived from named parameters and disabled features are left out of the
+// table entirely. Every build is checked against CONFIG_ULP_COPROC_RESERVE_MEM.
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include "ULPMemoryMap.h"
+
+// Optional parts of the end-of-window handler. PIR_COUNT is always kept.
+#define ULP_FEATURE_EVENTS (1 << 0)     // Motion onset/offset ring buffer
+#define ULP_FEATURE_INACTIVITY (1 << 1) // Inactivity threshold counters
+#define ULP_FEATURE_BOUTS (1 << 2)      // Longest inactive bout and bout count
+#define ULP_FEATURE_ALL (ULP_FEATURE_EVENTS | ULP_FEATURE_INACTIVITY | ULP_FEATURE_BOUTS)
+
+// ULP-FSM clock (RC_FAST, nominal) and instruction costs in cycles, execute
+// plus fetch. The continuous program sizes its I_DELAY from them so that a
+// sample period includes the loop around it; extras/ulp_emulator charges
+// the same costs.
+#ifndef ULP_CLOCK_HZ
+#define ULP_CLOCK_HZ 17500000
+#endif
+#define ULP_CYCLES_ALU 6    // I_MOVI, I_MOVR, I_ADDI, I_SUBI, I_ANDR, ...
+#define ULP_CYCLES_MEM 8    // I_LD, I_ST, I_RD_REG
+#define ULP_CYCLES_WR_REG 12
+#define ULP_CYCLES_DELAY 6  // Plus the I_DELAY argument
+#define ULP_CYCLES_BRANCH 4 // Taken or not
+#define ULP_CYCLES_HALT 2
+
+struct ULPProgramConfig
+{
+    uint16_t samplePeriodUs; // GPIO3 sample spacing in the continuous program
+    uint16_t windowMs;       // Length of one activity window (inactivity units)
+    uint8_t features;        // ULP_FEATURE_* bits compiled into the programs
+};
+
+// Deployment presets. Inactivity periods and bout lengths count windows, so
+// they are in seconds only while windowMs is 1000.
+constexpr ULPProgramConfig ULP_PRESET_DEFAULT = {25, 1000, ULP_FEATURE_ALL};
+constexpr ULPProgramConfig ULP_PRESET_FAST = {16, 1000, ULP_FEATURE_ALL};   // Brief movements (mice)
+constexpr ULPProgramConfig ULP_PRESET_SLOW = {1000, 1000, ULP_FEATURE_ALL}; // Larger animals
+
+// Build-time selection, e.g. -DULP_PROGRAM_CONFIG=ULP_PRESET_FAST
+#ifndef ULP_PROGRAM_CONFIG
+#define ULP_PROGRAM_CONFIG ULP_PRESET_DEFAULT
+#endif
+
+// A run of table entries plus the number of RTC_SLOW_MEM words they occupy
+// once ulp_process_macros_and_load() has resolved labels and branch macros.
+// The device's ulp_insn_t is a union whose macro entries cannot be told
+// apart at compile time, so the count is written by hand: the host build
+// checks it against the table (ULP_CHECK_WORDS) and ULPManager::start()
+// against the size the loader returns.
+template <size_t N>
+struct ULPBlock
+{
+    std::array<ulp_insn_t, N> insns;
+    size_t words;
+};
+
+template <size_t N>
+constexpr ULPBlock<N> ulpBlock(size_t words, const ulp_insn_t (&insns)[N])
+{
+    ULPBlock<N> block{};
+    for (size_t i = 0; i < N; i++)
+    {
+        block.insns[i] = insns[i];
+    }
+    block.words = words;
+    return block;
+}
+
+template <size_t... Ns>
+constexpr ULPBlock<(Ns + ... + 0)> ulpConcat(const ULPBlock<Ns> &...blocks)
+{
+    ULPBlock<(Ns + ... + 0)> out{};
+    size_t n = 0;
+    (
+        [&]
+        {
+            for (size_t i = 0; i < blocks.insns.size(); i++)
+            {
+                out.insns[n++] = blocks.insns[i];
+            }
+            out.words += blocks.words;
+        }(),
+        ...);
+    return out;
+}
+
+// Keeps a block only when its feature is enabled
+template <bool Enabled, size_t N>
+constexpr auto ulpOptional(const ULPBlock<N> &block)
+{
+    if constexpr (Enabled)
+    {
+        return block;
+    }
+    else
+    {
+        return ULPBlock<0>{};
+    }
+}
+
+#ifdef ULP_SHIM_H
+// Host only: the shim encodes every instruction in one entry, so the declared
+// word counts can be checked against the table itself.
+template <size_t N>
+constexpr size_t ulpResolvedWords(const ULPBlock<N> &block)
+{
+    size_t words = 0;
+    for (size_t i = 0; i < N; i++)
+    {
+        words += (block.insns[i].op != SHIM_LABEL);
+    }
+    return words;
+}
+#define ULP_CHECK_WORDS(program) \
+    static_assert(ulpResolvedWords(program) == (program).words, "ULP block word count is wrong")
+#else
+#define ULP_CHECK_WORDS(program)
+#endif
+
+#define ULP_CHECK_FITS(program)                                                                 \
+    static_assert((PROG_START + (program).words) * sizeof(uint32_t) <= CONFIG_ULP_COPROC_RESERVE_MEM, \
+                  "ULP program and data do not fit CONFIG_ULP_COPROC_RESERVE_MEM")
+
+// End-of-window processing shared by both programs. Entered with R0 = 1 if
+// the window saw motion, 0 otherwise. Clobbers R0-R3 and uses labels 20-39.
+template <uint8_t Features>
+constexpr auto ulpProcessWindow()
+{
+    constexpr bool events = Features & ULP_FEATURE_EVENTS;
+    constexpr bool inactivity = Features & ULP_FEATURE_INACTIVITY;
+    constexpr bool bouts = Features & ULP_FEATURE_BOUTS;
+    constexpr uint32_t slotsEnd = ULP_INACTIVITY_WORD(INACTIVITY_COUNT, ULP_INACTIVITY_THRESHOLDS);
+
+    // Record an event when the motion state changes; leaves R0 = motion flag
+    constexpr auto recordEvent = ulpBlock(31, {
+        I_MOVI(R2, WINDOW_TICK), // Advance window tick
+        I_LD(R1, R2, 0),
+        I_ADDI(R1, R1, 1),
+        I_ST(R1, R2, 0),
+        I_MOVI(R2, MOTION_STATE),
+        I_LD(R1, R2, 0),        // R1 = previous window state
+        I_ST(R0, R2, 0),        // Store current window state
+        I_SUBR(R0, R0, R1),     // R0 = current - previous
+        M_BE(21, 0),            // No change, skip event
+        I_ANDI(R3, R0, 0x8000), // 0xFFFF (offset) sets ULP_EVENT_OFFSET_BIT
+        I_MOVI(R2, EVENT_HEAD),
+        I_LD(R1, R2, 0), // R1 = head
+        I_MOVI(R0, EVENT_TAIL),
+        I_LD(R0, R0, 0),                 // R0 = tail
+        I_SUBR(R0, R1, R0),              // R0 = events pending
+        M_BL(20, ULP_EVENT_BUFFER_SIZE), // Room in buffer, write event
+        I_MOVI(R2, EVENT_OVERFLOW),
+        I_LD(R0, R2, 0), // Buffer full, count dropped event
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R2, 0),
+        M_BX(21),
+        M_LABEL(20),
+        I_MOVI(R0, WINDOW_TICK),
+        I_LD(R0, R0, 0),
+        I_ANDI(R0, R0, ULP_EVENT_TICK_MASK),
+        I_ORR(R0, R0, R3),                         // Event word = tick | offset bit
+        I_ANDI(R3, R1, ULP_EVENT_BUFFER_SIZE - 1), // Slot index
+        I_ST(R0, R3, EVENT_BUFFER),                // Store the event word first...
+        I_ADDI(R0, R1, 1),
+        I_ST(R0, R2, 0), // ...then advance head, so a reader never sees an unwritten slot
+        M_LABEL(21),
+        I_MOVI(R2, MOTION_STATE),
+        I_LD(R0, R2, 0), // Reload current window state
+    });
+
+    constexpr auto countMotion = ulpBlock(5, {
+        M_BE(22, 0), // No motion, handle inactivity tracking
+        I_MOVI(R2, PIR_COUNT),
+        I_LD(R1, R2, 0),   // Load current PIR count
+        I_ADDI(R1, R1, 1), // Increment count
+        I_ST(R1, R2, 0),   // Store updated count
+    });
+
+    // Reset every threshold tracker; leaves R1 = 0, R2 = slotsEnd
+    constexpr auto resetTrackers = ulpBlock(6, {
+        I_MOVI(R1, 0),
+        I_MOVI(R2, INACTIVITY_COUNT),
+        M_LABEL(23),
+        I_ST(R1, R2, 1), // Slot tracker = 0
+        I_ADDI(R2, R2, ULP_INACTIVITY_SLOT_WORDS),
+        I_MOVR(R0, R2),
+        M_BL(23, slotsEnd), // Next slot
+    });
+
+    // BOUT_LENGTH directly follows the slots, so reuse R1/R2 when possible
+    static_assert(BOUT_LENGTH == slotsEnd, "BOUT_LENGTH must follow the inactivity slots");
+    constexpr auto resetBoutAfterTrackers = ulpBlock(1, {
+        I_ST(R1, R2, 0),
+    });
+    constexpr auto resetBout = ulpBlock(3, {
+        I_MOVI(R1, 0),
+        I_MOVI(R2, BOUT_LENGTH),
+        I_ST(R1, R2, 0),
+    });
+
+    constexpr auto endMotion = ulpBlock(1, {
+        M_BX(29),
+        M_LABEL(22),
+    });
+
+    // Bout statistics for a window without motion
+    constexpr auto trackBout = ulpBlock(13, {
+        I_MOVI(R2, BOUT_LENGTH),
+        I_LD(R0, R2, 0),
+        I_ADDI(R0, R0, 1), // Extend current bout
+        I_ST(R0, R2, 0),
+        M_BG(24, 1), // Not the first window of the bout
+        I_LD(R1, R2, BOUT_COUNT - BOUT_LENGTH),
+        I_ADDI(R1, R1, 1), // New bout started
+        I_ST(R1, R2, BOUT_COUNT - BOUT_LENGTH),
+        M_LABEL(24),
+        I_LD(R1, R2, LONGEST_BOUT - BOUT_LENGTH),
+        I_SUBR(R0, R1, R0), // R0 = longest - current, wraps if current is longer
+        M_BL(25, 0x8000),   // Longest still longer or equal
+        I_LD(R0, R2, 0),
+        I_ST(R0, R2, LONGEST_BOUT - BOUT_LENGTH),
+        M_LABEL(25),
+    });
+
+    // One pass over every threshold slot for a window without motion
+    constexpr auto trackInactivity = ulpBlock(15, {
+        I_MOVI(R2, INACTIVITY_COUNT),
+        M_LABEL(26),
+        I_LD(R0, R2, 1),    // Load slot tracker
+        I_ADDI(R0, R0, 1),  // Increment tracker
+        I_ST(R0, R2, 1),    // Store updated tracker
+        I_LD(R1, R2, 2),    // Load slot period
+        I_SUBR(R0, R1, R0), // R0 = period - tracker
+        M_BG(27, 1),        // (period - tracker) > 1, next slot; else count it
+        I_LD(R0, R2, 0),    // Increment slot count then reset tracker
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R2, 0),
+        I_MOVI(R0, 0),
+        I_ST(R0, R2, 1),
+        M_LABEL(27),
+        I_ADDI(R2, R2, ULP_INACTIVITY_SLOT_WORDS),
+        I_MOVR(R0, R2),
+        M_BL(26, slotsEnd), // Next slot
+    });
+
+    constexpr auto end = ulpBlock(0, {
+        M_LABEL(29),
+    });
+
+    return ulpConcat(ulpOptional<events>(recordEvent),
+                     countMotion,
+                     ulpOptional<inactivity>(resetTrackers),
+                     ulpOptional<bouts && inactivity>(resetBoutAfterTrackers),
+                     ulpOptional<bouts && !inactivity>(resetBout),
+                     endMotion,
+                     ulpOptional<bouts>(trackBout),
+                     ulpOptional<inactivity>(trackInactivity),
+                     end);
+}
+
+// Continuous program: samples GPIO3 (PIR trigger, LOW = motion) every
+// samplePeriodUs and processes one window every windowMs without halting.
+// The sampling loop has no data-dependent branch, so every iteration takes
+// loopCycles plus the delay whether or not the PIR is triggered.
+template <ULPProgramConfig Config>
+constexpr auto ulpBuildBusyProgram()
+{
+    constexpr uint32_t iterations = (uint32_t)Config.windowMs * 1000 / Config.samplePeriodUs;
+    constexpr uint32_t periodCycles = ((uint64_t)Config.samplePeriodUs * ULP_CLOCK_HZ + 500000) / 1000000;
+    constexpr uint32_t loopCycles = ULP_CYCLES_MEM +                // I_RD_REG
+                                    ULP_CYCLES_ALU +                // I_ANDR
+                                    ULP_CYCLES_DELAY +              // I_DELAY, besides its argument
+                                    ULP_CYCLES_ALU + ULP_CYCLES_ALU + // I_SUBI, I_MOVR
+                                    ULP_CYCLES_BRANCH;              // M_BG
+    static_assert(Config.samplePeriodUs > 0, "samplePeriodUs must be > 0");
+    static_assert(iterations > 0 && iterations <= 0xFFFF, "windowMs / samplePeriodUs must fit the 16-bit loop counter");
+    static_assert(periodCycles > loopCycles, "samplePeriodUs is shorter than the sampling loop");
+    static_assert(periodCycles - loopCycles <= 0xFFFF, "samplePeriodUs is too long for I_DELAY");
+    constexpr uint32_t delayCycles = periodCycles - loopCycles;
+
+    constexpr auto sample = ulpBlock(10, {
+        I_MOVI(R3, 1), // R3 = quiet flag (0 once a sample in this window saw motion)
+
+        // Start of window
+        M_LABEL(1),
+        I_MOVI(R1, iterations), // Load sampling iteration count
+
+        // Sampling loop: loopCycles + delayCycles per iteration
+        M_LABEL(2),
+        I_RD_REG(RTC_GPIO_IN_REG, 3 + RTC_GPIO_IN_NEXT_S, 3 + RTC_GPIO_IN_NEXT_S),
+        I_ANDR(R3, R3, R0),   // GPIO LOW (motion) clears the quiet flag
+        I_DELAY(delayCycles), // Rest of the sample period
+        I_SUBI(R1, R1, 1),    // Decrement iteration counter
+        I_MOVR(R0, R1),       // Move counter to R0 for comparison
+        M_BG(2, 0),           // Samples left in this window
+
+        // Window complete - process results
+        I_MOVI(R0, 1),
+        I_SUBR(R0, R0, R3), // R0 = motion flag for final processing
+    });
+
+    constexpr auto loop = ulpBlock(2, {
+        I_MOVI(R3, 1), // Reset quiet flag for next window
+        M_BX(1),       // Jump back to start of window
+    });
+
+    constexpr auto program = ulpConcat(sample, ulpProcessWindow<Config.features>(), loop);
+    ULP_CHECK_WORDS(program);
+    ULP_CHECK_FITS(program);
+    return program;
+}
+
+// Timer-driven program: runs one GPIO3 sample per ULP timer wakeup and
+// halts. ulp_set_wakeup_period() sets the sample rate; every
+// SAMPLES_PER_WINDOW samples form one window with the same PIR_COUNT and
+// inactivity semantics as the continuous program. State lives in RTC memory
+// because registers do not survive I_HALT.
+template <ULPProgramConfig Config>
+constexpr auto ulpBuildTimerProgram()
+{
+    constexpr auto sample = ulpBlock(19, {
+        // Take one sample
+        I_RD_REG(RTC_GPIO_IN_REG, 3 + RTC_GPIO_IN_NEXT_S, 3 + RTC_GPIO_IN_NEXT_S),
+        M_BG(1, 0),                // If GPIO HIGH (no motion), skip flag update
+        I_MOVI(R1, WINDOW_MOTION), // Set motion flag for this window
+        I_MOVI(R0, 1),
+        I_ST(R0, R1, 0),
+
+        // Count samples until the window is complete
+        M_LABEL(1),
+        I_MOVI(R1, WINDOW_SAMPLES),
+        I_LD(R0, R1, 0),                // Load samples taken in this window
+        I_ADDI(R0, R0, 1),              // Count this sample
+        I_ST(R0, R1, 0),                // Store updated sample count
+        I_MOVI(R2, SAMPLES_PER_WINDOW), // Load window length
+        I_LD(R2, R2, 0),
+        I_SUBR(R0, R2, R0), // R0 = samples per window - samples taken
+        M_BG(10, 0),        // Window not complete yet, halt until next wakeup
+
+        // Window complete - process results
+        I_MOVI(R0, 0), // Reset sample count (R1 still holds WINDOW_SAMPLES)
+        I_ST(R0, R1, 0),
+        I_MOVI(R1, WINDOW_MOTION),
+        I_LD(R0, R1, 0), // Load motion flag
+        I_MOVI(R2, 0),   // Clear motion flag for next window
+        I_ST(R2, R1, 0),
+    });
+
+    constexpr auto halt = ulpBlock(1, {
+        M_LABEL(10),
+        I_HALT(), // Sleep until the next ULP timer wakeup
+    });
+
+    constexpr auto program = ulpConcat(sample, ulpProcessWindow<Config.features>(), halt);
+    ULP_CHECK_WORDS(program);
+    ULP_CHECK_FITS(program);
+    return program;
+}
+
+// Programs loaded by ULPManager
+static constexpr auto ulp_program = ulpBuildBusyProgram<ULP_PROGRAM_CONFIG>();
+static constexpr auto ulp_timer_program = ulpBuildTimerProgram<ULP_PROGRAM_CONFIG>();
+
+#endif
@@ -1,5 +1,5 @@
 #include "ZDP323.h"
-#define DEBUG 0 // Set to 0 to disable debug output
+#include "BEAMDebug.h"
 
 ZDP323::ZDP323(uint8_t i2cAddress)
     : _i2cAddress(i2cAddress), _initialized(false)
@@ -13,18 +13,18 @@ ZDP323::ZDP323(uint8_t i2cAddress)
 
 bool ZDP323::begin(TwoWire &wirePort, bool isWakeFromSleep)
 {
-    Serial.println("  ZDP323: begin");
+    BEAM_VERBOSEF(PIR, "  ZDP323: begin\n");
     _wire = &wirePort;
     _wire->setTimeout(3000);
 
     // If waking from sleep, we need to disable trigger mode first
     if (isWakeFromSleep)
     {
-        Serial.println("  ZDP323: disabling trigger mode");
+        BEAM_VERBOSEF(PIR, "  ZDP323: disabling trigger mode\n");
         _config.trigom = ZDP323_CONFIG_TRIGOM_DISABLED;
         if (!writeConfig())
         {
-            Serial.println("  ZDP323: failed to disable trigger mode");
+            BEAM_ERRORF(PIR, "  ZDP323: failed to disable trigger mode\n");
             return false;
         }
         _initialized = true;
@@ -35,7 +35,7 @@ bool ZDP323::begin(TwoWire &wirePort, bool isWakeFromSleep)
     delay(500); // Only delay on first power-up
 
     // Initial configuration with maximum threshold and trigger mode disabled
-    Serial.println("  ZDP323: initial config");
+    BEAM_VERBOSEF(PIR, "  ZDP323: initial config\n");
     _config.detlvl = 0xFF; // Maximum threshold during stabilization
     _config.trigom = ZDP323_CONFIG_TRIGOM_DISABLED;
     _config.fstep = ZDP323_CONFIG_FSTEP_3;        // Step 2 (11)
@@ -54,7 +54,7 @@ bool ZDP323::begin(TwoWire &wirePort, bool isWakeFromSleep)
             configFailures++;
             if (configFailures >= maxConfigFailures)
             {
-                Serial.printf("  ZDP323: config write failed (%d/%d)\n", configFailures, maxConfigFailures);
+                BEAM_ERRORF(PIR, "  ZDP323: config write failed (%d/%d)\n", configFailures, maxConfigFailures);
                 return false;
             }
             delay(100);
@@ -74,7 +74,7 @@ bool ZDP323::begin(TwoWire &wirePort, bool isWakeFromSleep)
 
         if (abs(peakHold) < halfThreshold)
         {
-            Serial.println("  ZDP323: stability achieved");
+            BEAM_VERBOSEF(PIR, "  ZDP323: stability achieved\n");
             break; // Stability achieved
         }
 
@@ -84,21 +84,21 @@ bool ZDP323::begin(TwoWire &wirePort, bool isWakeFromSleep)
 
     if (attempts >= maxAttempts)
     {
-        Serial.println("  ZDP323: failed to achieve stability");
+        BEAM_ERRORF(PIR, "  ZDP323: failed to achieve stability\n");
         return false;
     }
 
     // Write final configuration with desired threshold (trigger mode still disabled)
-    Serial.println("  ZDP323: writing final config");
+    BEAM_VERBOSEF(PIR, "  ZDP323: writing final config\n");
     _config.detlvl = ZDP323_CONFIG_DETLVL_DEFAULT;
     if (!writeConfig())
     {
-        Serial.println("  ZDP323: final config write failed");
+        BEAM_ERRORF(PIR, "  ZDP323: final config write failed\n");
         return false;
     }
 
     _initialized = true;
-    Serial.println("  ZDP323: initialization complete");
+    BEAM_VERBOSEF(PIR, "  ZDP323: initialization complete\n");
     return true;
 }
 
@@ -118,12 +118,15 @@ bool ZDP323::writeConfig()
     // Byte 5: Lower bit of DETLVL (bit 15) and reserved bits
     data[5] = (_config.detlvl & 0x01) << 7;
 
-    Serial.printf("  I2C write: addr=0x%02X, data=[", _i2cAddress);
-    for (int i = 0; i < 7; i++)
+    if (BEAM_DEBUG_ENABLED(BEAM_DEBUG_TRACE, PIR))
     {
-        Serial.printf("0x%02X%s", data[i], i < 6 ? "," : "");
+        BEAM_TRACEF(PIR, "  I2C write: addr=0x%02X, data=[", _i2cAddress);
+        for (int i = 0; i < 7; i++)
+        {
+            BEAM_TRACEF(PIR, "0x%02X%s", data[i], i < 6 ? "," : "");
+        }
+        BEAM_TRACEF(PIR, "]\n");
     }
-    Serial.println("]");
 
     // Start transmission
     _wire->beginTransmission(_i2cAddress);
@@ -132,11 +135,11 @@ bool ZDP323::writeConfig()
 
     if (result != 0)
     {
-        Serial.printf("  I2C error: code=%d (%s)\n", result,
-                      result == 1 ? "data too long" : result == 2 ? "NACK on addr"
-                                                  : result == 3   ? "NACK on data"
-                                                  : result == 4   ? "other error"
-                                                                  : "unknown");
+        BEAM_ERRORF(PIR, "  I2C error: code=%d (%s)\n", result,
+                         result == 1 ? "data too long" : result == 2 ? "NACK on addr"
+                                                     : result == 3   ? "NACK on data"
+                                                     : result == 4   ? "other error"
+                                                                     : "unknown");
     }
 
     return result == 0;
@@ -146,24 +149,24 @@ bool ZDP323::readPeakHold(int16_t *peakHold)
 {
     if (!peakHold)
     {
-        Serial.println("  Peak hold: null pointer");
+        BEAM_ERRORF(PIR, "  Peak hold: null pointer\n");
         return false;
     }
 
-    Serial.printf("  I2C read: requesting 2 bytes from addr=0x%02X\n", _i2cAddress);
+    BEAM_TRACEF(PIR, "  I2C read: requesting 2 bytes from addr=0x%02X\n", _i2cAddress);
 
     // Request two bytes from the device
     uint8_t bytesRead = _wire->requestFrom(_i2cAddress, (uint8_t)2);
     if (bytesRead != 2)
     {
-        Serial.printf("  I2C read error: requested 2 bytes, got %d\n", bytesRead);
+        BEAM_ERRORF(PIR, "  I2C read error: requested 2 bytes, got %d\n", bytesRead);
         return false;
     }
 
     // Read the two bytes
     uint8_t msb = _wire->read();
     uint8_t lsb = _wire->read();
-    Serial.printf("  I2C read: msb=0x%02X, lsb=0x%02X\n", msb, lsb);
+    BEAM_TRACEF(PIR, "  I2C read: msb=0x%02X, lsb=0x%02X\n", msb, lsb);
 
     // Peak hold is a 12-bit signed value
     *peakHold = ((int16_t)(msb & 0x0F) << 8) | lsb;
@@ -204,18 +207,18 @@ void ZDP323::setFilterType(uint8_t type)
 
 bool ZDP323::enableTriggerMode()
 {
-    Serial.println("  ZDP323: enabling trigger mode");
+    BEAM_VERBOSEF(PIR, "  ZDP323: enabling trigger mode\n");
     _config.trigom = ZDP323_CONFIG_TRIGOM_ENABLED;
     bool success = writeConfig();
-    Serial.printf("  ZDP323: trigger mode enable %s\n", success ? "OK" : "FAILED");
+    BEAM_VERBOSEF(PIR, "  ZDP323: trigger mode enable %s\n", success ? "OK" : "FAILED");
     return success;
 }
 
 bool ZDP323::disableTriggerMode()
 {
-    Serial.println("  ZDP323: disabling trigger mode");
+    BEAM_VERBOSEF(PIR, "  ZDP323: disabling trigger mode\n");
     _config.trigom = ZDP323_CONFIG_TRIGOM_DISABLED;
     bool success = writeConfig();
-    Serial.printf("  ZDP323: trigger mode disable %s\n", success ? "OK" : "FAILED");
+    BEAM_VERBOSEF(PIR, "  ZDP323: trigger mode disable %s\n", success ? "OK" : "FAILED");
     return success;
 }